@@ -33,9 +33,10 @@ namespace ingen {
    A generic typed data container.
 
    An Atom holds a value with some type and size, both specified by a uint32_t.
-   Values with size less than sizeof(void*) are stored inline: no dynamic
-   allocation occurs so Atoms may be created in hard real-time threads.
-   Otherwise, if the size is larger than sizeof(void*), the value will be
+   Values with size up to inline_size are stored inline: no dynamic allocation
+   occurs so Atoms may be created in hard real-time threads.  This is large
+   enough for numbers, most URIs and short strings, and small float vectors.
+   Otherwise, if the size is larger than inline_size, the value will be
    dynamically allocated in a separate chunk of memory.
 
    In either case, the data is stored in a binary compatible format to LV2_Atom
@@ -43,6 +44,9 @@ namespace ingen {
 */
 class INGEN_API Atom {
 public:
+	/** Maximum size of a value stored inline, so an Atom is 64 bytes. */
+	static const uint32_t inline_size = 64 - sizeof(LV2_Atom);
+
 	Atom() noexcept  { _atom.size = 0; _atom.type = 0; _body.ptr = nullptr; }
 	~Atom() { dealloc(); }
 
@@ -60,6 +64,8 @@ public:
 		}
 		if (body) {
 			memcpy(get_body(), body, size);
+		} else {
+			memset(get_body(), 0, size);
 		}
 	}
 
@@ -70,13 +76,24 @@ public:
 			_body.ptr = (LV2_Atom*)malloc(sizeof(LV2_Atom) + _atom.size);
 			memcpy(_body.ptr, copy._body.ptr, sizeof(LV2_Atom) + _atom.size);
 		} else {
-			_body.val = copy._body.val;
+			memcpy(_body.buf, copy._body.buf, _atom.size);
 		}
 	}
 
+	Atom(Atom&& other) noexcept
+		: _atom(other._atom)
+	{
+		take(other);
+	}
+
 	Atom& operator=(const Atom& other) {
 		if (&other == this) {
 			return *this;
+		} else if (is_reference() && _atom.size == other._atom.size) {
+			// Same size, reuse existing allocation
+			memcpy(_body.ptr, other._body.ptr, sizeof(LV2_Atom) + _atom.size);
+			_atom = other._atom;
+			return *this;
 		}
 		dealloc();
 		_atom = other._atom;
@@ -84,7 +101,16 @@ public:
 			_body.ptr = (LV2_Atom*)malloc(sizeof(LV2_Atom) + _atom.size);
 			memcpy(_body.ptr, other._body.ptr, sizeof(LV2_Atom) + _atom.size);
 		} else {
-			_body.val = other._body.val;
+			memcpy(_body.buf, other._body.buf, _atom.size);
+		}
+		return *this;
+	}
+
+	Atom& operator=(Atom&& other) noexcept {
+		if (&other != this) {
+			dealloc();
+			_atom = other._atom;
+			take(other);
 		}
 		return *this;
 	}
@@ -94,9 +120,7 @@ public:
 		    _atom.size != other._atom.size) {
 			return false;
 		}
-		return is_reference()
-			? !memcmp(_body.ptr, other._body.ptr, sizeof(LV2_Atom) + _atom.size)
-			: _body.val == other._body.val;
+		return !memcmp(get_body(), other.get_body(), _atom.size);
 	}
 
 	inline bool operator!=(const Atom& other) const {
@@ -106,24 +130,22 @@ public:
 	inline bool operator<(const Atom& other) const {
 		if (_atom.type == other._atom.type) {
 			const uint32_t min_size = std::min(_atom.size, other._atom.size);
-			const int cmp           = is_reference()
-				? memcmp(_body.ptr, other._body.ptr, min_size)
-				: memcmp(&_body.val, &other._body.val, min_size);
+			const int      cmp = memcmp(get_body(), other.get_body(), min_size);
 			return cmp < 0 || (cmp == 0 && _atom.size < other._atom.size);
 		}
 		return type() < other.type();
 	}
 
-	/** Like assignment, but only works for value atoms (not references).
+	/** Like assignment, but only works for inline values (not references).
 	 * Always real-time safe.
 	 * @return true iff set succeeded.
 	 */
 	inline bool set_rt(const Atom& other) {
-		if (is_reference()) {
+		if (is_reference() || other.is_reference()) {
 			return false;
 		} else {
-			_atom     = other._atom;
-			_body.val = other._body.val;
+			_atom = other._atom;
+			memcpy(_body.buf, other._body.buf, _atom.size);
 			return true;
 		}
 	}
@@ -133,11 +155,11 @@ public:
 	inline bool     is_valid() const { return _atom.type; }
 
 	inline const void* get_body() const {
-		return is_reference() ? (void*)(_body.ptr + 1) : &_body.val;
+		return is_reference() ? (void*)(_body.ptr + 1) : _body.buf;
 	}
 
 	inline void* get_body() {
-		return is_reference() ? (void*)(_body.ptr + 1) : &_body.val;
+		return is_reference() ? (void*)(_body.ptr + 1) : _body.buf;
 	}
 
 	template <typename T> const T& get() const {
@@ -161,14 +183,26 @@ private:
 		}
 	}
 
+	/** Take the value of `other` (with the same header) and clear it. */
+	inline void take(Atom& other) {
+		if (is_reference()) {
+			_body.ptr = other._body.ptr;
+		} else {
+			memcpy(_body.buf, other._body.buf, _atom.size);
+		}
+		other._atom.size = 0;
+		other._atom.type = 0;
+		other._body.ptr  = nullptr;
+	}
+
 	/** Return true iff this value is dynamically allocated. */
 	inline bool is_reference() const {
-		return _atom.size > sizeof(_body.val);
+		return _atom.size > inline_size;
 	}
 
 	LV2_Atom _atom;
 	union {
-		intptr_t  val;
+		uint8_t   buf[inline_size];
 		LV2_Atom* ptr;
 	} _body;
 };
@@ -71,6 +71,7 @@ private:
 	void forge_arc(const Raul::Path& tail, const Raul::Path& head);
 	void forge_request(LV2_Atom_Forge_Frame* frame, LV2_URID type, int32_t id);
 	void forge_context(Resource::Graph ctx);
+	void forge_time(int64_t time);
 
 	void finish_msg();
 
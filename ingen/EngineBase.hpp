@@ -74,6 +74,8 @@ public:
 
 	/**
 	   Return true iff events are waiting to be processed.
+
+	   Events that are scheduled for a future time are not counted.
 	*/
 	virtual bool pending_events() const = 0;
 
@@ -81,7 +83,8 @@ public:
 	   Flush any pending events.
 
 	   This function is only safe to call in sequential contexts, and runs both
-	   process thread and main iterations in lock-step.
+	   process thread and main iterations in lock-step.  Events scheduled up to
+	   one second ahead are flushed as well, by running enough blocks.
 
 	   @param sleep_ms Interval in milliseconds to sleep between each block.
 	*/
@@ -129,6 +132,14 @@ public:
 	*/
 	virtual bool main_iteration() = 0;
 
+	/**
+	   Request that the execution trace is written, if tracing is enabled.
+
+	   This simply sets a flag, so it is safe to call from a signal handler.
+	   The trace is written in the next call to main_iteration().
+	*/
+	virtual void request_trace() = 0;
+
 	/**
 	   Register a client to receive updates about engine changes.
 	*/
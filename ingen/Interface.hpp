@@ -74,17 +74,19 @@ public:
 
 	inline void put(const URI&        uri,
 	                const Properties& properties,
-	                Resource::Graph   ctx = Resource::Graph::DEFAULT)
+	                Resource::Graph   ctx  = Resource::Graph::DEFAULT,
+	                int64_t           time = 0)
 	{
-		message(Put{_seq++, uri, properties, ctx});
+		message(Put{_seq++, uri, properties, ctx, time});
 	}
 
 	inline void delta(const URI&        uri,
 	                  const Properties& remove,
 	                  const Properties& add,
-	                  Resource::Graph   ctx = Resource::Graph::DEFAULT)
+	                  Resource::Graph   ctx  = Resource::Graph::DEFAULT,
+	                  int64_t           time = 0)
 	{
-		message(Delta{_seq++, uri, remove, add, ctx});
+		message(Delta{_seq++, uri, remove, add, ctx, time});
 	}
 
 	inline void copy(const URI& old_uri, const URI& new_uri)
@@ -117,16 +119,20 @@ public:
 	inline void set_property(const URI&      subject,
 	                         const URI&      predicate,
 	                         const Atom&     value,
-	                         Resource::Graph ctx = Resource::Graph::DEFAULT)
+	                         Resource::Graph ctx  = Resource::Graph::DEFAULT,
+	                         int64_t         time = 0)
 	{
-		message(SetProperty{_seq++, subject, predicate, value, ctx});
+		message(SetProperty{_seq++, subject, predicate, value, ctx, time});
 	}
 
 	inline void undo() { message(Undo{_seq++}); }
 
 	inline void redo() { message(Redo{_seq++}); }
 
-	inline void get(const URI& uri) { message(Get{_seq++, uri}); }
+	inline void get(const URI& uri, bool shallow = false)
+	{
+		message(Get{_seq++, uri, shallow});
+	}
 
 	inline void response(int32_t id, Status status, const std::string& subject)
 	{
@@ -67,6 +67,7 @@ struct Delta
 	Properties      remove;
 	Properties      add;
 	Resource::Graph ctx;
+	int64_t         time;  ///< Frame to apply at, or zero for immediately
 };
 
 struct Disconnect
@@ -93,6 +94,7 @@ struct Get
 {
 	int32_t seq;
 	URI     subject;
+	bool    shallow;  ///< Only describe a graph's ports and blocks
 };
 
 struct Move
@@ -108,6 +110,7 @@ struct Put
 	URI             uri;
 	Properties      properties;
 	Resource::Graph ctx;
+	int64_t         time;  ///< Frame to apply at, or zero for immediately
 };
 
 struct Redo
@@ -129,6 +132,7 @@ struct SetProperty
 	URI             predicate;
 	Atom            value;
 	Resource::Graph ctx;
+	int64_t         time;  ///< Frame to apply at, or zero for immediately
 };
 
 struct Undo
@@ -40,6 +40,11 @@ public:
 		, _ctx(ctx)
 	{}
 
+	Property(Atom&& atom, Graph ctx=Graph::DEFAULT)
+		: Atom(std::move(atom))
+		, _ctx(ctx)
+	{}
+
 	Property(const URIs::Quark& quark, Graph ctx=Graph::DEFAULT)
 		: Atom(quark.urid)
 		, _ctx(ctx)
@@ -58,6 +63,10 @@ public:
 
 	Properties() = default;
 	Properties(const Properties& copy) = default;
+	Properties(Properties&& other) = default;
+
+	Properties& operator=(const Properties& other) = default;
+	Properties& operator=(Properties&& other) = default;
 
 	Properties(std::initializer_list<value_type> l)
 		: std::multimap<URI, Property>(l)
@@ -69,6 +78,12 @@ public:
 		emplace(key, Property(value, ctx));
 	}
 
+	void put(const URI& key,
+	         Atom&&     value,
+	         Graph      ctx = Graph::DEFAULT) {
+		emplace(key, Property(std::move(value), ctx));
+	}
+
 	void put(const URI&         key,
 	         const URIs::Quark& value,
 	         Graph              ctx = Graph::DEFAULT) {
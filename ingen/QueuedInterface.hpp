@@ -17,35 +17,120 @@
 #ifndef INGEN_ENGINE_QUEUEDINTERFACE_HPP
 #define INGEN_ENGINE_QUEUEDINTERFACE_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
 #include <mutex>
+#include <utility>
 #include <vector>
 
+#include <boost/variant/get.hpp>
+
 #include "ingen/Interface.hpp"
 #include "ingen/Message.hpp"
+#include "lv2/urid/urid.h"
 
 namespace ingen {
 
 /** Stores all messages and emits them to a sink on demand.
  *
  * This can be used to make an interface thread-safe.
+ *
+ * Property updates can be coalesced, so that only the latest value of a
+ * coalesced predicate is emitted for each subject, and if the queue is full,
+ * updates of droppable predicates are discarded.  Only values of a given type
+ * are coalesced, so, for example, peak levels can be merged while events sent
+ * to plugin UIs with the same predicate are not.  Updates are only merged
+ * within runs of SetProperty messages, so they are never moved across other
+ * messages like a Put or Del of the same object.
  */
 class QueuedInterface : public Interface
 {
 public:
-	explicit QueuedInterface(SPtr<Interface> sink) : _sink(std::move(sink)) {}
+	/** Counts of updates that were never emitted. */
+	struct Stats {
+		uint64_t merged  = 0;  ///< Replaced by a later update
+		uint64_t dropped = 0;  ///< Discarded because the queue was full
+	};
+
+	explicit QueuedInterface(SPtr<Interface> sink)
+		: _sink(std::move(sink))
+		, _capacity(std::numeric_limits<size_t>::max())
+	{}
 
 	URI uri() const override { return URI("ingen:/QueuedInterface"); }
 
+	/** Coalesce updates of `predicate` with values of type `value_type`.
+	 *
+	 * If `droppable` is true, these updates are discarded when the queue is
+	 * full.
+	 */
+	void coalesce(const URI& predicate, LV2_URID value_type, bool droppable) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_rules[predicate] = Rule{value_type, droppable};
+	}
+
+	/** Set the queue length at which droppable updates are discarded. */
+	void set_capacity(size_t capacity) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_capacity = capacity;
+	}
+
 	void message(const Message& message) override {
 		std::lock_guard<std::mutex> lock(_mutex);
+
+		const SetProperty* const set = boost::get<SetProperty>(&message);
+		if (!set) {
+			_latest.clear();  // Do not merge updates across this message
+		} else {
+			const auto r = _rules.find(set->predicate);
+			if (r != _rules.end() && set->value.type() == r->second.type) {
+				const Key  key(set->subject, set->predicate);
+				const auto i = _latest.find(key);
+				if (i != _latest.end()) {
+					_messages[i->second] = message;
+					++_stats.merged;
+					return;
+				} else if (r->second.droppable &&
+				           _messages.size() >= _capacity) {
+					++_stats.dropped;
+					return;
+				}
+
+				_latest.emplace(key, _messages.size());
+			}
+		}
+
 		_messages.emplace_back(message);
 	}
 
-	void emit() {
+	/** Emit queued messages to the sink.
+	 *
+	 * At most `max_messages` are emitted, the rest remain queued.
+	 */
+	void emit(size_t max_messages = std::numeric_limits<size_t>::max()) {
 		std::vector<Message> messages;
 		{
 			std::lock_guard<std::mutex> lock(_mutex);
-			_messages.swap(messages);
+			if (_messages.size() <= max_messages) {
+				_messages.swap(messages);
+				_latest.clear();
+			} else {
+				const auto split = _messages.begin() + max_messages;
+				messages.assign(std::make_move_iterator(_messages.begin()),
+				                std::make_move_iterator(split));
+				_messages.erase(_messages.begin(), split);
+
+				// Shift the positions of updates that are still queued
+				for (auto i = _latest.begin(); i != _latest.end();) {
+					if (i->second < max_messages) {
+						i = _latest.erase(i);
+					} else {
+						(i++)->second -= max_messages;
+					}
+				}
+			}
 		}
 
 		for (const auto& i : messages) {
@@ -53,12 +138,34 @@ public:
 		}
 	}
 
+	/** Return the number of messages waiting to be emitted. */
+	size_t size() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _messages.size();
+	}
+
+	Stats stats() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _stats;
+	}
+
 	const SPtr<Interface>& sink() const { return _sink; }
 
 private:
-	std::mutex           _mutex;
-	SPtr<Interface>      _sink;
-	std::vector<Message> _messages;
+	struct Rule {
+		LV2_URID type;
+		bool     droppable;
+	};
+
+	typedef std::pair<URI, URI> Key;  ///< Subject and predicate
+
+	std::mutex            _mutex;
+	SPtr<Interface>       _sink;
+	std::vector<Message>  _messages;
+	std::map<URI, Rule>   _rules;   ///< Coalescing rules by predicate
+	std::map<Key, size_t> _latest;  ///< Position of last update for key
+	size_t                _capacity;
+	Stats                 _stats;
 };
 
 } // namespace ingen
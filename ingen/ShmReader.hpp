@@ -0,0 +1,70 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_SHMREADER_HPP
+#define INGEN_SHMREADER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "ingen/AtomReader.hpp"
+#include "ingen/ShmSegment.hpp"
+#include "ingen/ingen.h"
+#include "ingen/types.hpp"
+
+namespace ingen {
+
+class Interface;
+class World;
+
+/** Calls Interface methods based on atom messages from a shared memory ring.
+ *
+ * The reader runs its own thread, which waits for messages until the ring is
+ * closed or the reader is destroyed.
+ *
+ * @ingroup IngenShared
+ */
+class INGEN_API ShmReader
+{
+public:
+	ShmReader(World&           world,
+	          Interface&       iface,
+	          SPtr<ShmSegment> segment,
+	          ShmRing&         ring);
+
+	~ShmReader();
+
+private:
+	void run();
+	/** Process a record, or return false if it is invalid. */
+	bool process(LV2_Atom* record);
+
+	World&                _world;
+	SPtr<ShmSegment>      _segment;
+	ShmRing&              _ring;
+	AtomReader            _reader;
+	URIDRewriter          _rewriter;
+	std::vector<LV2_URID> _urids;  ///< Local URIDs, by writer URID
+	std::vector<uint64_t> _buf;
+	std::atomic<bool>     _exit_flag;
+	std::thread           _thread;
+};
+
+}  // namespace ingen
+
+#endif  // INGEN_SHMREADER_HPP
@@ -0,0 +1,175 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_SHMSEGMENT_HPP
+#define INGEN_SHMSEGMENT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ingen/ingen.h"
+#include "ingen/types.hpp"
+#include "lv2/atom/atom.h"
+#include "lv2/urid/urid.h"
+
+namespace ingen {
+
+class URIMap;
+
+/** A single-reader single-writer ring of atoms in shared memory.
+ *
+ * The ring state is stored in the shared segment, so the reader and writer
+ * may be in different processes.  Reading and writing never block or make
+ * system calls, except to wake a peer that is waiting for the ring to change.
+ *
+ * @ingroup IngenShared
+ */
+class INGEN_API ShmRing
+{
+public:
+	/** The state of a ring, which lives in shared memory. */
+	struct alignas(64) State {
+		std::atomic<uint32_t> write_head;
+		std::atomic<uint32_t> read_head;
+		std::atomic<uint32_t> seq;        ///< Incremented on every change
+		std::atomic<uint32_t> n_waiters;  ///< Number of threads in wait()
+		std::atomic<uint32_t> closed;     ///< Non-zero after close()
+	};
+
+	ShmRing(State* state, uint8_t* buf, uint32_t size);
+
+	/** Return the size of the largest record that fits in the ring. */
+	uint32_t capacity() const { return _size - 1; }
+
+	uint32_t read_space() const;
+	uint32_t write_space() const;
+
+	/** Write a complete atom, or return false if there is not enough space. */
+	bool write(const LV2_Atom* atom);
+
+	/** Read the next atom into `buf`, or return false if the ring is empty.
+	 *
+	 * If the next record is invalid, the ring is closed and false is returned.
+	 */
+	bool read(std::vector<uint64_t>& buf);
+
+	/** Return the current change count, to pass to wait(). */
+	uint32_t seq() const { return _state->seq.load(); }
+
+	/** Wait until the ring has changed since `seq`, or `timeout_ms` passes. */
+	void wait(uint32_t seq, int timeout_ms);
+
+	/** Close the ring, waking any threads that are waiting for it. */
+	void close();
+
+	bool closed() const { return _state->closed.load(); }
+
+private:
+	void copy_in(uint32_t offset, const void* src, uint32_t size);
+	void copy_out(uint32_t offset, void* dst, uint32_t size) const;
+	void notify();
+
+	State* const   _state;
+	uint8_t* const _buf;
+	const uint32_t _size;
+	const uint32_t _size_mask;
+};
+
+/** A shared memory segment for exchanging atoms with a local client.
+ *
+ * A segment contains a ring for messages to the engine and a ring for messages
+ * to the client.  The client creates the segment and tells the engine its name
+ * over an existing connection, then both sides map it.
+ *
+ * @ingroup IngenShared
+ */
+class INGEN_API ShmSegment
+{
+public:
+	/** Create and map a new segment, with rings of at least `ring_size`. */
+	static UPtr<ShmSegment> create(const std::string& name, uint32_t ring_size);
+
+	/** Map an existing segment created by create(). */
+	static UPtr<ShmSegment> open(const std::string& name);
+
+	~ShmSegment();
+
+	/** Remove the name of the segment, which stays mapped until destroyed. */
+	void unlink();
+
+	/** Close both rings, waking any threads waiting for them. */
+	void close();
+
+	const std::string& name() const { return _name; }
+
+	ShmRing& to_engine() { return _to_engine; }
+	ShmRing& to_client() { return _to_client; }
+
+private:
+	struct Header;
+
+	ShmSegment(std::string name, void* mem, size_t size);
+
+	const std::string _name;
+	void* const       _mem;
+	const size_t      _size;
+	Header* const     _header;
+	ShmRing           _to_engine;
+	ShmRing           _to_client;
+	bool              _linked;
+};
+
+/** Rewrites every URID in an atom, including the types of atoms.
+ *
+ * URIDs are only meaningful to the process that mapped them, so atoms sent
+ * through shared memory must have their URIDs translated by the reader.
+ *
+ * @ingroup IngenShared
+ */
+class INGEN_API URIDRewriter
+{
+public:
+	using Func = std::function<LV2_URID(LV2_URID)>;
+
+	explicit URIDRewriter(URIMap& map);
+
+	/** Replace every URID `u` in `atom` with `func(u)`.
+	 *
+	 * The type of each atom is replaced before it is inspected, so `func` must
+	 * return URIDs in the local map.  Every nested atom is checked to fit
+	 * within its parent, and `atom` within `size` bytes, before it is touched.
+	 *
+	 * @return False if the atom is malformed, in which case it may be
+	 * partially rewritten and must be discarded.
+	 */
+	bool rewrite(LV2_Atom* atom, uint32_t size, const Func& func) const;
+
+private:
+	const LV2_URID _atom_Literal;
+	const LV2_URID _atom_Object;
+	const LV2_URID _atom_Sequence;
+	const LV2_URID _atom_Tuple;
+	const LV2_URID _atom_URID;
+	const LV2_URID _atom_Vector;
+};
+
+} // namespace ingen
+
+#endif // INGEN_SHMSEGMENT_HPP
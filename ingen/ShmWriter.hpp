@@ -0,0 +1,75 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_SHMWRITER_HPP
+#define INGEN_SHMWRITER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "ingen/AtomSink.hpp"
+#include "ingen/AtomWriter.hpp"
+#include "ingen/ShmSegment.hpp"
+#include "ingen/URI.hpp"
+#include "ingen/ingen.h"
+#include "ingen/types.hpp"
+
+namespace ingen {
+
+class Log;
+class URIMap;
+class URIs;
+
+/** An Interface that writes atom messages to a shared memory ring.
+ *
+ * Before a message is written, the URI of every URID in it that the reader
+ * has not seen yet is written, so the reader can map them (see ShmReader).
+ * If the ring is full, writing blocks until the reader makes space or the
+ * ring is closed.
+ *
+ * @ingroup IngenShared
+ */
+class INGEN_API ShmWriter : public AtomSink, public AtomWriter
+{
+public:
+	ShmWriter(URIMap&          map,
+	          URIs&            uris,
+	          Log&             log,
+	          const URI&       uri,
+	          SPtr<ShmSegment> segment,
+	          ShmRing&         ring);
+
+	URI uri() const override { return _uri; }
+
+	bool write(const LV2_Atom* msg, int32_t default_id=0) override;
+
+private:
+	bool write_record(const LV2_Atom* record);
+	bool write_urid(LV2_URID urid);
+
+	URIMap&               _uri_map;
+	Log&                  _log;
+	const URI             _uri;
+	SPtr<ShmSegment>      _segment;
+	ShmRing&              _ring;
+	URIDRewriter          _rewriter;
+	std::vector<bool>     _sent;  ///< URIDs the reader knows, by URID
+	std::vector<uint64_t> _buf;
+};
+
+}  // namespace ingen
+
+#endif  // INGEN_SHMWRITER_HPP
@@ -18,34 +18,67 @@
 #define INGEN_SOCKET_READER_HPP
 
 #include <thread>
+#include <vector>
 
+#include "ingen/AtomForgeSink.hpp"
 #include "ingen/ingen.h"
 #include "ingen/types.hpp"
+#include "lv2/atom/forge.h"
 #include "serd/serd.h"
 #include "sord/sord.h"
+#include "sratom/sratom.h"
 
 namespace Raul { class Socket; }
 
 namespace ingen {
 
+class AtomReader;
 class Interface;
 class World;
 
-/** Calls Interface methods based on Turtle messages received via socket. */
+/** Calls Interface methods based on Turtle messages received via socket.
+ *
+ * By default, the reader runs its own thread which waits for input on the
+ * socket.  Otherwise, the owner must call read() whenever the socket is
+ * readable, which allows many connections to be served by a single thread.
+ */
 class INGEN_API SocketReader
 {
 public:
 	SocketReader(World&             world,
 	             Interface&         iface,
-	             SPtr<Raul::Socket> sock);
+	             SPtr<Raul::Socket> sock,
+	             bool               threaded = true);
 
 	virtual ~SocketReader();
 
+	/** Read and process all messages that have arrived on the socket.
+	 *
+	 * This must only be called for non-threaded readers when the socket is
+	 * readable.  It never blocks: a partially received message is kept until
+	 * the rest arrives in a later call.
+	 *
+	 * @return False if the connection has been closed.
+	 */
+	bool read();
+
+	const SPtr<Raul::Socket>& socket() const { return _socket; }
+
 protected:
 	virtual void on_hangup() {}
 
 private:
+	/** State of the scanner that finds the end of statements. */
+	enum class Scan { NORMAL, IRI, STRING, LONG_STRING, COMMENT };
+
 	void run();
+	void open();
+	void close();
+	bool receive();
+	void scan();
+
+	static size_t c_recv(void* buf, size_t size, size_t nmemb, void* stream);
+	static int    c_error(void* stream);
 
 	static SerdStatus set_base_uri(SocketReader*   iface,
 	                               const SerdNode* uri_node);
@@ -68,7 +101,20 @@ private:
 	SerdEnv*           _env;
 	SordInserter*      _inserter;
 	SordNode*          _msg_node;
+	SordNode*          _base_uri;
+	SordModel*         _model;
+	SerdReader*        _reader;
+	Sratom*            _sratom;
+	LV2_Atom_Forge     _forge;
+	AtomForgeSink      _buffer;
+	UPtr<AtomReader>   _atom_reader;
 	SPtr<Raul::Socket> _socket;
+	std::vector<char>  _input;     ///< Received input not yet parsed
+	size_t             _recv_pos;  ///< Offset of next byte for serd
+	size_t             _scan_pos;  ///< Offset of next byte to scan
+	size_t             _complete;  ///< Length of complete statements
+	Scan               _scan;
+	char               _quote;     ///< Quote character of current string
 	bool               _exit_flag;
 	std::thread        _thread;
 };
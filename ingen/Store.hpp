@@ -18,8 +18,11 @@
 #define INGEN_STORE_HPP
 
 #include <cstddef>
+#include <functional>
 #include <map>
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "ingen/ingen.h"
@@ -35,6 +38,12 @@ namespace ingen {
 class Node;
 
 /** Store of objects in the graph hierarchy.
+ *
+ * Objects are kept in a map sorted by path, so the descendants of an object
+ * directly follow it.  A hash index by path makes lookups constant time.  The
+ * store must only be modified with the methods here (not those of std::map),
+ * so the index stays consistent.
+ *
  * @ingroup IngenShared
  */
 class INGEN_API Store : public Raul::Noncopyable
@@ -43,11 +52,24 @@ class INGEN_API Store : public Raul::Noncopyable
 public:
 	void add(Node* o);
 
+	/** Add `node` at its path if nothing is there, but not its ports. */
+	void add_node(SPtr<Node> node);
+
 	Node* get(const Raul::Path& path) {
 		const iterator i = find(path);
 		return (i == end()) ? nullptr : i->second.get();
 	}
 
+	iterator find(const Raul::Path& path) {
+		const auto i = _index.find(path);
+		return (i == _index.end()) ? end() : i->second;
+	}
+
+	const_iterator find(const Raul::Path& path) const {
+		const auto i = _index.find(path);
+		return (i == _index.end()) ? end() : const_iterator(i->second);
+	}
+
 	typedef std::pair<const_iterator, const_iterator> const_range;
 
 	typedef std::map< Raul::Path, SPtr<Node> > Objects;
@@ -72,6 +94,9 @@ public:
 	 */
 	void rename(iterator top, const Raul::Path& new_path);
 
+	/** Remove all objects. */
+	void clear();
+
 	unsigned child_name_offset(const Raul::Path&   parent,
 	                           const Raul::Symbol& symbol,
 	                           bool                allow_zero=true) const;
@@ -81,7 +106,16 @@ public:
 	Mutex& mutex() { return _mutex; }
 
 private:
+	struct PathHash {
+		size_t operator()(const Raul::Path& path) const {
+			return std::hash<std::string>()(path);
+		}
+	};
+
+	typedef std::unordered_map<Raul::Path, iterator, PathHash> Index;
+
 	Mutex _mutex;
+	Index _index;
 };
 
 } // namespace ingen
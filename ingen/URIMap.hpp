@@ -17,10 +17,10 @@
 #ifndef INGEN_URIMAP_HPP
 #define INGEN_URIMAP_HPP
 
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 #include <string>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -38,6 +38,10 @@ class Node;
 class World;
 
 /** URI to integer map and implementation of LV2 URID extension.
+ *
+ * Mapping a URI that is already known and unmapping are lock-free, only
+ * adding a new URI takes a lock.  URIDs are allocated sequentially from 1.
+ *
  * @ingroup IngenShared
  */
 class INGEN_API URIMap : public Raul::Noncopyable {
@@ -87,12 +91,44 @@ private:
 	friend struct URIDMapFeature;
 	friend struct URIDUnMapFeature;
 
+	/** Open addressing hash table of (hash << 32 | URID), 0 if empty.
+	 *
+	 * Tables are only replaced, never modified in a way that could confuse a
+	 * concurrent reader, and replaced tables are kept until destruction.
+	 */
+	struct Table {
+		explicit Table(uint32_t size);
+
+		const uint32_t                  mask;
+		UPtr<std::atomic<uint64_t>[]> slots;
+	};
+
+	/** Number of chunks in the unmap array, enough for all 32-bit URIDs. */
+	static const uint32_t n_chunks = 24;
+
+	/** Size of the first unmap chunk, each following chunk is twice as big. */
+	static const uint32_t first_chunk_size = 256;
+
+	static uint32_t hash(const char* uri);
+	static void     locate(uint32_t index, uint32_t& chunk, uint32_t& offset);
+
+	/** Return the URID of `uri`, or 0 if it is unknown, without locking. */
+	LV2_URID find(const char* uri, uint32_t hash) const;
+
+	/** Add `uri` if it is unknown and return its URID. */
+	LV2_URID insert(const char* uri, uint32_t hash);
+
+	/** Return the URI of `urid`, or null if it is unknown, without locking. */
+	const char* lookup(LV2_URID urid) const;
+
 	SPtr<URIDMapFeature>   _urid_map_feature;
 	SPtr<URIDUnmapFeature> _urid_unmap_feature;
 
-	std::mutex                                _mutex;
-	std::unordered_map<std::string, LV2_URID> _map;
-	std::vector<std::string>                  _unmap;
+	std::mutex               _mutex;            ///< Held while adding a URI
+	std::atomic<Table*>      _table;            ///< Current hash table
+	std::vector<UPtr<Table>> _tables;           ///< Current and replaced tables
+	std::atomic<uint32_t>    _size;             ///< Number of URIDs
+	UPtr<std::string[]>      _chunks[n_chunks]; ///< URIs by URID
 };
 
 } // namespace ingen
@@ -96,24 +96,42 @@ public:
 	const Quark ingen_broadcast;
 	const Quark ingen_canvasX;
 	const Quark ingen_canvasY;
+	const Quark ingen_droppedMessages;
 	const Quark ingen_enabled;
 	const Quark ingen_externalContext;
 	const Quark ingen_file;
+	const Quark ingen_filterProperty;
+	const Quark ingen_flightRecord;
 	const Quark ingen_head;
 	const Quark ingen_incidentTo;
 	const Quark ingen_internalContext;
 	const Quark ingen_loadedBundle;
+	const Quark ingen_maxLatency;
+	const Quark ingen_maxQueueLength;
 	const Quark ingen_maxRunLoad;
 	const Quark ingen_meanRunLoad;
+	const Quark ingen_medianLatency;
+	const Quark ingen_mergedMessages;
+	const Quark ingen_mergedUpdates;
 	const Quark ingen_minRunLoad;
 	const Quark ingen_numThreads;
+	const Quark ingen_overruns;
 	const Quark ingen_polyphonic;
 	const Quark ingen_polyphony;
 	const Quark ingen_prototype;
+	const Quark ingen_queueLength;
+	const Quark ingen_shallow;
+	const Quark ingen_sharedMemory;
+	const Quark ingen_slowestBlock;
 	const Quark ingen_sprungLayout;
+	const Quark ingen_subscribe;
 	const Quark ingen_tail;
+	const Quark ingen_tailLatency;
 	const Quark ingen_uiEmbedded;
+	const Quark ingen_undoMemory;
+	const Quark ingen_updateRate;
 	const Quark ingen_value;
+	const Quark ingen_xruns;
 	const Quark log_Error;
 	const Quark log_Note;
 	const Quark log_Trace;
@@ -0,0 +1,242 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_CLIENT_SHM_CLIENT_HPP
+#define INGEN_CLIENT_SHM_CLIENT_HPP
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include <boost/variant/get.hpp>
+
+#include "ingen/Forge.hpp"
+#include "ingen/Log.hpp"
+#include "ingen/ShmReader.hpp"
+#include "ingen/ShmSegment.hpp"
+#include "ingen/ShmWriter.hpp"
+#include "ingen/SocketReader.hpp"
+#include "ingen/SocketWriter.hpp"
+#include "ingen/URIs.hpp"
+#include "ingen/World.hpp"
+#include "ingen/ingen.h"
+#include "raul/Socket.hpp"
+
+namespace ingen {
+namespace client {
+
+/** The client side of an Ingen shared memory connection.
+ *
+ * This connects to the engine's UNIX socket, then creates a shared memory
+ * segment and asks the engine to use it by setting ingen:sharedMemory on
+ * ingen:/clients/this.  If the engine accepts, all further messages in both
+ * directions go through the segment, otherwise the socket is used as usual.
+ *
+ * Connect with a URI like "shm:///tmp/ingen.sock", where the path is the
+ * engine's UNIX socket.
+ */
+class INGEN_API ShmClient : public Interface
+{
+public:
+	ShmClient(World&             world,
+	          const URI&         uri,
+	          SPtr<Raul::Socket> sock,
+	          SPtr<Interface>    respondee)
+		: _world(world)
+		, _uri(uri)
+		, _respondee(respondee)
+		, _attach_status(Status::FAILURE)
+		, _attach_done(false)
+		, _receiver(*this)
+		, _writer(new SocketWriter(world.uri_map(), world.uris(), uri, sock))
+		, _socket_reader(*this, sock)
+	{}
+
+	~ShmClient() {
+		if (_segment) {
+			_segment->close();
+		}
+	}
+
+	URI uri() const override { return _uri; }
+
+	void message(const Message& msg) override { _writer->message(msg); }
+
+	SPtr<Interface> respondee() const override {
+		return _respondee;
+	}
+
+	void set_respondee(SPtr<Interface> respondee) override {
+		_respondee = respondee;
+	}
+
+	/** Switch to shared memory, and return true if the engine accepted. */
+	bool attach() {
+		static std::atomic<unsigned> n_segments(0);
+
+		const std::string name = "/ingen." + std::to_string(getpid()) + "." +
+		                         std::to_string(n_segments++);
+
+		_segment = ShmSegment::create(name, ring_size);
+		if (!_segment) {
+			_world.log().error(fmt("Failed to create shared memory (%1%)\n")
+			                   % strerror(errno));
+			return false;
+		}
+
+		// Start reading before the request, the response may arrive either way
+		_shm_reader = UPtr<ShmReader>(
+			new ShmReader(_world, _receiver, _segment, _segment->to_client()));
+
+		_writer->message(SetProperty{attach_id,
+		                             URI("ingen:/clients/this"),
+		                             _world.uris().ingen_sharedMemory,
+		                             _world.forge().alloc(name),
+		                             Resource::Graph::DEFAULT,
+		                             0});
+
+		// Wait for the reply, since the engine switches transports if it
+		// accepts, even if the reply is slow (ends early if the socket closes)
+		Status status = Status::FAILURE;
+		{
+			std::unique_lock<std::mutex> lock(_attach_mutex);
+			const auto done = [this] { return _attach_done; };
+			if (!_attach_cond.wait_for(lock, std::chrono::seconds(2), done)) {
+				_world.log().warn("Waiting for engine to attach shared memory\n");
+				_attach_cond.wait(lock, done);
+			}
+			status = _attach_status;
+		}
+
+		// The engine has mapped the segment by now, or never will
+		_segment->unlink();
+
+		if (status != Status::SUCCESS) {
+			_segment->close();
+			_shm_reader.reset();
+			_segment.reset();
+			return false;
+		}
+
+		_writer = SPtr<Interface>(new ShmWriter(_world.uri_map(),
+		                                        _world.uris(),
+		                                        _world.log(),
+		                                        _uri,
+		                                        _segment,
+		                                        _segment->to_engine()));
+		return true;
+	}
+
+	static SPtr<ingen::Interface>
+	new_shm_interface(ingen::World*          world,
+	                  const URI&             uri,
+	                  SPtr<ingen::Interface> respondee)
+	{
+		// Connect to the engine's socket at the same path
+		const URI          sock_uri(std::string("unix") + uri.string().substr(3));
+		SPtr<Raul::Socket> sock(new Raul::Socket(Raul::Socket::Type::UNIX));
+		if (!sock->connect(sock_uri)) {
+			world->log().error(fmt("Failed to connect <%1%> (%2%)\n")
+			                   % sock->uri() % strerror(errno));
+			return SPtr<Interface>();
+		}
+
+		SPtr<ShmClient> client(new ShmClient(*world, sock_uri, sock, respondee));
+		if (!client->attach()) {
+			world->log().warn("Shared memory unavailable, using socket\n");
+		}
+		return client;
+	}
+
+	static void register_factories(World* world) {
+		world->add_interface_factory("shm", &new_shm_interface);
+	}
+
+private:
+	/** Forwards received messages to the respondee, except the attach reply. */
+	class Receiver : public Interface
+	{
+	public:
+		explicit Receiver(ShmClient& client) : _client(client) {}
+
+		URI uri() const override { return _client.uri(); }
+
+		void message(const Message& msg) override {
+			const Response* const response = boost::get<Response>(&msg);
+			if (response && response->id == attach_id) {
+				std::lock_guard<std::mutex> lock(_client._attach_mutex);
+				_client._attach_status = response->status;
+				_client._attach_done   = true;
+				_client._attach_cond.notify_all();
+			} else if (_client._respondee) {
+				_client._respondee->message(msg);
+			}
+		}
+
+	private:
+		ShmClient& _client;
+	};
+
+	/** Reads from the socket, and ends any wait for the attach reply on hangup. */
+	class Reader : public SocketReader
+	{
+	public:
+		Reader(ShmClient& client, SPtr<Raul::Socket> sock)
+			: SocketReader(client._world, client._receiver, sock)
+			, _client(client)
+		{}
+
+	protected:
+		void on_hangup() override {
+			std::lock_guard<std::mutex> lock(_client._attach_mutex);
+			_client._attach_done = true;
+			_client._attach_cond.notify_all();
+		}
+
+	private:
+		ShmClient& _client;
+	};
+
+	/** Request ID for attaching, negative so it never clashes with the app. */
+	static const int32_t attach_id = -1;
+
+	/** Size of each ring buffer in the segment. */
+	static const uint32_t ring_size = 1 << 20;
+
+	World&                  _world;
+	URI                     _uri;
+	SPtr<Interface>         _respondee;
+	std::mutex              _attach_mutex;
+	std::condition_variable _attach_cond;
+	Status                  _attach_status;
+	bool                    _attach_done;
+	Receiver                _receiver;
+	SPtr<Interface>         _writer;
+	SPtr<ShmSegment>        _segment;
+	Reader                  _socket_reader;
+	UPtr<ShmReader>         _shm_reader;
+};
+
+}  // namespace client
+}  // namespace ingen
+
+#endif  // INGEN_CLIENT_SHM_CLIENT_HPP
@@ -53,23 +53,41 @@
 #define INGEN__broadcast       INGEN_NS "broadcast"
 #define INGEN__canvasX         INGEN_NS "canvasX"
 #define INGEN__canvasY         INGEN_NS "canvasY"
+#define INGEN__droppedMessages INGEN_NS "droppedMessages"
 #define INGEN__enabled         INGEN_NS "enabled"
 #define INGEN__externalContext INGEN_NS "externalContext"
 #define INGEN__file            INGEN_NS "file"
+#define INGEN__filterProperty  INGEN_NS "filterProperty"
+#define INGEN__flightRecord    INGEN_NS "flightRecord"
 #define INGEN__head            INGEN_NS "head"
 #define INGEN__incidentTo      INGEN_NS "incidentTo"
 #define INGEN__internalContext INGEN_NS "internalContext"
 #define INGEN__loadedBundle    INGEN_NS "loadedBundle"
+#define INGEN__maxLatency      INGEN_NS "maxLatency"
+#define INGEN__maxQueueLength  INGEN_NS "maxQueueLength"
 #define INGEN__maxRunLoad      INGEN_NS "maxRunLoad"
 #define INGEN__meanRunLoad     INGEN_NS "meanRunLoad"
+#define INGEN__medianLatency   INGEN_NS "medianLatency"
+#define INGEN__mergedMessages  INGEN_NS "mergedMessages"
+#define INGEN__mergedUpdates   INGEN_NS "mergedUpdates"
 #define INGEN__minRunLoad      INGEN_NS "minRunLoad"
 #define INGEN__numThreads      INGEN_NS "numThreads"
+#define INGEN__overruns        INGEN_NS "overruns"
 #define INGEN__polyphonic      INGEN_NS "polyphonic"
 #define INGEN__polyphony       INGEN_NS "polyphony"
 #define INGEN__prototype       INGEN_NS "prototype"
+#define INGEN__queueLength     INGEN_NS "queueLength"
+#define INGEN__shallow         INGEN_NS "shallow"
+#define INGEN__sharedMemory    INGEN_NS "sharedMemory"
+#define INGEN__slowestBlock    INGEN_NS "slowestBlock"
 #define INGEN__sprungLayout    INGEN_NS "sprungLayout"
+#define INGEN__subscribe       INGEN_NS "subscribe"
 #define INGEN__tail            INGEN_NS "tail"
+#define INGEN__tailLatency     INGEN_NS "tailLatency"
 #define INGEN__uiEmbedded      INGEN_NS "uiEmbedded"
+#define INGEN__undoMemory      INGEN_NS "undoMemory"
+#define INGEN__updateRate      INGEN_NS "updateRate"
 #define INGEN__value           INGEN_NS "value"
+#define INGEN__xruns           INGEN_NS "xruns"
 
 #endif // INGEN_H
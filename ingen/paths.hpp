@@ -27,6 +27,20 @@ namespace ingen {
 
 inline URI main_uri() { return URI("ingen:/main"); }
 
+inline URI engine_uri() { return URI("ingen:/engine"); }
+
+/** Return true iff `uri` is the engine or a resource that describes it.
+ *
+ * These resources, like ingen:/engine/latency/executed, report the status of
+ * the engine and are not part of the graph.
+ */
+inline bool uri_is_engine(const URI& uri)
+{
+	const std::string prefix = engine_uri().string() + "/";
+	return (uri == engine_uri() ||
+	        !uri.string().compare(0, prefix.length(), prefix));
+}
+
 inline bool uri_is_path(const URI& uri)
 {
 	const size_t root_len = main_uri().string().length();
@@ -18,6 +18,7 @@
 #include <utility>
 
 #include "ingen/AtomReader.hpp"
+#include "ingen/Forge.hpp"
 #include "ingen/Interface.hpp"
 #include "ingen/Log.hpp"
 #include "ingen/Message.hpp"
@@ -152,10 +153,12 @@ AtomReader::write(const LV2_Atom* msg, int32_t default_id)
 	const LV2_Atom_Object* obj     = (const LV2_Atom_Object*)msg;
 	const LV2_Atom*        subject = nullptr;
 	const LV2_Atom*        number  = nullptr;
+	const LV2_Atom*        frame   = nullptr;
 
 	lv2_atom_object_get(obj,
 	                    (LV2_URID)_uris.patch_subject,        &subject,
 	                    (LV2_URID)_uris.patch_sequenceNumber, &number,
+	                    (LV2_URID)_uris.time_frame,           &frame,
 	                    nullptr);
 
 	const boost::optional<URI> subject_uri = atom_to_uri(subject);
@@ -164,9 +167,21 @@ AtomReader::write(const LV2_Atom* msg, int32_t default_id)
 	                     ? ((const LV2_Atom_Int*)number)->body
 	                     : default_id);
 
+	int64_t time = 0;
+	if (frame && frame->type == _uris.forge.Long) {
+		time = ((const LV2_Atom_Long*)frame)->body;
+	} else if (frame && frame->type == _uris.atom_Int) {
+		time = ((const LV2_Atom_Int*)frame)->body;
+	}
+
 	if (obj->body.otype == _uris.patch_Get) {
+		const LV2_Atom* shallow = nullptr;
+		lv2_atom_object_get(obj, (LV2_URID)_uris.ingen_shallow, &shallow, 0);
 		if (subject_uri) {
-			_iface(Get{seq, *subject_uri});
+			_iface(Get{seq,
+			           *subject_uri,
+			           (shallow && shallow->type == _uris.atom_Bool &&
+			            ((const LV2_Atom_Bool*)shallow)->body)});
 		}
 	} else if (obj->body.otype == _uris.ingen_BundleStart) {
 		_iface(BundleBegin{seq});
@@ -239,7 +254,7 @@ AtomReader::write(const LV2_Atom* msg, int32_t default_id)
 		} else {
 			ingen::Properties props;
 			get_props(body, props);
-			_iface(Put{seq, *subject_uri, props, atom_to_context(context)});
+			_iface(Put{seq, *subject_uri, props, atom_to_context(context), time});
 		}
 	} else if (obj->body.otype == _uris.patch_Set) {
 		if (!subject_uri) {
@@ -269,7 +284,8 @@ AtomReader::write(const LV2_Atom* msg, int32_t default_id)
 		                   *subject_uri,
 		                   URI(_map.unmap_uri(prop->body)),
 		                   atom,
-		                   atom_to_context(context)});
+		                   atom_to_context(context),
+		                   time});
 	} else if (obj->body.otype == _uris.patch_Patch) {
 		if (!subject_uri) {
 			_log.warn("Patch message has no subject\n");
@@ -299,7 +315,7 @@ AtomReader::write(const LV2_Atom* msg, int32_t default_id)
 		get_props(remove, remove_props);
 
 		_iface(Delta{seq, *subject_uri, remove_props, add_props,
-		             atom_to_context(context)});
+		             atom_to_context(context), time});
 	} else if (obj->body.otype == _uris.patch_Copy) {
 		if (!subject) {
 			_log.warn("Copy message has no subject\n");
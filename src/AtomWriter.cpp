@@ -184,6 +184,15 @@ AtomWriter::forge_context(Resource::Graph ctx)
 	}
 }
 
+void
+AtomWriter::forge_time(int64_t time)
+{
+	if (time) {
+		lv2_atom_forge_key(&_forge, _uris.time_frame);
+		lv2_atom_forge_long(&_forge, time);
+	}
+}
+
 /** @page protocol
  * @section methods Methods
  * @subsection Put
@@ -214,6 +223,7 @@ AtomWriter::operator()(const Put& message)
 	LV2_Atom_Forge_Frame msg;
 	forge_request(&msg, _uris.patch_Put, message.seq);
 	forge_context(message.ctx);
+	forge_time(message.time);
 	lv2_atom_forge_key(&_forge, _uris.patch_subject);
 	forge_uri(message.uri);
 	lv2_atom_forge_key(&_forge, _uris.patch_body);
@@ -259,6 +269,7 @@ AtomWriter::operator()(const Delta& message)
 	LV2_Atom_Forge_Frame msg;
 	forge_request(&msg, _uris.patch_Patch, message.seq);
 	forge_context(message.ctx);
+	forge_time(message.time);
 	lv2_atom_forge_key(&_forge, _uris.patch_subject);
 	forge_uri(message.uri);
 
@@ -382,6 +393,24 @@ AtomWriter::operator()(const Del& message)
  *     patch:property lv2:name ;
  *     patch:value "Oscwellator" .
  * @endcode
+ *
+ * A Set, Put, or Patch may have a
+ * [time:frame](http://lv2plug.in/ns/ext/time#frame) to schedule it for a
+ * future frame of the engine's clock, which is described by the time:frame
+ * property of ingen:/engine.  Port value changes with a time are held until
+ * their cycle and applied at exactly that frame, so a client can send them
+ * ahead of time in batches.  Other changes with a time are applied at the start
+ * of its cycle, in order.  Messages without a time, or with a time in the past,
+ * are applied as soon as possible.
+ *
+ * @code{.ttl}
+ * []
+ *     a patch:Set ;
+ *     time:frame 96000 ;
+ *     patch:subject </main/osc/freq> ;
+ *     patch:property ingen:value ;
+ *     patch:value 440.0 .
+ * @endcode
  */
 void
 AtomWriter::operator()(const SetProperty& message)
@@ -389,6 +418,7 @@ AtomWriter::operator()(const SetProperty& message)
 	LV2_Atom_Forge_Frame msg;
 	forge_request(&msg, _uris.patch_Set, message.seq);
 	forge_context(message.ctx);
+	forge_time(message.time);
 	lv2_atom_forge_key(&_forge, _uris.patch_subject);
 	forge_uri(message.subject);
 	lv2_atom_forge_key(&_forge, _uris.patch_property);
@@ -451,6 +481,17 @@ AtomWriter::operator()(const Redo& message)
  *     a patch:Get ;
  *     patch:subject </main/osc> .
  * @endcode
+ *
+ * A large graph is described in several parts, with other messages possibly
+ * in between, and the response is sent once it has been described entirely.
+ * To only get the ports and blocks directly in a graph, set ingen:shallow:
+ *
+ * @code{.ttl}
+ * []
+ *     a patch:Get ;
+ *     patch:subject </main> ;
+ *     ingen:shallow true .
+ * @endcode
  */
 void
 AtomWriter::operator()(const Get& message)
@@ -459,6 +500,10 @@ AtomWriter::operator()(const Get& message)
 	forge_request(&msg, _uris.patch_Get, message.seq);
 	lv2_atom_forge_key(&_forge, _uris.patch_subject);
 	forge_uri(message.subject);
+	if (message.shallow) {
+		lv2_atom_forge_key(&_forge, _uris.ingen_shallow);
+		lv2_atom_forge_bool(&_forge, true);
+	}
 	lv2_atom_forge_pop(&_forge, &msg);
 	finish_msg();
 }
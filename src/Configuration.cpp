@@ -51,10 +51,13 @@ Configuration::Configuration(Forge& forge)
 	add("atomicBundles",  "atomic-bundles", 'a', "Execute bundles atomically", GLOBAL, forge.Bool, forge.make(false));
 	add("bufferSize",     "buffer-size",    'b', "Buffer size in samples", GLOBAL, forge.Int, forge.make(1024));
 	add("clientPort",     "client-port",    'C', "Client port", GLOBAL, forge.Int, Atom());
+	add("clientQueueSize", "client-queue-size", 0, "Maximum number of queued messages per client", GLOBAL, forge.Int, forge.make(8192));
+	add("clientOverflow", "client-overflow", 0, "Client queue overflow policy (drop, coalesce, disconnect)", GLOBAL, forge.String, forge.alloc("coalesce"));
 	add("connect",        "connect",        'c', "Connect to engine URI", SESSION, forge.String, forge.alloc("unix:///tmp/ingen.sock"));
 	add("engine",         "engine",         'e', "Run (JACK) engine", SESSION, forge.Bool, forge.make(false));
 	add("enginePort",     "engine-port",    'E', "Engine listen port", GLOBAL, forge.Int, forge.make(16180));
 	add("socket",         "socket",         'S', "Engine socket path", GLOBAL, forge.String, forge.alloc("/tmp/ingen.sock"));
+	add("ioThreads",      "io-threads",      0,  "Number of threads serving socket connections", GLOBAL, forge.Int, forge.make(1));
 	add("gui",            "gui",            'g', "Launch the GTK graphical interface", SESSION, forge.Bool, forge.make(false));
 	add("",               "help",           'h', "Print this help message", SESSION, forge.Bool, forge.make(false));
 	add("",               "version",        'V', "Print version information", SESSION, forge.Bool, forge.make(false));
@@ -66,13 +69,23 @@ Configuration::Configuration(Forge& forge)
 	add("save",           "save",           'o', "Save graph", SESSION, forge.String, Atom());
 	add("execute",        "execute",        'x', "File of commands to execute", SESSION, forge.String, Atom());
 	add("path",           "path",           'L', "Target path for loaded graph", SESSION, forge.String, Atom());
+	add("nullDriver",     "null-driver",     0,  "Run in real time without an audio device", GLOBAL, forge.Bool, forge.make(false));
+	add("sampleRate",     "sample-rate",     0,  "Sample rate of null driver", GLOBAL, forge.Int, forge.make(48000));
 	add("queueSize",      "queue-size",     'q', "Event queue size", GLOBAL, forge.Int, forge.make(4096));
+	add("undoMemory",     "undo-memory",     0,  "Maximum memory for undo and redo history in MiB (0 for no limit)", GLOBAL, forge.Int, forge.make(64));
 	add("flushLog",       "flush-log",      'f', "Flush logs after every entry", GLOBAL, forge.Bool, forge.make(false));
 	add("dump",           "dump",           'd', "Print debug output", SESSION, forge.Bool, forge.make(false));
 	add("trace",          "trace",          't', "Show LV2 plugin trace messages", SESSION, forge.Bool, forge.make(false));
+	add("traceFile",      "trace-file",      0,  "Record execution trace and write it to file on SIGUSR1 or exit", SESSION, forge.String, Atom());
+	add("overrunThreshold", "overrun-threshold", 0, "Record block timings and keep the cycles before one that takes longer than this percentage of its duration (0 to disable)", GLOBAL, forge.Int, forge.make(0));
+	add("overrunCycles",  "overrun-cycles",  0,  "Number of cycles kept before an overrun", GLOBAL, forge.Int, forge.make(8));
+	add("overrunFile",    "overrun-file",    0,  "Prefix of files to write overrun flight records to", GLOBAL, forge.String, Atom());
 	add("threads",        "threads",        'p', "Number of processing threads", GLOBAL, forge.Int, forge.make(int32_t(std::max(std::thread::hardware_concurrency(), 1U))));
+	add("pinThreads",     "pin-threads",     0,  "Run each processing thread on its own CPU", GLOBAL, forge.Bool, forge.make(false));
+	add("workerThreads",  "worker-threads",  0,  "Number of threads doing non-realtime work for plugins", GLOBAL, forge.Int, forge.make(1));
 	add("humanNames",     "human-names",     0,  "Show human names in GUI", GUI, forge.Bool, forge.make(true));
 	add("portLabels",     "port-labels",     0,  "Show port labels in GUI", GUI, forge.Bool, forge.make(true));
+	add("guiTiming",      "gui-timing",      0,  "Print graph canvas build times", GUI, forge.Bool, forge.make(false));
 	add("graphDirectory", "graph-directory", 0,  "Default directory for opening graphs", GUI, forge.String, Atom());
 }
 
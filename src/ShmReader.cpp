@@ -0,0 +1,125 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+
+#include "ingen/Log.hpp"
+#include "ingen/ShmReader.hpp"
+#include "ingen/URIMap.hpp"
+#include "ingen/World.hpp"
+#include "lv2/atom/util.h"
+
+namespace ingen {
+
+/** Time to wait for messages before checking if the reader should exit. */
+static const int read_timeout_ms = 100;
+
+/** Maximum URID the writer may define, which bounds the size of the table. */
+static const LV2_URID max_urid = 1 << 20;
+
+ShmReader::ShmReader(World&           world,
+                     Interface&       iface,
+                     SPtr<ShmSegment> segment,
+                     ShmRing&         ring)
+	: _world(world)
+	, _segment(std::move(segment))
+	, _ring(ring)
+	, _reader(world.uri_map(), world.uris(), world.log(), iface)
+	, _rewriter(world.uri_map())
+	, _exit_flag(false)
+	, _thread(&ShmReader::run, this)
+{}
+
+ShmReader::~ShmReader()
+{
+	_exit_flag = true;
+	_thread.join();
+}
+
+bool
+ShmReader::process(LV2_Atom* record)
+{
+	if (record->type == 0) {
+		// URID definition, map URI to get the local URID (see ShmWriter)
+		if (record->size <= sizeof(LV2_URID)) {
+			_world.log().error("Received invalid URID definition\n");
+			return false;
+		}
+
+		LV2_URID urid = 0;
+		memcpy(&urid, record + 1, sizeof(LV2_URID));
+
+		const char*  uri     = (const char*)(record + 1) + sizeof(LV2_URID);
+		const size_t max_len = record->size - sizeof(LV2_URID);
+		if (!urid || urid > max_urid || strnlen(uri, max_len) == max_len) {
+			_world.log().error("Received invalid URID definition\n");
+			return false;
+		}
+
+		if (urid >= _urids.size()) {
+			_urids.resize(urid + 1);
+		}
+		_urids[urid] = _world.uri_map().map_uri(uri);
+		return true;
+	}
+
+	bool       ok   = true;
+	const bool sane = _rewriter.rewrite(
+		record, lv2_atom_total_size(record), [this, &ok](LV2_URID urid) {
+			if (urid >= _urids.size() || !_urids[urid]) {
+				ok = false;
+				return LV2_URID(0);
+			}
+			return _urids[urid];
+		});
+
+	if (!sane) {
+		_world.log().error("Received malformed message\n");
+		return false;
+	} else if (ok) {
+		_reader.write(record);
+	} else {
+		_world.log().error("Received message with unknown URIDs\n");
+	}
+
+	return true;
+}
+
+void
+ShmReader::run()
+{
+	while (true) {
+		const uint32_t seq = _ring.seq();
+		while (_ring.read(_buf)) {
+			if (!process((LV2_Atom*)_buf.data())) {
+				_ring.close();
+				break;
+			}
+		}
+
+		if (_ring.closed()) {
+			// Closed by the writer, or after an invalid record, drop both rings
+			_segment->close();
+			break;
+		} else if (_exit_flag) {
+			break;
+		}
+
+		_ring.wait(seq, read_timeout_ms);
+	}
+}
+
+} // namespace ingen
@@ -0,0 +1,420 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <time.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include "ingen/ShmSegment.hpp"
+#include "ingen/URIMap.hpp"
+#include "lv2/atom/util.h"
+
+namespace ingen {
+
+static const uint32_t shm_magic   = 0x4E47494E;  // "NIGN"
+static const uint32_t shm_version = 1;
+
+/** The start of a segment, followed by the ring buffers. */
+struct ShmSegment::Header {
+	uint32_t       magic;
+	uint32_t       version;
+	uint32_t       ring_size;
+	ShmRing::State to_engine;
+	ShmRing::State to_client;
+};
+
+static uint32_t
+next_power_of_two(uint32_t size)
+{
+	uint32_t n = 64;
+	while (n < size) {
+		n <<= 1;
+	}
+	return n;
+}
+
+static void
+futex_wait(std::atomic<uint32_t>* word, uint32_t value, int timeout_ms)
+{
+#ifdef __linux__
+	const struct timespec timeout = { timeout_ms / 1000,
+	                                  (timeout_ms % 1000) * 1000000L };
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, value,
+	        &timeout, nullptr, 0);
+#else
+	// No way to wait on shared memory, poll at a short interval instead
+	if (word->load() == value) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+#endif
+}
+
+static void
+futex_wake(std::atomic<uint32_t>* word)
+{
+#ifdef __linux__
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT32_MAX,
+	        nullptr, nullptr, 0);
+#endif
+}
+
+ShmRing::ShmRing(State* state, uint8_t* buf, uint32_t size)
+	: _state(state)
+	, _buf(buf)
+	, _size(size)
+	, _size_mask(size - 1)
+{}
+
+uint32_t
+ShmRing::read_space() const
+{
+	const uint32_t w = _state->write_head.load(std::memory_order_acquire);
+	const uint32_t r = _state->read_head.load(std::memory_order_relaxed);
+	return (w - r) & _size_mask;
+}
+
+uint32_t
+ShmRing::write_space() const
+{
+	const uint32_t w = _state->write_head.load(std::memory_order_relaxed);
+	const uint32_t r = _state->read_head.load(std::memory_order_acquire);
+	return (r - w - 1) & _size_mask;
+}
+
+void
+ShmRing::copy_in(uint32_t offset, const void* src, uint32_t size)
+{
+	const uint32_t first = std::min(size, _size - offset);
+	memcpy(_buf + offset, src, first);
+	memcpy(_buf, (const uint8_t*)src + first, size - first);
+}
+
+void
+ShmRing::copy_out(uint32_t offset, void* dst, uint32_t size) const
+{
+	const uint32_t first = std::min(size, _size - offset);
+	memcpy(dst, _buf + offset, first);
+	memcpy((uint8_t*)dst + first, _buf, size - first);
+}
+
+bool
+ShmRing::write(const LV2_Atom* atom)
+{
+	const uint32_t size = lv2_atom_total_size(atom);
+	const uint32_t pad  = lv2_atom_pad_size(size) - size;
+	if (write_space() < size + pad) {
+		return false;
+	}
+
+	static const uint8_t zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+	// Write the record, then publish it by advancing the write head
+	const uint32_t w = _state->write_head.load(std::memory_order_relaxed);
+	copy_in(w, atom, size);
+	copy_in((w + size) & _size_mask, zeros, pad);
+	_state->write_head.store((w + size + pad) & _size_mask,
+	                         std::memory_order_release);
+	notify();
+	return true;
+}
+
+bool
+ShmRing::read(std::vector<uint64_t>& buf)
+{
+	if (read_space() < sizeof(LV2_Atom)) {
+		return false;
+	}
+
+	// Records are written whole, so if the header is here the body is too
+	const uint32_t r = _state->read_head.load(std::memory_order_relaxed);
+	LV2_Atom       header;
+	copy_out(r, &header, sizeof(header));
+
+	// The header is written by the peer, so check it before trusting the size
+	const uint32_t size = lv2_atom_pad_size(lv2_atom_total_size(&header));
+	if (header.size > capacity() || size > read_space()) {
+		close();
+		return false;
+	}
+
+	buf.resize(size / sizeof(uint64_t));
+	copy_out(r, buf.data(), size);
+	_state->read_head.store((r + size) & _size_mask, std::memory_order_release);
+	notify();
+	return true;
+}
+
+void
+ShmRing::notify()
+{
+	++_state->seq;
+	if (_state->n_waiters.load()) {
+		futex_wake(&_state->seq);
+	}
+}
+
+void
+ShmRing::wait(uint32_t seq, int timeout_ms)
+{
+	++_state->n_waiters;
+	futex_wait(&_state->seq, seq, timeout_ms);
+	--_state->n_waiters;
+}
+
+void
+ShmRing::close()
+{
+	_state->closed = 1;
+	++_state->seq;
+	futex_wake(&_state->seq);
+}
+
+ShmSegment::ShmSegment(std::string name, void* mem, size_t size)
+	: _name(std::move(name))
+	, _mem(mem)
+	, _size(size)
+	, _header(static_cast<Header*>(mem))
+	, _to_engine(&_header->to_engine,
+	             (uint8_t*)mem + sizeof(Header),
+	             _header->ring_size)
+	, _to_client(&_header->to_client,
+	             (uint8_t*)mem + sizeof(Header) + _header->ring_size,
+	             _header->ring_size)
+	, _linked(false)
+{}
+
+ShmSegment::~ShmSegment()
+{
+	unlink();
+	munmap(_mem, _size);
+}
+
+UPtr<ShmSegment>
+ShmSegment::create(const std::string& name, uint32_t ring_size)
+{
+	const uint32_t size  = next_power_of_two(ring_size);
+	const size_t   total = sizeof(Header) + 2 * size_t(size);
+
+	const int fd = shm_open(name.c_str(), O_RDWR|O_CREAT|O_EXCL, 0600);
+	if (fd == -1) {
+		return UPtr<ShmSegment>();
+	}
+
+	void* mem = MAP_FAILED;
+	if (!ftruncate(fd, total)) {
+		mem = mmap(nullptr, total, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+
+	const int err = errno;
+	::close(fd);
+	if (mem == MAP_FAILED) {
+		shm_unlink(name.c_str());
+		errno = err;
+		return UPtr<ShmSegment>();
+	}
+
+	Header* header    = new (mem) Header();
+	header->magic     = shm_magic;
+	header->version   = shm_version;
+	header->ring_size = size;
+
+	UPtr<ShmSegment> segment(new ShmSegment(name, mem, total));
+	segment->_linked = true;
+	return segment;
+}
+
+UPtr<ShmSegment>
+ShmSegment::open(const std::string& name)
+{
+	const int fd = shm_open(name.c_str(), O_RDWR, 0);
+	if (fd == -1) {
+		return UPtr<ShmSegment>();
+	}
+
+	struct stat st;
+	void*       mem = MAP_FAILED;
+	if (!fstat(fd, &st) && size_t(st.st_size) >= sizeof(Header)) {
+		mem = mmap(nullptr, st.st_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	} else {
+		errno = EINVAL;
+	}
+
+	const int err = errno;
+	::close(fd);
+	if (mem == MAP_FAILED) {
+		errno = err;
+		return UPtr<ShmSegment>();
+	}
+
+	// Check that the segment was made by a compatible version of ingen
+	const Header* header = static_cast<const Header*>(mem);
+	if (header->magic != shm_magic || header->version != shm_version ||
+	    sizeof(Header) + 2 * size_t(header->ring_size) > size_t(st.st_size) ||
+	    (header->ring_size & (header->ring_size - 1))) {
+		munmap(mem, st.st_size);
+		errno = EINVAL;
+		return UPtr<ShmSegment>();
+	}
+
+	return UPtr<ShmSegment>(new ShmSegment(name, mem, st.st_size));
+}
+
+void
+ShmSegment::unlink()
+{
+	if (_linked) {
+		shm_unlink(_name.c_str());
+		_linked = false;
+	}
+}
+
+void
+ShmSegment::close()
+{
+	_to_engine.close();
+	_to_client.close();
+}
+
+URIDRewriter::URIDRewriter(URIMap& map)
+	: _atom_Literal(map.map_uri(LV2_ATOM__Literal))
+	, _atom_Object(map.map_uri(LV2_ATOM__Object))
+	, _atom_Sequence(map.map_uri(LV2_ATOM__Sequence))
+	, _atom_Tuple(map.map_uri(LV2_ATOM__Tuple))
+	, _atom_URID(map.map_uri(LV2_ATOM__URID))
+	, _atom_Vector(map.map_uri(LV2_ATOM__Vector))
+{}
+
+bool
+URIDRewriter::rewrite(LV2_Atom* atom, uint32_t size, const Func& func) const
+{
+	if (size < sizeof(LV2_Atom) || atom->size > size - sizeof(LV2_Atom)) {
+		return false;  // Atom does not fit in its container
+	}
+
+	atom->type = func(atom->type);
+
+	uint8_t* const body = (uint8_t*)(atom + 1);
+	if (atom->type == _atom_URID) {
+		if (atom->size < sizeof(LV2_URID)) {
+			return false;
+		}
+		LV2_Atom_URID* urid = (LV2_Atom_URID*)atom;
+		urid->body = func(urid->body);
+	} else if (atom->type == _atom_Object) {
+		// The object ID is not rewritten, ingen only uses blank objects
+		if (atom->size < sizeof(LV2_Atom_Object_Body)) {
+			return false;
+		}
+		LV2_Atom_Object* obj = (LV2_Atom_Object*)atom;
+		if (obj->body.otype) {
+			obj->body.otype = func(obj->body.otype);
+		}
+		for (uint32_t offset = sizeof(LV2_Atom_Object_Body);
+		     offset < atom->size;) {
+			const uint32_t space = atom->size - offset;
+			if (space < sizeof(LV2_Atom_Property_Body)) {
+				return false;
+			}
+			LV2_Atom_Property_Body* p = (LV2_Atom_Property_Body*)(body + offset);
+			p->key = func(p->key);
+			if (p->context) {
+				p->context = func(p->context);
+			}
+			if (!rewrite(&p->value,
+			             space - offsetof(LV2_Atom_Property_Body, value),
+			             func)) {
+				return false;
+			}
+			offset += lv2_atom_pad_size(sizeof(LV2_Atom_Property_Body) +
+			                            p->value.size);
+		}
+	} else if (atom->type == _atom_Tuple) {
+		for (uint32_t offset = 0; offset < atom->size;) {
+			LV2_Atom* child = (LV2_Atom*)(body + offset);
+			if (!rewrite(child, atom->size - offset, func)) {
+				return false;
+			}
+			offset += lv2_atom_pad_size(lv2_atom_total_size(child));
+		}
+	} else if (atom->type == _atom_Sequence) {
+		if (atom->size < sizeof(LV2_Atom_Sequence_Body)) {
+			return false;
+		}
+		LV2_Atom_Sequence* seq = (LV2_Atom_Sequence*)atom;
+		if (seq->body.unit) {
+			seq->body.unit = func(seq->body.unit);
+		}
+		for (uint32_t offset = sizeof(LV2_Atom_Sequence_Body);
+		     offset < atom->size;) {
+			const uint32_t space = atom->size - offset;
+			if (space < sizeof(LV2_Atom_Event)) {
+				return false;
+			}
+			LV2_Atom_Event* ev = (LV2_Atom_Event*)(body + offset);
+			if (!rewrite(&ev->body, space - offsetof(LV2_Atom_Event, body),
+			             func)) {
+				return false;
+			}
+			offset += lv2_atom_pad_size(sizeof(LV2_Atom_Event) + ev->body.size);
+		}
+	} else if (atom->type == _atom_Vector) {
+		if (atom->size < sizeof(LV2_Atom_Vector_Body)) {
+			return false;
+		}
+		LV2_Atom_Vector* vec = (LV2_Atom_Vector*)atom;
+		vec->body.child_type = func(vec->body.child_type);
+		if (vec->body.child_type == _atom_URID) {
+			if (vec->body.child_size != sizeof(LV2_URID)) {
+				return false;
+			}
+			LV2_URID*      children = (LV2_URID*)(vec + 1);
+			const uint32_t n_children =
+				(atom->size - sizeof(LV2_Atom_Vector_Body)) / sizeof(LV2_URID);
+			for (uint32_t i = 0; i < n_children; ++i) {
+				children[i] = func(children[i]);
+			}
+		}
+	} else if (atom->type == _atom_Literal) {
+		if (atom->size < sizeof(LV2_Atom_Literal_Body)) {
+			return false;
+		}
+		LV2_Atom_Literal* lit = (LV2_Atom_Literal*)atom;
+		if (lit->body.datatype) {
+			lit->body.datatype = func(lit->body.datatype);
+		}
+		if (lit->body.lang) {
+			lit->body.lang = func(lit->body.lang);
+		}
+	}
+
+	return true;
+}
+
+} // namespace ingen
@@ -0,0 +1,124 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+
+#include "ingen/Log.hpp"
+#include "ingen/ShmWriter.hpp"
+#include "ingen/URIMap.hpp"
+#include "lv2/atom/util.h"
+
+namespace ingen {
+
+/** Time to wait for space before checking if the ring has been closed. */
+static const int write_timeout_ms = 100;
+
+ShmWriter::ShmWriter(URIMap&          map,
+                     URIs&            uris,
+                     Log&             log,
+                     const URI&       uri,
+                     SPtr<ShmSegment> segment,
+                     ShmRing&         ring)
+	: AtomWriter(map, uris, *this)
+	, _uri_map(map)
+	, _log(log)
+	, _uri(uri)
+	, _segment(std::move(segment))
+	, _ring(ring)
+	, _rewriter(map)
+{}
+
+bool
+ShmWriter::write_record(const LV2_Atom* record)
+{
+	const uint32_t size = lv2_atom_pad_size(lv2_atom_total_size(record));
+	if (size > _ring.capacity()) {
+		_log.error(fmt("Message of %1% bytes is too large for shared memory\n")
+		           % size);
+		return false;
+	}
+
+	while (!_ring.closed()) {
+		const uint32_t seq = _ring.seq();
+		if (_ring.write(record)) {
+			return true;
+		}
+		_ring.wait(seq, write_timeout_ms);
+	}
+
+	return false;
+}
+
+/** Write the URI of `urid` if the reader has not seen it yet.
+ *
+ * The record is an atom with type 0, and a body of the URID followed by the
+ * null-terminated URI.
+ */
+bool
+ShmWriter::write_urid(LV2_URID urid)
+{
+	if (urid < _sent.size() && _sent[urid]) {
+		return true;
+	}
+
+	const char* const uri = _uri_map.unmap_uri(urid);
+	if (!uri) {
+		return true;  // Not a URID we know about, nothing to send
+	}
+
+	const uint32_t len = strlen(uri) + 1;
+	std::vector<uint64_t> buf(
+		(sizeof(LV2_Atom) + sizeof(LV2_URID) + len + 7) / sizeof(uint64_t));
+
+	LV2_Atom* record = (LV2_Atom*)buf.data();
+	record->size     = sizeof(LV2_URID) + len;
+	record->type     = 0;
+	memcpy(record + 1, &urid, sizeof(LV2_URID));
+	memcpy((uint8_t*)(record + 1) + sizeof(LV2_URID), uri, len);
+	if (!write_record(record)) {
+		return false;
+	}
+
+	if (urid >= _sent.size()) {
+		_sent.resize(urid + 1);
+	}
+	_sent[urid] = true;
+	return true;
+}
+
+bool
+ShmWriter::write(const LV2_Atom* msg, int32_t)
+{
+	// Copy message so URIDs can be visited with the rewriter
+	const uint32_t size = lv2_atom_total_size(msg);
+	_buf.resize(lv2_atom_pad_size(size) / sizeof(uint64_t));
+	memcpy(_buf.data(), msg, size);
+
+	// Send any URIDs that the reader does not know yet
+	bool       ok        = true;
+	const auto send_urid = [this, &ok](LV2_URID urid) {
+		ok = ok && write_urid(urid);
+		return urid;
+	};
+	if (!_rewriter.rewrite((LV2_Atom*)_buf.data(), size, send_urid)) {
+		_log.error("Refusing to send malformed message\n");
+		return false;
+	}
+
+	return ok && write_record(msg);
+}
+
+} // namespace ingen
@@ -14,9 +14,12 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cctype>
 #include <cerrno>
 
 #include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
 
 #include "ingen/AtomForgeSink.hpp"
 #include "ingen/AtomReader.hpp"
@@ -31,23 +34,44 @@
 
 namespace ingen {
 
+/** Maximum size of an incomplete message before the connection is dropped. */
+static const size_t max_message_size = 1 << 24;
+
 SocketReader::SocketReader(ingen::World&      world,
                            Interface&         iface,
-                           SPtr<Raul::Socket> sock)
+                           SPtr<Raul::Socket> sock,
+                           bool               threaded)
 	: _world(world)
 	, _iface(iface)
+	, _env(nullptr)
 	, _inserter(nullptr)
 	, _msg_node(nullptr)
+	, _base_uri(nullptr)
+	, _model(nullptr)
+	, _reader(nullptr)
+	, _sratom(nullptr)
 	, _socket(std::move(sock))
+	, _recv_pos(0)
+	, _scan_pos(0)
+	, _complete(0)
+	, _scan(Scan::NORMAL)
+	, _quote('"')
 	, _exit_flag(false)
-	, _thread(&SocketReader::run, this)
-{}
+{
+	open();
+	if (threaded) {
+		_thread = std::thread(&SocketReader::run, this);
+	}
+}
 
 SocketReader::~SocketReader()
 {
 	_exit_flag = true;
 	_socket->shutdown();
-	_thread.join();
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+	close();
 }
 
 SerdStatus
@@ -86,69 +110,275 @@ SocketReader::write_statement(SocketReader*      iface,
 		object_datatype, object_lang);
 }
 
+/** Read a byte for serd from the complete statements received so far.
+ *
+ * Returning zero tells serd that no more input is available for now.  The
+ * stream is resumed by reading the next chunk once more statements are
+ * complete.
+ */
+size_t
+SocketReader::c_recv(void* buf, size_t size, size_t nmemb, void* stream)
+{
+	SocketReader* const reader = (SocketReader*)stream;
+	if (reader->_recv_pos == reader->_complete) {
+		return 0;
+	}
+
+	*(char*)buf = reader->_input[reader->_recv_pos++];
+	return 1;
+}
+
+int
+SocketReader::c_error(void* stream)
+{
+	return 0;  // Only complete statements are parsed, so running out is fine
+}
+
+/** Receive all input that has arrived on the socket without blocking.
+ *
+ * @return False iff the connection has been lost.
+ */
+bool
+SocketReader::receive()
+{
+	const int fd = _socket->fd();
+
+	char buf[4096];
+	while (_input.size() < _complete + max_message_size) {
+		const ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+		if (n > 0) {
+			_input.insert(_input.end(), buf, buf + n);
+		} else if (n < 0 && errno == EINTR) {
+			continue;
+		} else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;  // Nothing more for now
+		} else {
+			return false;  // Closed or error
+		}
+	}
+
+	return true;
+}
+
+/** Return true iff `c` may continue a name or number after a '.'. */
+static inline bool
+is_name_char(const char c)
+{
+	return isalnum((unsigned char)c) || (unsigned char)c >= 0x80 ||
+	       c == '_' || c == '-' || c == ':' || c == '%';
+}
+
+/** Find the end of the last complete statement in the received input.
+ *
+ * Statements end at a '.' that is not in an IRI, string, or comment, and not
+ * part of a name or number.  The null byte sent after bundles also ends input.
+ * Scanning stops where more input is needed to decide, and resumes there.
+ */
 void
-SocketReader::run()
+SocketReader::scan()
 {
-	Sord::World*  world = _world.rdf_world();
-	LV2_URID_Map* map   = &_world.uri_map().urid_map_feature()->urid_map;
+	const size_t len = _input.size();
+	while (_scan_pos < len) {
+		const size_t i = _scan_pos;
+		const char   c = _input[i];
+		size_t       n = 1;  // Number of bytes scanned
+		switch (_scan) {
+		case Scan::NORMAL:
+			if (c == '<') {
+				_scan = Scan::IRI;
+			} else if (c == '"' || c == '\'') {
+				if (i + 2 >= len) {
+					return;  // Need more to tell if this starts a long string
+				} else if (_input[i + 1] == c && _input[i + 2] == c) {
+					_scan = Scan::LONG_STRING;
+					n     = 3;
+				} else {
+					_scan = Scan::STRING;
+				}
+				_quote = c;
+			} else if (c == '#') {
+				_scan = Scan::COMMENT;
+			} else if (c == '\0') {
+				_complete = i + 1;
+			} else if (c == '.') {
+				if (i + 1 >= len) {
+					return;  // Need more to tell if this ends a statement
+				} else if (!is_name_char(_input[i + 1])) {
+					_complete = i + 1;
+				}
+			}
+			break;
+		case Scan::IRI:
+			if (c == '>') {
+				_scan = Scan::NORMAL;
+			}
+			break;
+		case Scan::STRING:
+			if (c == '\\') {
+				n = 2;  // Skip escaped character
+			} else if (c == _quote) {
+				_scan = Scan::NORMAL;
+			}
+			break;
+		case Scan::LONG_STRING:
+			if (c == '\\') {
+				n = 2;  // Skip escaped character
+			} else if (c == _quote) {
+				if (i + 3 >= len) {
+					return;  // Need more to tell if this ends the string
+				} else if (_input[i + 1] == c && _input[i + 2] == c &&
+				           _input[i + 3] != c) {
+					_scan = Scan::NORMAL;
+					n     = 3;
+				}
+			}
+			break;
+		case Scan::COMMENT:
+			if (c == '\n' || c == '\r') {
+				_scan = Scan::NORMAL;
+			}
+			break;
+		}
 
-	// Open socket as a FILE for reading directly with serd
-	FILE* f = fdopen(_socket->fd(), "r");
-	if (!f) {
-		_world.log().error(fmt("Failed to open connection (%1%)\n")
-		                   % strerror(errno));
-		// Connection gone, exit
-		_socket.reset();
-		return;
+		if (i + n > len) {
+			return;  // Escape sequence is incomplete
+		}
+		_scan_pos = i + n;
 	}
+}
 
-	// Set up sratom and a forge to build LV2 atoms from model
-	Sratom*        sratom = sratom_new(map);
-	LV2_Atom_Forge forge;
-	lv2_atom_forge_init(&forge, map);
+void
+SocketReader::open()
+{
+	Sord::World*  world = _world.rdf_world();
+	LV2_URID_Map* map   = &_world.uri_map().urid_map_feature()->urid_map;
 
-	AtomForgeSink buffer(&forge);
+	// Set up sratom and a forge to build LV2 atoms from model
+	_sratom = sratom_new(map);
+	lv2_atom_forge_init(&_forge, map);
+	_buffer.set_forge_sink(&_forge);
 
-	SordNode*  base_uri = nullptr;
-	SordModel* model    = nullptr;
 	{
 		// Lock RDF world
 		std::lock_guard<std::mutex> lock(_world.rdf_mutex());
 
 		// Use <ingen:/> as base URI, so relative URIs are like bundle paths
-		base_uri = sord_new_uri(world->c_obj(), (const uint8_t*)"ingen:/");
+		_base_uri = sord_new_uri(world->c_obj(), (const uint8_t*)"ingen:/");
 
 		// Make a model and reader to parse the next Turtle message
-		_env = world->prefixes().c_obj();
-		model = sord_new(world->c_obj(), SORD_SPO, false);
+		_env   = world->prefixes().c_obj();
+		_model = sord_new(world->c_obj(), SORD_SPO, false);
 
 		// Create an inserter for writing incoming triples to model
-		_inserter = sord_inserter_new(model, _env);
+		_inserter = sord_inserter_new(_model, _env);
 	}
 
-	SerdReader* reader = serd_reader_new(
+	_reader = serd_reader_new(
 		SERD_TURTLE, this, nullptr,
 		(SerdBaseSink)set_base_uri,
 		(SerdPrefixSink)set_prefix,
 		(SerdStatementSink)write_statement,
 		nullptr);
 
-	serd_env_set_base_uri(_env, sord_node_to_serd_node(base_uri));
-	serd_reader_start_stream(reader, f, (const uint8_t*)"(socket)", false);
+	serd_env_set_base_uri(_env, sord_node_to_serd_node(_base_uri));
+	serd_reader_start_source_stream(
+		_reader, c_recv, c_error, this, (const uint8_t*)"(socket)", 1);
 
 	// Make an AtomReader to call Ingen Interface methods based on Atom
-	AtomReader ar(_world.uri_map(), _world.uris(), _world.log(), _iface);
+	_atom_reader = UPtr<AtomReader>(
+		new AtomReader(_world.uri_map(), _world.uris(), _world.log(), _iface));
+}
+
+void
+SocketReader::close()
+{
+	if (!_reader) {
+		return;
+	}
 
+	// Lock RDF world
+	std::lock_guard<std::mutex> lock(_world.rdf_mutex());
+
+	// Destroy everything
+	sord_inserter_free(_inserter);
+	serd_reader_end_stream(_reader);
+	sratom_free(_sratom);
+	serd_reader_free(_reader);
+	sord_free(_model);
+	sord_node_free(_world.rdf_world()->c_obj(), _base_uri);
+	if (_msg_node) {
+		sord_node_free(_world.rdf_world()->c_obj(), _msg_node);
+	}
+	_reader = nullptr;
+}
+
+bool
+SocketReader::read()
+{
+	// Receive everything that has arrived and find the complete statements
+	bool connected = receive();
+	scan();
+	if (_input.size() - _complete > max_message_size) {
+		_world.log().error("Message received from socket is too large\n");
+		return false;
+	}
+
+	if (_recv_pos < _complete) {
+		Sord::World* world = _world.rdf_world();
+
+		// Lock RDF world only while parsing
+		std::lock_guard<std::mutex> lock(_world.rdf_mutex());
+
+		while (_recv_pos < _complete) {
+			// Read until the next '.'
+			const size_t     start = _recv_pos;
+			const SerdStatus st  = serd_reader_read_chunk(_reader);
+			if (st > SERD_FAILURE) {
+				_world.log().error(fmt("Read error: %1%\n")
+				                   % serd_strerror(st));
+				if (_recv_pos == start) {
+					connected = false;  // Stuck on bad input, hang up
+					break;
+				}
+				continue;
+			} else if (st == SERD_FAILURE || !_msg_node) {
+				if (_recv_pos == start) {
+					break;  // Read nothing, should not happen
+				}
+				continue;  // Read nothing, e.g. just whitespace
+			}
+
+			// Build an LV2_Atom at chunk.buf from the message
+			sratom_read(_sratom, &_forge, world->c_obj(), _model, _msg_node);
+
+			// Call _iface methods based on atom content
+			_atom_reader->write(_buffer.atom());
+
+			// Reset everything for the next iteration
+			_buffer.clear();
+			sord_node_free(world->c_obj(), _msg_node);
+			_msg_node = nullptr;
+		}
+	}
+
+	// Drop parsed input
+	_input.erase(_input.begin(), _input.begin() + _recv_pos);
+	_scan_pos -= _recv_pos;
+	_complete -= _recv_pos;
+	_recv_pos  = 0;
+
+	return connected;
+}
+
+void
+SocketReader::run()
+{
 	struct pollfd pfd;
 	pfd.fd      = _socket->fd();
 	pfd.events  = POLLIN;
 	pfd.revents = 0;
 
 	while (!_exit_flag) {
-		if (feof(f)) {
-			break;  // Lost connection
-		}
-
 		// Wait for input to arrive at socket
 		int ret = poll(&pfd, 1, -1);
 		if (ret == -1 || (pfd.revents & (POLLERR|POLLHUP|POLLNVAL))) {
@@ -158,42 +388,11 @@ SocketReader::run()
 			continue;  // No data, shouldn't happen
 		}
 
-		// Lock RDF world
-		std::lock_guard<std::mutex> lock(_world.rdf_mutex());
-
-		// Read until the next '.'
-		SerdStatus st = serd_reader_read_chunk(reader);
-		if (st == SERD_FAILURE || !_msg_node) {
-			continue;  // Read nothing, e.g. just whitespace
-		} else if (st) {
-			_world.log().error(fmt("Read error: %1%\n")
-			                   % serd_strerror(st));
-			continue;
+		if (!read()) {
+			on_hangup();
+			break;  // Lost connection
 		}
-
-		// Build an LV2_Atom at chunk.buf from the message
-		sratom_read(sratom, &forge, world->c_obj(), model, _msg_node);
-
-		// Call _iface methods based on atom content
-		ar.write(buffer.atom());
-
-		// Reset everything for the next iteration
-		buffer.clear();
-		sord_node_free(world->c_obj(), _msg_node);
-		_msg_node = nullptr;
 	}
-
-	// Lock RDF world
-	std::lock_guard<std::mutex> lock(_world.rdf_mutex());
-
-	// Destroy everything
-	fclose(f);
-	sord_inserter_free(_inserter);
-	serd_reader_end_stream(reader);
-	sratom_free(sratom);
-	serd_reader_free(reader);
-	sord_free(model);
-	_socket.reset();
 }
 
 }  // namespace ingen
@@ -14,7 +14,10 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cassert>
+#include <iterator>
 #include <sstream>
+#include <utility>
 
 #include "ingen/Node.hpp"
 #include "ingen/Store.hpp"
@@ -28,46 +31,45 @@ Store::add(Node* o)
 		return;
 	}
 
-	emplace(o->path(), SPtr<Node>(o));
+	add_node(SPtr<Node>(o));
 
 	for (uint32_t i = 0; i < o->num_ports(); ++i) {
 		add(o->port(i));
 	}
 }
 
-/*
-  TODO: These methods are currently O(n_children) but should logarithmic.  The
-  std::map methods do not allow passing a comparator, but std::upper_bound
-  does.  This should be achievable by making a rooted comparator that is a
-  normal ordering except compares a special sentinel value as the greatest
-  element that is a child of the parent.  Searching for this sentinel should
-  then find the end of the descendants in logarithmic time.
-*/
+void
+Store::add_node(SPtr<Node> node)
+{
+	const Raul::Path& path = node->path();
+	if (_index.find(path) == _index.end()) {
+		_index.emplace(path, emplace(path, std::move(node)).first);
+	}
+}
+
+/* Descendants of a path P are exactly the paths that start with "P/".  Since
+   '0' follows '/' and precedes every other character allowed in a symbol,
+   "P0" sorts after every descendant and before any other path greater than P,
+   so the end of the descendants can be found with a binary search. */
 
 Store::iterator
 Store::find_descendants_end(const iterator parent)
 {
-	iterator descendants_end = parent;
-	++descendants_end;
-	while (descendants_end != end() &&
-	       descendants_end->first.is_child_of(parent->first)) {
-		++descendants_end;
+	if (parent == end() || parent->first.is_root()) {
+		return end();
 	}
 
-	return descendants_end;
+	return lower_bound(Raul::Path(parent->first + '0'));
 }
 
 Store::const_iterator
 Store::find_descendants_end(const const_iterator parent) const
 {
-	const_iterator descendants_end = parent;
-	++descendants_end;
-	while (descendants_end != end() &&
-	       descendants_end->first.is_child_of(parent->first)) {
-		++descendants_end;
+	if (parent == end() || parent->first.is_root()) {
+		return end();
 	}
 
-	return descendants_end;
+	return lower_bound(Raul::Path(parent->first + '0'));
 }
 
 Store::const_range
@@ -87,6 +89,9 @@ Store::remove(const iterator top, Objects& removed)
 {
 	if (top != end()) {
 		const iterator descendants_end = find_descendants_end(top);
+		for (iterator i = top; i != descendants_end; ++i) {
+			_index.erase(i->first);
+		}
 		removed.insert(top, descendants_end);
 		erase(top, descendants_end);
 	}
@@ -101,7 +106,9 @@ Store::rename(const iterator top, const Raul::Path& new_path)
 	Objects removed;
 	remove(top, removed);
 
-	// Rename all the removed objects
+	/* Rename all the removed objects.  Replacing the prefix does not change
+	   their order, so each is inserted directly after the previous one. */
+	iterator hint = lower_bound(new_path);
 	for (Objects::const_iterator i = removed.begin(); i != removed.end(); ++i) {
 		const Raul::Path path = (i->first == old_path)
 			? new_path
@@ -110,10 +117,19 @@ Store::rename(const iterator top, const Raul::Path& new_path)
 
 		i->second->set_path(path);
 		assert(find(path) == end());  // Shouldn't be dropping objects!
-		emplace(path, i->second);
+		const iterator inserted = emplace_hint(hint, path, i->second);
+		_index.emplace(path, inserted);
+		hint = std::next(inserted);
 	}
 }
 
+void
+Store::clear()
+{
+	_index.clear();
+	std::map< const Raul::Path, SPtr<Node> >::clear();
+}
+
 unsigned
 Store::child_name_offset(const Raul::Path&   parent,
                          const Raul::Symbol& symbol,
@@ -79,7 +79,7 @@ URI::operator=(const URI& uri)
 	return *this;
 }
 
-URI::URI(URI&& uri)
+URI::URI(URI&& uri) noexcept
     : _node(uri._node)
     , _uri(uri._uri)
 {
@@ -88,8 +88,13 @@ URI::URI(URI&& uri)
 }
 
 URI&
-URI::operator=(URI&& uri)
+URI::operator=(URI&& uri) noexcept
 {
+	if (&uri == this) {
+		return *this;
+	}
+
+	serd_node_free(&_node);
 	_node     = uri._node;
 	_uri      = uri._uri;
 	uri._node = SERD_NODE_NULL;
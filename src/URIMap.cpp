@@ -15,6 +15,7 @@
 */
 
 #include <cstdint>
+#include <cstring>
 
 #include "ingen/Log.hpp"
 #include "ingen/URI.hpp"
@@ -22,10 +23,135 @@
 
 namespace ingen {
 
+/** Initial number of hash table slots, must be a power of two. */
+static const uint32_t initial_table_size = 1024;
+
 URIMap::URIMap(Log& log, LV2_URID_Map* map, LV2_URID_Unmap* unmap)
 	: _urid_map_feature(new URIDMapFeature(this, map, log))
 	, _urid_unmap_feature(new URIDUnmapFeature(this, unmap))
+	, _table(new Table(initial_table_size))
+	, _size(0)
+{
+	_tables.emplace_back(_table.load());
+}
+
+URIMap::Table::Table(uint32_t size)
+	: mask(size - 1)
+	, slots(new std::atomic<uint64_t>[size])
+{
+	for (uint32_t i = 0; i < size; ++i) {
+		slots[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+uint32_t
+URIMap::hash(const char* uri)
+{
+	// 32-bit FNV-1a
+	uint32_t h = 2166136261u;
+	for (const char* c = uri; *c; ++c) {
+		h = (h ^ (uint8_t)*c) * 16777619u;
+	}
+	return h;
+}
+
+void
+URIMap::locate(uint32_t index, uint32_t& chunk, uint32_t& offset)
+{
+	chunk = 0;
+	uint32_t start = 0;
+	uint32_t size  = first_chunk_size;
+	while (index >= start + size) {
+		start += size;
+		size  *= 2;
+		++chunk;
+	}
+	offset = index - start;
+}
+
+LV2_URID
+URIMap::find(const char* uri, uint32_t hash) const
+{
+	const Table* const table = _table.load(std::memory_order_acquire);
+	for (uint32_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+		const uint64_t slot = table->slots[i].load(std::memory_order_acquire);
+		if (!slot) {
+			return 0;
+		} else if ((uint32_t)(slot >> 32) == hash) {
+			const LV2_URID urid = (LV2_URID)(slot & 0xFFFFFFFF);
+			if (!strcmp(lookup(urid), uri)) {
+				return urid;
+			}
+		}
+	}
+}
+
+LV2_URID
+URIMap::insert(const char* uri, uint32_t hash)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// Another thread may have added this URI since the caller searched
+	const LV2_URID found = find(uri, hash);
+	if (found) {
+		return found;
+	}
+
+	// Store the URI where it will never move
+	const LV2_URID urid = _size.load(std::memory_order_relaxed) + 1;
+	uint32_t       chunk  = 0;
+	uint32_t       offset = 0;
+	locate(urid - 1, chunk, offset);
+	if (chunk >= n_chunks) {
+		return 0;
+	} else if (!_chunks[chunk]) {
+		_chunks[chunk] = UPtr<std::string[]>(
+			new std::string[first_chunk_size << chunk]);
+	}
+	_chunks[chunk][offset] = uri;
+	_size.store(urid, std::memory_order_release);
+
+	// Replace the table with a larger copy if it would be over half full
+	Table* table = _table.load(std::memory_order_relaxed);
+	if (urid * 2 > table->mask + 1) {
+		Table* const bigger = new Table((table->mask + 1) * 2);
+		for (uint32_t i = 0; i <= table->mask; ++i) {
+			const uint64_t slot = table->slots[i].load(std::memory_order_relaxed);
+			if (slot) {
+				uint32_t j = (uint32_t)(slot >> 32) & bigger->mask;
+				while (bigger->slots[j].load(std::memory_order_relaxed)) {
+					j = (j + 1) & bigger->mask;
+				}
+				bigger->slots[j].store(slot, std::memory_order_relaxed);
+			}
+		}
+		_tables.emplace_back(bigger);
+		_table.store(bigger, std::memory_order_release);
+		table = bigger;
+	}
+
+	// Publish the URID
+	uint32_t i = hash & table->mask;
+	while (table->slots[i].load(std::memory_order_relaxed)) {
+		i = (i + 1) & table->mask;
+	}
+	table->slots[i].store(((uint64_t)hash << 32) | urid,
+	                      std::memory_order_release);
+
+	return urid;
+}
+
+const char*
+URIMap::lookup(LV2_URID urid) const
 {
+	if (urid == 0 || urid > _size.load(std::memory_order_acquire)) {
+		return nullptr;
+	}
+
+	uint32_t chunk  = 0;
+	uint32_t offset = 0;
+	locate(urid - 1, chunk, offset);
+	return _chunks[chunk][offset].c_str();
 }
 
 URIMap::URIDMapFeature::URIDMapFeature(URIMap*       map,
@@ -46,23 +172,25 @@ LV2_URID
 URIMap::URIDMapFeature::default_map(LV2_URID_Map_Handle h,
                                     const char*         c_uri)
 {
-	URIMap* const               map((URIMap*)h);
-	std::string                 uri(c_uri);
-	std::lock_guard<std::mutex> lock(map->_mutex);
-
-	auto       record = map->_map.emplace(uri, map->_map.size() + 1);
-	const auto id     = record.first->second;
-	if (record.second) {
-		assert(id == map->_map.size());
-		assert(id == map->_unmap.size() + 1);
-		map->_unmap.emplace_back(std::move(uri));
-	}
-	return id;
+	URIMap* const  map(static_cast<URIMap*>(h));
+	const uint32_t hash = URIMap::hash(c_uri);
+	const LV2_URID urid = map->find(c_uri, hash);
+
+	return urid ? urid : map->insert(c_uri, hash);
 }
 
 LV2_URID
 URIMap::URIDMapFeature::map(const char* uri)
 {
+	if (urid_map.map == default_map) {
+		// Known URIs were checked when they were added
+		URIMap* const  map  = static_cast<URIMap*>(urid_map.handle);
+		const LV2_URID urid = map->find(uri, URIMap::hash(uri));
+		if (urid) {
+			return urid;
+		}
+	}
+
 	if (!URI::is_valid(uri)) {
 		log.error(fmt("Attempt to map invalid URI <%1%>\n") % uri);
 		return 0;
@@ -86,12 +214,7 @@ const char*
 URIMap::URIDUnmapFeature::default_unmap(LV2_URID_Unmap_Handle h,
                                         LV2_URID              urid)
 {
-	URIMap* const               map((URIMap*)h);
-	std::lock_guard<std::mutex> lock(map->_mutex);
-
-	return (urid > 0 && urid <= map->_unmap.size()
-	        ? map->_unmap[urid - 1].c_str()
-	        : nullptr);
+	return static_cast<const URIMap*>(h)->lookup(urid);
 }
 
 const char*
@@ -97,24 +97,42 @@ URIs::URIs(Forge& forge, URIMap* map, LilvWorld* lworld)
 	, ingen_broadcast       (forge, map, lworld, INGEN__broadcast)
 	, ingen_canvasX         (forge, map, lworld, INGEN__canvasX)
 	, ingen_canvasY         (forge, map, lworld, INGEN__canvasY)
+	, ingen_droppedMessages (forge, map, lworld, INGEN__droppedMessages)
 	, ingen_enabled         (forge, map, lworld, INGEN__enabled)
 	, ingen_externalContext (forge, map, lworld, INGEN__externalContext)
 	, ingen_file            (forge, map, lworld, INGEN__file)
+	, ingen_filterProperty  (forge, map, lworld, INGEN__filterProperty)
+	, ingen_flightRecord    (forge, map, lworld, INGEN__flightRecord)
 	, ingen_head            (forge, map, lworld, INGEN__head)
 	, ingen_incidentTo      (forge, map, lworld, INGEN__incidentTo)
 	, ingen_internalContext (forge, map, lworld, INGEN__internalContext)
 	, ingen_loadedBundle    (forge, map, lworld, INGEN__loadedBundle)
+	, ingen_maxLatency      (forge, map, lworld, INGEN__maxLatency)
+	, ingen_maxQueueLength  (forge, map, lworld, INGEN__maxQueueLength)
 	, ingen_maxRunLoad      (forge, map, lworld, INGEN__maxRunLoad)
 	, ingen_meanRunLoad     (forge, map, lworld, INGEN__meanRunLoad)
+	, ingen_medianLatency   (forge, map, lworld, INGEN__medianLatency)
+	, ingen_mergedMessages  (forge, map, lworld, INGEN__mergedMessages)
+	, ingen_mergedUpdates   (forge, map, lworld, INGEN__mergedUpdates)
 	, ingen_minRunLoad      (forge, map, lworld, INGEN__minRunLoad)
 	, ingen_numThreads      (forge, map, lworld, INGEN__numThreads)
+	, ingen_overruns        (forge, map, lworld, INGEN__overruns)
 	, ingen_polyphonic      (forge, map, lworld, INGEN__polyphonic)
 	, ingen_polyphony       (forge, map, lworld, INGEN__polyphony)
 	, ingen_prototype       (forge, map, lworld, INGEN__prototype)
+	, ingen_queueLength     (forge, map, lworld, INGEN__queueLength)
+	, ingen_shallow         (forge, map, lworld, INGEN__shallow)
+	, ingen_sharedMemory    (forge, map, lworld, INGEN__sharedMemory)
+	, ingen_slowestBlock    (forge, map, lworld, INGEN__slowestBlock)
 	, ingen_sprungLayout    (forge, map, lworld, INGEN__sprungLayout)
+	, ingen_subscribe       (forge, map, lworld, INGEN__subscribe)
 	, ingen_tail            (forge, map, lworld, INGEN__tail)
+	, ingen_tailLatency     (forge, map, lworld, INGEN__tailLatency)
 	, ingen_uiEmbedded      (forge, map, lworld, INGEN__uiEmbedded)
+	, ingen_undoMemory      (forge, map, lworld, INGEN__undoMemory)
+	, ingen_updateRate      (forge, map, lworld, INGEN__updateRate)
 	, ingen_value           (forge, map, lworld, INGEN__value)
+	, ingen_xruns           (forge, map, lworld, INGEN__xruns)
 	, log_Error             (forge, map, lworld, LV2_LOG__Error)
 	, log_Note              (forge, map, lworld, LV2_LOG__Note)
 	, log_Trace             (forge, map, lworld, LV2_LOG__Trace)
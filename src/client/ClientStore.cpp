@@ -67,13 +67,13 @@ ClientStore::add_object(SPtr<ObjectModel> object)
 				parent->add_child(object);
 				assert(parent && (object->parent() == parent));
 
-				(*this)[object->path()] = object;
+				add_node(object);
 				_signal_new_object.emit(object);
 			} else {
 				_log.error(fmt("Object %1% with no parent\n") % object->path());
 			}
 		} else {
-			(*this)[object->path()] = object;
+			add_node(object);
 			_signal_new_object.emit(object);
 		}
 	}
@@ -273,7 +273,9 @@ ClientStore::operator()(const Put& msg)
 		}
 	}
 
-	if (!uri_is_path(uri)) {
+	if (uri_is_engine(uri)) {
+		return;  // Engine status, not part of the model
+	} else if (!uri_is_path(uri)) {
 		_log.error(fmt("Put for unknown subject <%1%>\n")
 		           % uri.c_str());
 		return;
@@ -342,6 +344,8 @@ ClientStore::operator()(const Delta& msg)
 	if (uri == URI("ingen:/clients/this")) {
 		// Client property, which we don't store (yet?)
 		return;
+	} else if (uri_is_engine(uri)) {
+		return;  // Engine status, not part of the model
 	}
 
 	if (!uri_is_path(uri)) {
@@ -70,6 +70,12 @@ class Port;
 
 Gtk::Main* App::_main = nullptr;
 
+/** Maximum number of queued messages to handle in one main iteration. */
+static const size_t max_messages_per_iteration = 4096;
+
+/** Number of queued messages beyond which new peak updates are dropped. */
+static const size_t max_queued_messages = 65536;
+
 App::App(ingen::World* world)
 	: _style(new Style(*this))
 	, _about_dialog(nullptr)
@@ -168,6 +174,15 @@ App::attach(SPtr<ingen::Interface> client)
 		_world->engine()->register_client(client);
 	}
 
+	SPtr<QueuedInterface> qi = dynamic_ptr_cast<QueuedInterface>(client);
+	if (qi) {
+		// Only the latest control value or peak of each port matters
+		const URIs& uris = _world->uris();
+		qi->coalesce(uris.ingen_value, uris.atom_Float, false);
+		qi->coalesce(uris.ingen_activity, uris.atom_Float, true);
+		qi->set_capacity(max_queued_messages);
+	}
+
 	_client = client;
 	_store  = SPtr<ClientStore>(new ClientStore(_world->uris(), _world->log(), sig_client()));
 	_loader = SPtr<ThreadedLoader>(new ThreadedLoader(*this, _world->interface()));
@@ -275,7 +290,7 @@ App::set_property(const URI&      subject,
 	   went as planned here and fire the signal ourselves as if the server
 	   feedback came back immediately. */
 	if (key != uris().ingen_activity) {
-		sig_client()->signal_message().emit(SetProperty{0, subject, key, value, ctx});
+		sig_client()->signal_message().emit(SetProperty{0, subject, key, value, ctx, 0});
 	}
 }
 
@@ -427,7 +442,8 @@ App::gtk_main_iteration()
 			return false;
 		}
 	} else {
-		dynamic_ptr_cast<QueuedInterface>(_client)->emit();
+		dynamic_ptr_cast<QueuedInterface>(_client)->emit(
+			max_messages_per_iteration);
 	}
 	_enable_signal = true;
 
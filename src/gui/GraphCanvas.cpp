@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <map>
 #include <set>
 #include <string>
@@ -61,6 +62,9 @@ using namespace client;
 
 namespace gui {
 
+/** Minimum zoom at which embedded plugin GUIs are created. */
+static const double min_gui_zoom = 0.5;
+
 static int
 port_order(const GanvPort* a, const GanvPort* b, void* data)
 {
@@ -176,6 +180,13 @@ GraphCanvas::GraphCanvas(App&                   app,
 	set_port_order(port_order, nullptr);
 }
 
+GraphCanvas::~GraphCanvas()
+{
+	_pending_guis_expose_connection.disconnect();
+	_pending_guis_idle_connection.disconnect();
+	_first_frame_connection.disconnect();
+}
+
 void
 GraphCanvas::show_menu(bool position, unsigned button, uint32_t time)
 {
@@ -237,13 +248,19 @@ GraphCanvas::build_menus()
 void
 GraphCanvas::build()
 {
-	const Store::const_range kids = _app.store()->children_range(_graph);
+	const SPtr<const Store> store = _app.store();
+	const Store::const_range kids = store->children_range(_graph);
 
-	// Create modules for blocks
-	for (Store::const_iterator i = kids.first; i != kids.second; ++i) {
+	_build_start = std::chrono::steady_clock::now();
+
+	// Create modules for blocks, skipping over everything inside them
+	for (Store::const_iterator i = kids.first; i != kids.second;) {
 		SPtr<BlockModel> block = dynamic_ptr_cast<BlockModel>(i->second);
 		if (block && block->parent() == _graph) {
 			add_block(block);
+			i = store->find_descendants_end(i);
+		} else {
+			++i;
 		}
 	}
 
@@ -256,6 +273,118 @@ GraphCanvas::build()
 	for (const auto& a : _graph->arcs()) {
 		connection(dynamic_ptr_cast<ArcModel>(a.second));
 	}
+
+	if (_app.world()->conf().option("gui-timing").get<int32_t>()) {
+		const std::chrono::duration<double> elapsed =
+			std::chrono::steady_clock::now() - _build_start;
+
+		_app.log().info(fmt("Built %1% with %2% blocks in %3% s\n")
+		                % _graph->path() % _views.size() % elapsed.count());
+
+		_first_frame_connection = widget().signal_expose_event().connect(
+			sigc::mem_fun(this, &GraphCanvas::on_first_frame), true);
+	}
+}
+
+bool
+GraphCanvas::on_first_frame(GdkEventExpose* ev)
+{
+	const std::chrono::duration<double> elapsed =
+		std::chrono::steady_clock::now() - _build_start;
+
+	_app.log().info(fmt("Drew first frame of %1% after %2% s\n")
+	                % _graph->path() % elapsed.count());
+
+	_first_frame_connection.disconnect();
+	return false;
+}
+
+void
+GraphCanvas::embed_when_visible(NodeModule* module)
+{
+	_pending_guis.insert(module);
+	if (!_pending_guis_expose_connection.connected()) {
+		// Check again whenever the canvas is redrawn by scrolling or zooming
+		_pending_guis_expose_connection = widget().signal_expose_event().connect(
+			sigc::mem_fun(this, &GraphCanvas::on_pending_guis_expose), false);
+	}
+
+	embed_visible();
+}
+
+void
+GraphCanvas::cancel_embed(NodeModule* module)
+{
+	if (_pending_guis.erase(module) && _pending_guis.empty()) {
+		_pending_guis_expose_connection.disconnect();
+		_pending_guis_idle_connection.disconnect();
+	}
+}
+
+bool
+GraphCanvas::on_pending_guis_expose(GdkEventExpose* ev)
+{
+	if (!_pending_guis_idle_connection.connected()) {
+		// Check once after drawing, however many exposes there are
+		_pending_guis_idle_connection = Glib::signal_idle().connect(
+			sigc::mem_fun(this, &GraphCanvas::embed_visible),
+			G_PRIORITY_DEFAULT_IDLE);
+	}
+
+	return false;
+}
+
+/** Return true if any part of `module` is within the visible canvas area. */
+bool
+GraphCanvas::is_visible(Ganv::Module& module)
+{
+	int scroll_x = 0;
+	int scroll_y = 0;
+	get_scroll_offsets(scroll_x, scroll_y);
+
+	const Gtk::Allocation alloc = widget().get_allocation();
+	const double          zoom  = ganv_canvas_get_zoom(gobj());
+	const double          x1    = scroll_x / zoom;
+	const double          y1    = scroll_y / zoom;
+	const double          x2    = (scroll_x + alloc.get_width()) / zoom;
+	const double          y2    = (scroll_y + alloc.get_height()) / zoom;
+
+	return (module.get_x() + module.get_width() >= x1 &&
+	        module.get_y() + module.get_height() >= y1 &&
+	        module.get_x() <= x2 &&
+	        module.get_y() <= y2);
+}
+
+/** Embed pending GUIs that are visible, as a one-shot idle callback. */
+bool
+GraphCanvas::embed_visible()
+{
+	if (ganv_canvas_get_zoom(gobj()) < min_gui_zoom) {
+		return false;  // Too small to be useful, wait for a zoom
+	}
+
+	for (auto i = _pending_guis.begin(); i != _pending_guis.end();) {
+		NodeModule* const module = *i;
+		if (is_visible(*module)) {
+			i = _pending_guis.erase(i);
+			module->embed_gui(true);
+		} else {
+			++i;
+		}
+	}
+
+	if (_pending_guis.empty()) {
+		_pending_guis_expose_connection.disconnect();
+		if (_app.world()->conf().option("gui-timing").get<int32_t>()) {
+			const std::chrono::duration<double> elapsed =
+				std::chrono::steady_clock::now() - _build_start;
+
+			_app.log().info(fmt("Embedded all pending GUIs in %1% after %2% s\n")
+			                % _graph->path() % elapsed.count());
+		}
+	}
+
+	return false;
 }
 
 static void
@@ -350,6 +479,8 @@ GraphCanvas::remove_block(SPtr<const BlockModel> bm)
 	auto i = _views.find(bm);
 
 	if (i != _views.end()) {
+		cancel_embed(dynamic_cast<NodeModule*>(i->second));
+
 		const guint n_ports = i->second->num_ports();
 		for (gint p = n_ports - 1; p >= 0; --p) {
 			delete i->second->get_port(p);
@@ -17,6 +17,7 @@
 #ifndef INGEN_GUI_GRAPHCANVAS_HPP
 #define INGEN_GUI_GRAPHCANVAS_HPP
 
+#include <chrono>
 #include <string>
 #include <map>
 #include <set>
@@ -42,6 +43,12 @@ class NodeModule;
 class PluginMenu;
 
 /** Graph canvas widget.
+ *
+ * Every block and arc in the graph has a view on the canvas, created when the
+ * canvas is built, but embedded plugin GUIs are only created once they are
+ * scrolled into view at a readable zoom.  Modules are not virtualised: Ganv
+ * sizes the scrollable area and fits the zoom to the items that exist, and
+ * arcs need the port items at both ends, so every module is created up front.
  *
  * \ingroup GUI
  */
@@ -53,7 +60,7 @@ public:
 	            int                            width,
 	            int                            height);
 
-	virtual ~GraphCanvas() {}
+	virtual ~GraphCanvas();
 
 	App& app() { return _app; }
 
@@ -80,6 +87,12 @@ public:
 
 	void show_menu(bool position, unsigned button, uint32_t time);
 
+	/** Embed the GUI of `module` once it is visible at a readable zoom. */
+	void embed_when_visible(NodeModule* module);
+
+	/** Forget a pending GUI embed for `module`, if any. */
+	void cancel_embed(NodeModule* module);
+
 	bool on_event(GdkEvent* event);
 
 private:
@@ -109,6 +122,11 @@ private:
 
 	Ganv::Port* get_port_view(SPtr<client::PortModel> port);
 
+	bool is_visible(Ganv::Module& module);
+	bool embed_visible();
+	bool on_pending_guis_expose(GdkEventExpose* ev);
+	bool on_first_frame(GdkEventExpose* ev);
+
 	void connect(Ganv::Node* tail,
 	             Ganv::Node* head);
 
@@ -131,6 +149,15 @@ private:
 	// Track pasted objects so they can be selected when they arrive
 	std::set<Raul::Path> _pastees;
 
+	// Modules with a GUI to embed when they are scrolled into view
+	std::set<NodeModule*> _pending_guis;
+	sigc::connection      _pending_guis_expose_connection;
+	sigc::connection      _pending_guis_idle_connection;
+
+	// Time of build for reporting the time to the first frame
+	std::chrono::steady_clock::time_point _build_start;
+	sigc::connection                      _first_frame_connection;
+
 	Gtk::Menu*          _menu;
 	Gtk::Menu*          _internal_menu;
 	PluginMenu*         _plugin_menu;
@@ -108,8 +108,11 @@ NodeModule::idle_init()
 		return true;  // Need to embed GUI, but ports haven't shown up yet
 	}
 
-	// Ports have arrived, embed GUI and deregister this callback
-	embed_gui(true);
+	// Ports have arrived, embed GUI when visible if it is still wanted
+	if (_block->has_property(app().uris().ingen_uiEmbedded,
+	                         app().uris().forge.make(true))) {
+		static_cast<GraphCanvas*>(canvas())->embed_when_visible(this);
+	}
 	_initialised = true;
 	return false;
 }
@@ -251,6 +254,9 @@ NodeModule::on_embed_gui_toggled(bool embed)
 void
 NodeModule::embed_gui(bool embed)
 {
+	// Embedding or removing the GUI now supersedes any pending embed
+	static_cast<GraphCanvas*>(canvas())->cancel_embed(this);
+
 	if (embed) {
 		if (_gui_window) {
 			app().log().warn("LV2 GUI already popped up, cannot embed\n");
@@ -474,6 +480,8 @@ NodeModule::property_changed(const URI& key, const Atom& value)
 				embed_gui(true);
 			} else if (!value.get<int32_t>() && _gui_widget) {
 				embed_gui(false);
+			} else if (!value.get<int32_t>()) {
+				static_cast<GraphCanvas*>(canvas())->cancel_embed(this);
 			}
 		} else if (key == uris.ingen_enabled) {
 			if (value.get<int32_t>()) {
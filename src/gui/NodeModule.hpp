@@ -64,6 +64,8 @@ public:
 
 	SPtr<const client::BlockModel> block() const { return _block; }
 
+	void embed_gui(bool embed);
+
 protected:
 	NodeModule(GraphCanvas& canvas, SPtr<const client::BlockModel> block);
 
@@ -73,7 +75,6 @@ protected:
 	bool on_event(GdkEvent* ev) override;
 
 	void on_embed_gui_toggled(bool embed);
-	void embed_gui(bool embed);
 	bool popup_gui();
 	void on_gui_window_close();
 	bool on_selected(gboolean selected) override;
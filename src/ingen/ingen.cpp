@@ -37,6 +37,9 @@
 #include "ingen/types.hpp"
 #ifdef HAVE_SOCKET
 #include "ingen/client/SocketClient.hpp"
+#ifdef HAVE_SHM_OPEN
+#include "ingen/client/ShmClient.hpp"
+#endif
 #endif
 
 using namespace std;
@@ -64,6 +67,14 @@ ingen_interrupt(int signal)
 	}
 }
 
+static void
+ingen_write_trace(int signal)
+{
+	if (world && world->engine()) {
+		world->engine()->request_trace();
+	}
+}
+
 static void
 ingen_try(bool cond, const char* msg)
 {
@@ -129,6 +140,9 @@ main(int argc, char** argv)
 
 #ifdef HAVE_SOCKET
 	client::SocketClient::register_factories(world.get());
+#ifdef HAVE_SHM_OPEN
+	client::ShmClient::register_factories(world.get());
+#endif
 #endif
 
 	// Load GUI if requested
@@ -156,7 +170,13 @@ main(int argc, char** argv)
 
 	// Activate the engine, if we have one
 	if (world->engine()) {
-		if (!world->load_module("jack") && !world->load_module("portaudio")) {
+		if (conf.option("null-driver").get<int32_t>()) {
+			if (!world->load_module("null")) {
+				cerr << "ingen: error: Failed to load null driver module" << endl;
+				return EXIT_FAILURE;
+			}
+		} else if (!world->load_module("jack") &&
+		           !world->load_module("portaudio")) {
 			cerr << "ingen: error: Failed to load driver module" << endl;
 			return EXIT_FAILURE;
 		}
@@ -235,6 +255,9 @@ main(int argc, char** argv)
 	// Set up signal handlers that will set quit_flag on interrupt
 	signal(SIGINT, ingen_interrupt);
 	signal(SIGTERM, ingen_interrupt);
+#ifdef SIGUSR1
+	signal(SIGUSR1, ingen_write_trace);
+#endif
 
 	if (conf.option("gui").get<int32_t>()) {
 		world->run_module("gui");
@@ -23,7 +23,11 @@
 #include "ingen/World.hpp"
 #include "internals/BlockDelay.hpp"
 #include "internals/Controller.hpp"
+#include "internals/Crossfade.hpp"
+#include "internals/Gain.hpp"
+#include "internals/Mixer.hpp"
 #include "internals/Note.hpp"
+#include "internals/Pan.hpp"
 #include "internals/Time.hpp"
 #include "internals/Trigger.hpp"
 
@@ -116,9 +120,21 @@ BlockFactory::load_internal_plugins()
 	InternalPlugin* controller_plug = ControllerNode::internal_plugin(uris);
 	_plugins.emplace(controller_plug->uri(), controller_plug);
 
+	InternalPlugin* crossfade_plug = CrossfadeNode::internal_plugin(uris);
+	_plugins.emplace(crossfade_plug->uri(), crossfade_plug);
+
+	InternalPlugin* gain_plug = GainNode::internal_plugin(uris);
+	_plugins.emplace(gain_plug->uri(), gain_plug);
+
+	InternalPlugin* mixer_plug = MixerNode::internal_plugin(uris);
+	_plugins.emplace(mixer_plug->uri(), mixer_plug);
+
 	InternalPlugin* note_plug = NoteNode::internal_plugin(uris);
 	_plugins.emplace(note_plug->uri(), note_plug);
 
+	InternalPlugin* pan_plug = PanNode::internal_plugin(uris);
+	_plugins.emplace(pan_plug->uri(), pan_plug);
+
 	InternalPlugin* time_plug = TimeNode::internal_plugin(uris);
 	_plugins.emplace(time_plug->uri(), time_plug);
 
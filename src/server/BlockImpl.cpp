@@ -40,6 +40,7 @@ BlockImpl::BlockImpl(PluginImpl*         plugin,
 	, _plugin(plugin)
 	, _polyphony((polyphonic && parent) ? parent->internal_poly() : 1)
 	, _mark(Mark::UNVISITED)
+	, _urid(plugin->uris().forge.make_urid(uri()).get<int32_t>())
 	, _polyphonic(polyphonic)
 	, _activated(false)
 	, _enabled(true)
@@ -59,6 +60,13 @@ BlockImpl::~BlockImpl()
 	}
 }
 
+void
+BlockImpl::set_path(const Raul::Path& new_path)
+{
+	NodeImpl::set_path(new_path);
+	_urid = uris().forge.make_urid(uri()).get<int32_t>();
+}
+
 Node*
 BlockImpl::port(uint32_t index) const
 {
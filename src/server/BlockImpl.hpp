@@ -101,6 +101,12 @@ public:
 	/** Enable or disable (bypass) this block. */
 	void set_enabled(bool e) { _enabled = e; }
 
+	/** Rename, and map the new URI for identifying this block in traces. */
+	void set_path(const Raul::Path& new_path) override;
+
+	/** Return the URID of this block's URI. */
+	LV2_URID urid() const { return _urid; }
+
 	/** Load a preset from the world for this block. */
 	virtual LilvState* load_preset(const URI& uri) { return nullptr; }
 
@@ -197,6 +203,7 @@ protected:
 	std::set<BlockImpl*> _providers; ///< Blocks connected to this one's input ports
 	std::set<BlockImpl*> _dependants; ///< Blocks this one's output ports are connected to
 	Mark                 _mark; ///< Mark for graph compilation algorithm
+	LV2_URID             _urid; ///< URID of URI for traces
 	bool                 _polyphonic;
 	bool                 _activated;
 	bool                 _enabled;
@@ -16,7 +16,15 @@
 
 #include <utility>
 
+#include <boost/variant/apply_visitor.hpp>
+
+#include <boost/variant/get.hpp>
+
+#include "ingen/Forge.hpp"
 #include "ingen/Interface.hpp"
+#include "ingen/Message.hpp"
+#include "ingen/URIs.hpp"
+#include "ingen/paths.hpp"
 
 #include "Broadcaster.hpp"
 #include "PluginImpl.hpp"
@@ -25,8 +33,9 @@
 namespace ingen {
 namespace server {
 
-Broadcaster::Broadcaster()
-	: _must_broadcast(false)
+Broadcaster::Broadcaster(const URIs& uris)
+	: _uris(uris)
+	, _must_broadcast(false)
 	, _bundle_depth(0)
 {}
 
@@ -43,7 +52,7 @@ void
 Broadcaster::register_client(SPtr<Interface> client)
 {
 	std::lock_guard<std::mutex> lock(_clients_mutex);
-	_clients.insert(client);
+	_clients.emplace(client, Client());
 }
 
 /** Remove a client from the list of registered clients.
@@ -56,18 +65,333 @@ Broadcaster::unregister_client(SPtr<Interface> client)
 	std::lock_guard<std::mutex> lock(_clients_mutex);
 	const size_t erased = _clients.erase(client);
 	_broadcastees.erase(client);
+	update_must_broadcast();
+	update_watched();
 	return (erased > 0);
 }
 
 void
 Broadcaster::set_broadcast(SPtr<Interface> client, bool broadcast)
 {
+	std::lock_guard<std::mutex> lock(_clients_mutex);
 	if (broadcast) {
 		_broadcastees.insert(client);
 	} else {
 		_broadcastees.erase(client);
 	}
-	_must_broadcast.store(!_broadcastees.empty());
+	update_must_broadcast();
+}
+
+Broadcaster::Subscription
+Broadcaster::subscription(SPtr<Interface> client)
+{
+	std::lock_guard<std::mutex> lock(_clients_mutex);
+	const auto c = _clients.find(client);
+	return c != _clients.end() ? c->second.subscription : Subscription();
+}
+
+void
+Broadcaster::set_subscription(SPtr<Interface> client, const Subscription& sub)
+{
+	std::lock_guard<std::mutex> lock(_clients_mutex);
+	const auto c = _clients.find(client);
+	if (c != _clients.end()) {
+		c->second.subscription = sub;
+		if (sub.rate <= 0.0f) {
+			// No longer throttled, send held updates before any newer ones
+			send_held(*client, c->second);
+			c->second.pending.clear();
+		}
+		update_must_broadcast();
+		update_watched();
+	}
+}
+
+bool
+Broadcaster::is_watched(const Raul::Path& path)
+{
+	std::lock_guard<std::mutex> lock(_clients_mutex);
+	return is_watched(_watched, path);
+}
+
+Broadcaster::Paths
+Broadcaster::watched_paths()
+{
+	std::lock_guard<std::mutex> lock(_clients_mutex);
+	return _watched;
+}
+
+bool
+Broadcaster::is_watched(const Paths& paths, const Raul::Path& path)
+{
+	if (paths.empty()) {
+		return false;
+	}
+
+	for (Raul::Path p = path; ; p = p.parent()) {
+		if (paths.count(p)) {
+			return true;
+		} else if (p.is_root()) {
+			return false;
+		}
+	}
+}
+
+/** Update the union of subscribed paths, called with the lock held. */
+void
+Broadcaster::update_watched()
+{
+	_watched.clear();
+	for (const auto& c : _clients) {
+		const Paths& paths = c.second.subscription.paths;
+		_watched.insert(paths.begin(), paths.end());
+	}
+}
+
+/** Update the flag checked by the audio thread, called with the lock held.
+ *
+ * Clients with path subscriptions only need monitor updates for the ports
+ * they watch, so only broadcast clients without any count here.
+ */
+void
+Broadcaster::update_must_broadcast()
+{
+	bool must_broadcast = false;
+	for (const auto& b : _broadcastees) {
+		const auto c = _clients.find(b);
+		if (c == _clients.end() || c->second.subscription.paths.empty()) {
+			must_broadcast = true;
+			break;
+		}
+	}
+	_must_broadcast.store(must_broadcast);
+}
+
+bool
+Broadcaster::Subscription::watches(const Raul::Path& path) const
+{
+	if (paths.empty()) {
+		return true;
+	}
+
+	for (const auto& p : paths) {
+		if (Raul::Path::descendant_comparator(p, path)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+namespace {
+
+/** Visitor that checks whether a message is within a subscription. */
+struct SubscriptionMatcher
+{
+	using result_type = bool; ///< For boost::apply_visitor
+
+	explicit SubscriptionMatcher(const Broadcaster::Subscription& s) : sub(s) {}
+
+	bool watches(const URI& uri) const {
+		return !uri_is_path(uri) || sub.watches(uri_to_path(uri));
+	}
+
+	bool operator()(const BundleBegin&) { return true; }
+	bool operator()(const BundleEnd&) { return true; }
+	bool operator()(const Error&) { return true; }
+	bool operator()(const Get&) { return true; }
+	bool operator()(const Redo&) { return true; }
+	bool operator()(const Response&) { return true; }
+	bool operator()(const Undo&) { return true; }
+
+	bool operator()(const Connect& msg) {
+		return sub.watches(msg.tail) || sub.watches(msg.head);
+	}
+
+	bool operator()(const Copy& msg) { return watches(msg.new_uri); }
+	bool operator()(const Del& msg) { return watches(msg.uri); }
+	bool operator()(const Delta& msg) { return watches(msg.uri); }
+
+	bool operator()(const Disconnect& msg) {
+		return sub.watches(msg.tail) || sub.watches(msg.head);
+	}
+
+	bool operator()(const DisconnectAll& msg) {
+		return sub.watches(msg.graph) || sub.watches(msg.path);
+	}
+
+	bool operator()(const Move& msg) {
+		return sub.watches(msg.old_path) || sub.watches(msg.new_path);
+	}
+
+	bool operator()(const Put& msg) { return watches(msg.uri); }
+
+	bool operator()(const SetProperty& msg) {
+		return watches(msg.subject) &&
+			(sub.properties.empty() || sub.properties.count(msg.predicate));
+	}
+
+	const Broadcaster::Subscription& sub;
+};
+
+} // namespace
+
+bool
+Broadcaster::Subscription::matches(const Message& msg) const
+{
+	SubscriptionMatcher matcher(*this);
+	return boost::apply_visitor(matcher, msg);
+}
+
+Properties
+Broadcaster::client_properties(SPtr<Interface> client)
+{
+	std::lock_guard<std::mutex> lock(_clients_mutex);
+	const auto c = _clients.find(client);
+	if (c == _clients.end()) {
+		return Properties();
+	}
+
+	const Subscription& sub   = c->second.subscription;
+	Properties          props = {
+		{ _uris.ingen_updateRate, _uris.forge.make(sub.rate) },
+		{ _uris.ingen_mergedUpdates,
+		  _uris.forge.make(int32_t(c->second.merged)) } };
+
+	for (const auto& p : sub.paths) {
+		props.emplace(_uris.ingen_subscribe,
+		              _uris.forge.make_urid(path_to_uri(p)));
+	}
+	for (const auto& p : sub.properties) {
+		props.emplace(_uris.ingen_filterProperty, _uris.forge.make_urid(p));
+	}
+
+	return props;
+}
+
+void
+Broadcaster::message(const Message& msg)
+{
+	std::lock_guard<std::mutex> lock(_clients_mutex);
+	for (auto& c : _clients) {
+		if (c.first != _ignore_client) {
+			send(*c.first, c.second, msg);
+		}
+	}
+}
+
+void
+Broadcaster::send(Interface& iface, Client& client, const Message& msg)
+{
+	const Subscription& sub = client.subscription;
+	if (!sub.empty() && !sub.matches(msg)) {
+		return;
+	}
+
+	if (sub.rate > 0.0f) {
+		if (const SetProperty* set = boost::get<SetProperty>(&msg)) {
+			if (set->predicate == _uris.ingen_value ||
+			    set->predicate == _uris.ingen_activity) {
+				hold(client, *set);
+				return;
+			}
+		} else if (const Del* del = boost::get<Del>(&msg)) {
+			if (uri_is_path(del->uri)) {
+				drop_pending(client, uri_to_path(del->uri));
+			}
+		} else if (const Move* move = boost::get<Move>(&msg)) {
+			drop_pending(client, move->old_path);
+		}
+	}
+
+	iface.message(msg);
+}
+
+/** Hold a monitor update for a throttled client.
+ *
+ * Only the latest value for each property is kept, except for audio activity
+ * (peaks) where the maximum value is kept so that meters do not miss peaks.
+ */
+void
+Broadcaster::hold(Client& client, const SetProperty& msg)
+{
+	auto& updates = client.pending[msg.subject];
+	auto  u       = updates.find(msg.predicate);
+	if (u == updates.end()) {
+		updates.emplace(msg.predicate, Update{msg.value, true});
+		++client.n_held;
+		return;
+	}
+
+	Update& update = u->second;
+	if (!update.held) {
+		update.value = msg.value;
+		update.held  = true;
+		++client.n_held;
+		return;
+	}
+
+	++client.merged;
+	if (msg.predicate == _uris.ingen_activity &&
+	    msg.value.type() == _uris.forge.Float &&
+	    update.value.type() == _uris.forge.Float) {
+		if (msg.value.get<float>() > update.value.get<float>()) {
+			update.value = msg.value;
+		}
+	} else {
+		update.value = msg.value;
+	}
+}
+
+/** Drop held updates for objects that are deleted or moved. */
+void
+Broadcaster::drop_pending(Client& client, const Raul::Path& path)
+{
+	for (auto p = client.pending.begin(); p != client.pending.end();) {
+		const URI& subject = p->first;
+		if (uri_is_path(subject) &&
+		    Raul::Path::descendant_comparator(path, uri_to_path(subject))) {
+			for (const auto& u : p->second) {
+				client.n_held -= u.second.held;
+			}
+			p = client.pending.erase(p);
+		} else {
+			++p;
+		}
+	}
+}
+
+/** Send held updates to a client, keeping the entries for reuse. */
+void
+Broadcaster::send_held(Interface& iface, Client& client)
+{
+	for (auto& p : client.pending) {
+		for (auto& u : p.second) {
+			if (u.second.held) {
+				iface.set_property(p.first, u.first, u.second.value);
+				u.second.held = false;
+			}
+		}
+	}
+	client.n_held = 0;
+}
+
+void
+Broadcaster::flush_updates()
+{
+	const uint64_t now = _clock.now_microseconds();
+
+	std::lock_guard<std::mutex> lock(_clients_mutex);
+	for (auto& c : _clients) {
+		Client& client = c.second;
+		if (!client.n_held || now < client.next_update) {
+			continue;
+		}
+
+		send_held(*c.first, client);
+
+		const float rate = client.subscription.rate;
+		client.next_update = (rate > 0.0f) ? now + uint64_t(1.0e6f / rate) : 0;
+	}
 }
 
 void
@@ -75,7 +399,7 @@ Broadcaster::send_plugins(const BlockFactory::Plugins& plugins)
 {
 	std::lock_guard<std::mutex> lock(_clients_mutex);
 	for (const auto& c : _clients) {
-		send_plugins_to(c.get(), plugins);
+		send_plugins_to(c.first.get(), plugins);
 	}
 }
 
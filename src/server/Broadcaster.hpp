@@ -19,16 +19,26 @@
 
 #include <atomic>
 #include <list>
+#include <map>
 #include <mutex>
 #include <set>
 #include <string>
+#include <utility>
 
+#include "ingen/Atom.hpp"
+#include "ingen/Clock.hpp"
 #include "ingen/Interface.hpp"
+#include "ingen/Properties.hpp"
+#include "ingen/URI.hpp"
 #include "ingen/types.hpp"
+#include "raul/Path.hpp"
 
 #include "BlockFactory.hpp"
 
 namespace ingen {
+
+class URIs;
+
 namespace server {
 
 /** Broadcaster for all clients.
@@ -36,12 +46,21 @@ namespace server {
  * This is an Interface that forwards all messages to all registered
  * clients (for updating all clients on state changes in the engine).
  *
+ * Messages are delivered to clients synchronously while the client list is
+ * locked, so registered clients must not block in message().  Clients which
+ * may be slow to consume messages should be wrapped in a ClientQueue.
+ *
+ * Clients may subscribe to a subset of the engine, in which case they are only
+ * sent messages about the subscribed graph objects (see Subscription).  If a
+ * client has an update rate, monitor updates for it are held and only the
+ * latest value for each property is sent by flush_updates().
+ *
  * \ingroup engine
  */
 class Broadcaster : public Interface
 {
 public:
-	Broadcaster();
+	explicit Broadcaster(const URIs& uris);
 	~Broadcaster();
 
 	void register_client(SPtr<Interface> client);
@@ -49,6 +68,54 @@ public:
 
 	void set_broadcast(SPtr<Interface> client, bool broadcast);
 
+	/** The part of the engine a client is interested in.
+	 *
+	 * An empty set of paths or properties means no filtering is done.
+	 */
+	struct Subscription {
+		Subscription() : rate(0.0f) {}
+
+		bool empty() const { return paths.empty() && properties.empty(); }
+
+		bool watches(const Raul::Path& path) const;
+		bool matches(const Message& msg) const;
+
+		std::set<Raul::Path> paths;       ///< Subscribed path prefixes
+		std::set<URI>        properties;  ///< Forwarded property keys
+		float                rate;        ///< Monitor update rate in Hz, or 0
+	};
+
+	/** Return the subscription of `client`. */
+	Subscription subscription(SPtr<Interface> client);
+
+	/** Replace the subscription of `client`. */
+	void set_subscription(SPtr<Interface> client, const Subscription& sub);
+
+	typedef std::set<Raul::Path> Paths;
+
+	/** Return true iff any client has subscribed to a prefix of `path`.
+	 *
+	 * This is used to decide whether ports must calculate monitor values when
+	 * no client has broadcasting enabled for the whole engine.
+	 */
+	bool is_watched(const Raul::Path& path);
+
+	/** Return all paths subscribed to by any client. */
+	Paths watched_paths();
+
+	/** Return true iff `path` or a parent of it is in `paths`. */
+	static bool is_watched(const Paths& paths, const Raul::Path& path);
+
+	/** Return the subscription and update statistics of `client`. */
+	Properties client_properties(SPtr<Interface> client);
+
+	/** Send held monitor updates to clients that are due for an update.
+	 *
+	 * This is called regularly in the main thread, after notifications from
+	 * the audio thread have been emitted.
+	 */
+	void flush_updates();
+
 	/** Ignore a client when broadcasting.
 	 *
 	 * This is used to prevent feeding back updates to the client that
@@ -57,7 +124,7 @@ public:
 	void set_ignore_client(SPtr<Interface> client) { _ignore_client = client; }
 	void clear_ignore_client()                     { _ignore_client.reset(); }
 
-	/** Return true iff there are any clients with broadcasting enabled.
+	/** Return true iff there are any clients which want all monitor updates.
 	 *
 	 * This is used in the audio thread to decide whether or not notifications
 	 * should be calculated and emitted.
@@ -88,25 +155,52 @@ public:
 	void send_plugins(const BlockFactory::Plugins& plugins);
 	void send_plugins_to(Interface*, const BlockFactory::Plugins& plugins);
 
-	void message(const Message& msg) override {
-		std::lock_guard<std::mutex> lock(_clients_mutex);
-		for (const auto& c : _clients) {
-			if (c != _ignore_client) {
-				c->message(msg);
-			}
-		}
-	}
+	void message(const Message& msg) override;
 
 	URI uri() const override { return URI("ingen:/broadcaster"); }
 
 private:
 	friend class Transfer;
 
-	typedef std::set<SPtr<Interface>> Clients;
+	/** The latest monitor update for a property. */
+	struct Update {
+		Atom value;
+		bool held;  ///< True iff value has not been sent yet
+	};
+
+	/** Monitor updates by subject and predicate.
+	 *
+	 * Updates are kept after they are sent, so the steady stream of updates
+	 * for the same ports does not allocate new entries at every flush.
+	 */
+	typedef std::map<URI, std::map<URI, Update>> Updates;
+
+	/** Broadcasting state for a registered client. */
+	struct Client {
+		Client() : n_held(0), next_update(0), merged(0) {}
+
+		Subscription subscription;
+		Updates      pending;      ///< Latest monitor updates
+		size_t       n_held;       ///< Number of held updates in pending
+		uint64_t     next_update;  ///< Time of next flush in microseconds
+		uint64_t     merged;       ///< Number of replaced monitor updates
+	};
+
+	typedef std::map<SPtr<Interface>, Client> Clients;
+
+	void send(Interface& iface, Client& client, const Message& msg);
+	void hold(Client& client, const SetProperty& msg);
+	void drop_pending(Client& client, const Raul::Path& path);
+	void send_held(Interface& iface, Client& client);
+	void update_must_broadcast();
+	void update_watched();
 
+	const URIs&                 _uris;
+	Clock                       _clock;
 	std::mutex                  _clients_mutex;
 	Clients                     _clients;
 	std::set< SPtr<Interface> > _broadcastees;
+	Paths                       _watched;  ///< Paths subscribed by any client
 	std::atomic<bool>           _must_broadcast;
 	unsigned                    _bundle_depth;
 	SPtr<Interface>             _ignore_client;
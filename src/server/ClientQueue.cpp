@@ -0,0 +1,222 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <utility>
+
+#include <boost/variant/get.hpp>
+
+#include "ingen/Configuration.hpp"
+#include "ingen/Forge.hpp"
+#include "ingen/Log.hpp"
+#include "ingen/URIs.hpp"
+#include "ingen/World.hpp"
+
+#include "ClientQueue.hpp"
+#include "Engine.hpp"
+
+namespace ingen {
+namespace server {
+
+ClientQueue::ClientQueue(Engine&               engine,
+                         SPtr<Interface>       sink,
+                         std::function<void()> disconnect)
+	: _log(engine.log())
+	, _uris(engine.world()->uris())
+	, _uri(sink->uri())
+	, _sink(std::move(sink))
+	, _disconnect(std::move(disconnect))
+	, _capacity(std::max(
+		  1, engine.world()->conf().option("client-queue-size").get<int32_t>()))
+	, _overflow(Overflow::COALESCE)
+	, _stats{0, 0, 0, 0}
+	, _overflowed(false)
+	, _exit_flag(false)
+	, _thread(&ClientQueue::run, this)
+{
+	const std::string policy(
+		engine.world()->conf().option("client-overflow").ptr<char>());
+	if (!parse_overflow(policy, _overflow)) {
+		_log.warn(fmt("Unknown client overflow policy `%1%'\n") % policy);
+	}
+}
+
+ClientQueue::~ClientQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_exit_flag = true;
+	}
+	_cond.notify_one();
+	_thread.join();
+}
+
+bool
+ClientQueue::parse_overflow(const std::string& str, Overflow& overflow)
+{
+	if (str == "drop") {
+		overflow = Overflow::DROP;
+	} else if (str == "coalesce") {
+		overflow = Overflow::COALESCE;
+	} else if (str == "disconnect") {
+		overflow = Overflow::DISCONNECT;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool
+ClientQueue::is_monitor_update(const Message& message) const
+{
+	const SetProperty* set = boost::get<SetProperty>(&message);
+	return set && (set->predicate == _uris.ingen_value ||
+	               set->predicate == _uris.ingen_activity);
+}
+
+bool
+ClientQueue::drop_oldest()
+{
+	for (auto i = _messages.begin(); i != _messages.end(); ++i) {
+		if (is_monitor_update(*i)) {
+			_messages.erase(i);
+			++_stats.dropped;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool
+ClientQueue::coalesce(const Message& message)
+{
+	/* Only search the run of updates at the end of the queue, so an update is
+	   never moved before another message like a Put or Del of the same
+	   object (as in QueuedInterface). */
+	const SetProperty& set = boost::get<SetProperty>(message);
+	for (auto i = _messages.rbegin(); i != _messages.rend(); ++i) {
+		SetProperty* queued = boost::get<SetProperty>(&*i);
+		if (!queued) {
+			break;
+		} else if (queued->predicate == set.predicate &&
+		           queued->subject == set.subject) {
+			queued->value = set.value;
+			++_stats.merged;
+			return true;
+		}
+	}
+	return false;
+}
+
+void
+ClientQueue::message(const Message& message)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (_overflowed) {
+		return;
+	}
+
+	if (_messages.size() >= _capacity) {
+		const bool is_monitor = is_monitor_update(message);
+		switch (_overflow) {
+		case Overflow::COALESCE:
+			if (is_monitor && coalesce(message)) {
+				return;
+			}
+			// fallthrough
+		case Overflow::DROP:
+			if (!drop_oldest() && is_monitor) {
+				++_stats.dropped;
+				return;  // Nothing older to drop, drop this update instead
+			}
+			break;
+		case Overflow::DISCONNECT:
+			_overflowed = true;
+			_messages.clear();
+			_stats.length = 0;
+			lock.unlock();
+			_log.warn(fmt("Client <%1%> queue overflow, disconnecting\n")
+			          % _uri);
+			if (_disconnect) {
+				_disconnect();
+			}
+			return;
+		}
+	}
+
+	_messages.emplace_back(message);
+	_stats.length     = _messages.size();
+	_stats.max_length = std::max(_stats.max_length, _stats.length);
+	lock.unlock();
+	_cond.notify_one();
+}
+
+ClientQueue::Stats
+ClientQueue::stats() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _stats;
+}
+
+void
+ClientQueue::set_sink(SPtr<Interface> sink)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_sink = std::move(sink);
+}
+
+Properties
+ClientQueue::stats_properties() const
+{
+	const Stats s = stats();
+
+	return { { _uris.ingen_queueLength,
+	           _uris.forge.make(int32_t(s.length)) },
+	         { _uris.ingen_maxQueueLength,
+	           _uris.forge.make(int32_t(s.max_length)) },
+	         { _uris.ingen_droppedMessages,
+	           _uris.forge.make(int32_t(s.dropped)) },
+	         { _uris.ingen_mergedMessages,
+	           _uris.forge.make(int32_t(s.merged)) } };
+}
+
+void
+ClientQueue::run()
+{
+	while (true) {
+		Message         message;
+		SPtr<Interface> sink;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cond.wait(lock, [this] {
+				return _exit_flag || !_messages.empty();
+			});
+			if (_exit_flag) {
+				break;
+			}
+
+			message = _messages.front();
+			_messages.pop_front();
+			_stats.length = _messages.size();
+			sink          = _sink;
+		}
+
+		sink->message(message);
+	}
+}
+
+} // namespace server
+} // namespace ingen
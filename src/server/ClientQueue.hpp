@@ -0,0 +1,137 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_CLIENTQUEUE_HPP
+#define INGEN_ENGINE_CLIENTQUEUE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "ingen/Interface.hpp"
+#include "ingen/Message.hpp"
+#include "ingen/Properties.hpp"
+#include "ingen/types.hpp"
+
+namespace ingen {
+
+class Log;
+class URIs;
+
+namespace server {
+
+class Engine;
+
+/** A bounded outbound message queue for a single client.
+ *
+ * Messages are queued by message() without blocking, and written to the
+ * underlying sink by a dedicated sender thread.  This way, a client that is
+ * slow to consume messages (for example, a remote client on a congested
+ * socket) only delays its own updates, and not the post-processor or other
+ * clients.
+ *
+ * When the queue is full, the overflow policy determines what happens.
+ * Structural messages are never dropped, since this would leave the client
+ * with an inconsistent model, so only monitor updates (port values and
+ * activity) are ever discarded or merged.
+ *
+ * \ingroup engine
+ */
+class ClientQueue : public Interface
+{
+public:
+	/** What to do when a message arrives and the queue is full. */
+	enum class Overflow {
+		DROP,       ///< Drop the oldest queued monitor update
+		COALESCE,   ///< Replace a trailing queued update of the same property
+		DISCONNECT  ///< Discard everything and disconnect the client
+	};
+
+	/** Backlog statistics for a client. */
+	struct Stats {
+		size_t   length;      ///< Number of currently queued messages
+		size_t   max_length;  ///< Maximum number of queued messages
+		uint64_t dropped;     ///< Number of monitor updates dropped
+		uint64_t merged;      ///< Number of monitor updates merged
+	};
+
+	/** Create a new queue that writes to `sink`.
+	 *
+	 * @param engine The engine, used for configuration and logging.
+	 * @param sink Interface to write messages to in the sender thread.
+	 * @param disconnect Function called to disconnect an overflowed client.
+	 */
+	ClientQueue(Engine&               engine,
+	            SPtr<Interface>       sink,
+	            std::function<void()> disconnect);
+
+	~ClientQueue() override;
+
+	URI uri() const override { return _uri; }
+
+	void message(const Message& message) override;
+
+	/** Return the current backlog statistics. */
+	Stats stats() const;
+
+	/** Return the backlog statistics as properties for clients. */
+	Properties stats_properties() const;
+
+	/** Return true iff this client was disconnected due to overflow. */
+	bool overflowed() const { return _overflowed; }
+
+	/** Replace the sink, so following messages are sent to `sink`.
+	 *
+	 * This is used to switch a client to a different transport (for example,
+	 * shared memory) without losing or reordering any queued messages.
+	 */
+	void set_sink(SPtr<Interface> sink);
+
+	/** Parse an overflow policy from a configuration string. */
+	static bool parse_overflow(const std::string& str, Overflow& overflow);
+
+private:
+	bool is_monitor_update(const Message& message) const;
+	bool drop_oldest();
+	bool coalesce(const Message& message);
+
+	void run();
+
+	Log&                    _log;
+	const URIs&             _uris;
+	const URI               _uri;
+	SPtr<Interface>         _sink;
+	std::function<void()>   _disconnect;
+	mutable std::mutex      _mutex;
+	std::condition_variable _cond;
+	std::deque<Message>     _messages;
+	size_t                  _capacity;
+	Overflow                _overflow;
+	Stats                   _stats;
+	std::atomic<bool>       _overflowed;
+	bool                    _exit_flag;
+	std::thread             _thread;
+};
+
+} // namespace server
+} // namespace ingen
+
+#endif // INGEN_ENGINE_CLIENTQUEUE_HPP
@@ -14,6 +14,8 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <utility>
+
 #include "ingen/Interface.hpp"
 #include "ingen/URIs.hpp"
 
@@ -27,12 +29,11 @@ namespace ingen {
 namespace server {
 
 void
-ClientUpdate::put(const URI&        uri,
-                  const Properties& props,
-                  Resource::Graph   ctx)
+ClientUpdate::put(const URI&      uri,
+                  Properties      props,
+                  Resource::Graph ctx)
 {
-	const ClientUpdate::Put put = { uri, props, ctx };
-	puts.push_back(put);
+	puts.push_back({ uri, std::move(props), ctx });
 }
 
 void
@@ -43,7 +44,7 @@ ClientUpdate::put_port(const PortImpl* port)
 		Properties props = port->properties();
 		props.erase(uris.ingen_value);
 		props.emplace(uris.ingen_value, port->value());
-		put(port->uri(), props);
+		put(port->uri(), std::move(props));
 	} else {
 		put(port->uri(), port->properties());
 	}
@@ -68,13 +69,7 @@ ClientUpdate::put_block(const BlockImpl* block)
 void
 ClientUpdate::put_graph(const GraphImpl* graph)
 {
-	put(graph->uri(),
-	    graph->properties(Resource::Graph::INTERNAL),
-	    Resource::Graph::INTERNAL);
-
-	put(graph->uri(),
-	    graph->properties(Resource::Graph::EXTERNAL),
-	    Resource::Graph::EXTERNAL);
+	put_graph_properties(graph);
 
 	// Enqueue blocks
 	for (const auto& b : graph->blocks()) {
@@ -86,11 +81,27 @@ ClientUpdate::put_graph(const GraphImpl* graph)
 		put_port(graph->port_impl(i));
 	}
 
-	// Enqueue arcs
+	put_arcs(graph);
+}
+
+void
+ClientUpdate::put_graph_properties(const GraphImpl* graph)
+{
+	put(graph->uri(),
+	    graph->properties(Resource::Graph::INTERNAL),
+	    Resource::Graph::INTERNAL);
+
+	put(graph->uri(),
+	    graph->properties(Resource::Graph::EXTERNAL),
+	    Resource::Graph::EXTERNAL);
+}
+
+void
+ClientUpdate::put_arcs(const GraphImpl* graph)
+{
 	for (const auto& a : graph->arcs()) {
-		const SPtr<const Arc> arc     = a.second;
-		const Connect         connect = { arc->tail_path(), arc->head_path() };
-		connects.push_back(connect);
+		const SPtr<const Arc> arc = a.second;
+		connects.push_back({ arc->tail_path(), arc->head_path() });
 	}
 }
 
@@ -110,11 +121,10 @@ ClientUpdate::put_preset(const URIs&        uris,
                          const URI&         preset,
                          const std::string& label)
 {
-	const Properties props{
-		{ uris.rdf_type, uris.pset_Preset.urid },
-		{ uris.rdfs_label, uris.forge.alloc(label) },
-		{ uris.lv2_appliesTo, uris.forge.make_urid(plugin) }};
-	put(preset, props);
+	put(preset,
+	    { { uris.rdf_type, uris.pset_Preset.urid },
+	      { uris.rdfs_label, uris.forge.alloc(label) },
+	      { uris.lv2_appliesTo, uris.forge.make_urid(plugin) } });
 }
 
 void
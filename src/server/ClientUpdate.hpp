@@ -41,13 +41,15 @@ class PluginImpl;
  * post_process() to avoid the need to lock.
  */
 struct ClientUpdate {
-	void put(const URI&        uri,
-	         const Properties& props,
-	         Resource::Graph   ctx = Resource::Graph::DEFAULT);
+	void put(const URI&      uri,
+	         Properties      props,
+	         Resource::Graph ctx = Resource::Graph::DEFAULT);
 
 	void put_port(const PortImpl* port);
 	void put_block(const BlockImpl* block);
 	void put_graph(const GraphImpl* graph);
+	void put_graph_properties(const GraphImpl* graph);
+	void put_arcs(const GraphImpl* graph);
 	void put_plugin(PluginImpl* plugin);
 	void put_preset(const URIs&        uris,
 	                const URI&         plugin,
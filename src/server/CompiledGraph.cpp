@@ -15,6 +15,8 @@
 */
 
 #include <algorithm>
+#include <memory>
+#include <string>
 
 #include "ingen/ColorContext.hpp"
 #include "ingen/Configuration.hpp"
@@ -144,6 +146,10 @@ CompiledGraph::compile_graph(GraphImpl* graph)
 
 	_master = Task::simplify(std::move(_master));
 
+	std::string layout;
+	_master->dump([&layout](const std::string& s) { layout += s; }, 0, true);
+	_layout = std::make_shared<const std::string>(std::move(layout));
+
 	if (graph->engine().world()->conf().option("trace").get<int32_t>()) {
 		ColorContext ctx(stderr, ColorContext::Color::YELLOW);
 		dump(graph->path());
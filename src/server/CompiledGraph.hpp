@@ -19,6 +19,7 @@
 
 #include <functional>
 #include <set>
+#include <string>
 #include <vector>
 
 #include "ingen/types.hpp"
@@ -48,6 +49,9 @@ public:
 
 	void run(RunContext& context);
 
+	/** Return a description of the layout of tasks, as printed by dump(). */
+	const SPtr<const std::string>& layout() const { return _layout; }
+
 private:
 	friend class Raul::Maid;  ///< Allow make_managed to construct
 
@@ -70,7 +74,8 @@ private:
 	                      size_t           max_depth,
 	                      BlockSet&        k);
 
-	std::unique_ptr<Task> _master;
+	std::unique_ptr<Task>   _master;
+	SPtr<const std::string> _layout;
 };
 
 inline MPtr<CompiledGraph> compile(Raul::Maid& maid, GraphImpl& graph)
@@ -36,22 +36,44 @@ namespace server {
 ControlBindings::ControlBindings(Engine& engine)
 	: _engine(engine)
 	, _learn_binding(nullptr)
-	, _bindings(new Bindings())
-	, _feedback(new Buffer(*_engine.buffer_factory(),
-	                       engine.world()->uris().atom_Sequence,
-	                       0,
-	                       4096)) // FIXME: capacity?
+	, _n_bindings(0)
+	, _n_inputs(0)
+	, _n_outputs(0)
 {
 	lv2_atom_forge_init(
 		&_forge, &engine.world()->uri_map().urid_map_feature()->urid_map);
+
+	_slots[slot_index(Key(Type::MIDI_BENDER))].key = Key(Type::MIDI_BENDER);
+	_slots[slot_index(Key(Type::MIDI_CHANNEL_PRESSURE))].key =
+		Key(Type::MIDI_CHANNEL_PRESSURE);
+	for (int16_t n = 0; n < 128; ++n) {
+		_slots[slot_index(Key(Type::MIDI_CC, n))].key   = Key(Type::MIDI_CC, n);
+		_slots[slot_index(Key(Type::MIDI_NOTE, n))].key = Key(Type::MIDI_NOTE, n);
+	}
 }
 
 ControlBindings::~ControlBindings()
 {
-	_feedback.reset();
 	delete _learn_binding.load();
 }
 
+size_t
+ControlBindings::slot_index(const Key& key)
+{
+	switch (key.type) {
+	case Type::MIDI_BENDER:
+		return 0;
+	case Type::MIDI_CHANNEL_PRESSURE:
+		return 1;
+	case Type::MIDI_CC:
+		return (key.num >= 0 && key.num < 128) ? 2 + key.num : n_slots;
+	case Type::MIDI_NOTE:
+		return (key.num >= 0 && key.num < 128) ? 130 + key.num : n_slots;
+	default:
+		return n_slots;
+	}
+}
+
 ControlBindings::Key
 ControlBindings::port_binding(PortImpl* port) const
 {
@@ -134,11 +156,13 @@ ControlBindings::set_port_binding(RunContext& context,
                                   Binding*    binding,
                                   const Atom& value)
 {
-	const Key key = binding_key(value);
-	if (!!key) {
+	const Key    key = binding_key(value);
+	const size_t i   = slot_index(key);
+	if (i < n_slots) {
 		binding->key  = key;
 		binding->port = port;
-		_bindings->insert(*binding);
+		_slots[i].bindings.push_back(*binding);
+		++_n_bindings;
 		return true;
 	} else {
 		return false;
@@ -151,47 +175,20 @@ ControlBindings::port_value_changed(RunContext& ctx,
                                     Key         key,
                                     const Atom& value_atom)
 {
-	ingen::World*      world = ctx.engine().world();
-	const ingen::URIs& uris  = world->uris();
-	if (!!key) {
-		int16_t  value = port_value_to_control(
+	const size_t i = slot_index(key);
+	if (i < n_slots) {
+		Slot&         slot  = _slots[i];
+		const int16_t value = port_value_to_control(
 			ctx, port, key.type, value_atom);
-		uint16_t size  = 0;
-		uint8_t  buf[4];
-		switch (key.type) {
-		case Type::MIDI_CC:
-			size = 3;
-			buf[0] = LV2_MIDI_MSG_CONTROLLER;
-			buf[1] = key.num;
-			buf[2] = static_cast<int8_t>(value);
-			break;
-		case Type::MIDI_CHANNEL_PRESSURE:
-			size = 2;
-			buf[0] = LV2_MIDI_MSG_CHANNEL_PRESSURE;
-			buf[1] = static_cast<int8_t>(value);
-			break;
-		case Type::MIDI_BENDER:
-			size = 3;
-			buf[0] = LV2_MIDI_MSG_BENDER;
-			buf[1] = (value & 0x007F);
-			buf[2] = (value & 0x7F00) >> 7;
-			break;
-		case Type::MIDI_NOTE:
-			size = 3;
-			if (value == 1) {
-				buf[0] = LV2_MIDI_MSG_NOTE_ON;
-			} else if (value == 0) {
-				buf[0] = LV2_MIDI_MSG_NOTE_OFF;
+
+		// Send the latest value at the end of the cycle, if it has changed
+		if (slot.output < 0) {
+			if (value == slot.value) {
+				return;
 			}
-			buf[1] = key.num;
-			buf[2] = 0x64; // MIDI spec default
-			break;
-		default:
-			break;
-		}
-		if (size > 0) {
-			_feedback->append_event(ctx.nframes() - 1, size, (LV2_URID)uris.midi_MidiEvent, buf);
+			_outputs[_n_outputs++] = i;
 		}
+		slot.output = value;
 	}
 }
 
@@ -344,14 +341,20 @@ ControlBindings::set_port_value(RunContext& context,
 bool
 ControlBindings::finish_learn(RunContext& context, Key key)
 {
-	const ingen::URIs& uris    = context.engine().world()->uris();
-	Binding*           binding = _learn_binding.exchange(nullptr);
+	const ingen::URIs& uris = context.engine().world()->uris();
+	const size_t       i    = slot_index(key);
+	if (i == n_slots) {
+		return false;
+	}
+
+	Binding* binding = _learn_binding.exchange(nullptr);
 	if (!binding || (key.type == Type::MIDI_NOTE && !binding->port->is_toggled())) {
 		return false;
 	}
 
 	binding->key = key;
-	_bindings->insert(*binding);
+	_slots[i].bindings.push_back(*binding);
+	++_n_bindings;
 
 	LV2_Atom buf[16];
 	memset(buf, 0, sizeof(buf));
@@ -371,9 +374,11 @@ ControlBindings::get_all(const Raul::Path& path, std::vector<Binding*>& bindings
 {
 	ThreadManager::assert_thread(THREAD_PRE_PROCESS);
 
-	for (Binding& b : *_bindings) {
-		if (b.port->path() == path || b.port->path().is_child_of(path)) {
-			bindings.push_back(&b);
+	for (Slot& slot : _slots) {
+		for (Binding& b : slot.bindings) {
+			if (b.port->path() == path || b.port->path().is_child_of(path)) {
+				bindings.push_back(&b);
+			}
 		}
 	}
 }
@@ -382,7 +387,9 @@ void
 ControlBindings::remove(RunContext& ctx, const std::vector<Binding*>& bindings)
 {
 	for (Binding* b : bindings) {
-		_bindings->erase(*b);
+		Bindings& slot_bindings = _slots[slot_index(b->key)].bindings;
+		slot_bindings.erase(slot_bindings.iterator_to(*b));
+		--_n_bindings;
 	}
 }
 
@@ -393,11 +400,11 @@ ControlBindings::pre_process(RunContext& ctx, Buffer* buffer)
 	ingen::World*      world = ctx.engine().world();
 	const ingen::URIs& uris  = world->uris();
 
-	_feedback->clear();
-	if ((!_learn_binding && _bindings->empty()) || !buffer->get<LV2_Atom>()) {
+	if ((!_learn_binding && !_n_bindings) || !buffer->get<LV2_Atom>()) {
 		return;  // Don't bother reading input
 	}
 
+	// Find the latest value of every bound key in this cycle
 	LV2_Atom_Sequence* seq = buffer->get<LV2_Atom_Sequence>();
 	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
 		if (ev->body.type == uris.midi_MidiEvent) {
@@ -408,23 +415,79 @@ ControlBindings::pre_process(RunContext& ctx, Buffer* buffer)
 				finish_learn(ctx, key);  // Learn new binding
 			}
 
-			// Set all controls bound to this key
-			const Binding k = {key, nullptr};
-			for (Bindings::const_iterator i = _bindings->lower_bound(k);
-			     i != _bindings->end() && i->key == key;
-			     ++i) {
-				set_port_value(ctx, i->port, key.type, value);
+			const size_t i = slot_index(key);
+			if (i < n_slots && !_slots[i].bindings.empty()) {
+				if (_slots[i].input < 0) {
+					_inputs[_n_inputs++] = i;
+				}
+				_slots[i].input = value;
 			}
 		}
 	}
+
+	// Set all controls bound to each key once, to its latest value
+	for (size_t i = 0; i < _n_inputs; ++i) {
+		Slot& slot = _slots[_inputs[i]];
+		for (const Binding& b : slot.bindings) {
+			set_port_value(ctx, b.port, slot.key.type, slot.input);
+		}
+		slot.value = slot.input;
+		slot.input = -1;
+	}
+	_n_inputs = 0;
 }
 
 void
 ControlBindings::post_process(RunContext& context, Buffer* buffer)
 {
-	if (buffer->get<LV2_Atom>()) {
-		buffer->append_event_buffer(_feedback.get());
+	const ingen::URIs& uris = context.engine().world()->uris();
+	const bool         emit = buffer->get<LV2_Atom>();
+
+	// Send feedback for controls that changed, with only the latest value
+	for (size_t i = 0; i < _n_outputs; ++i) {
+		Slot&         slot  = _slots[_outputs[i]];
+		const int16_t value = slot.output;
+		uint16_t      size  = 0;
+		uint8_t       buf[4];
+		switch (slot.key.type) {
+		case Type::MIDI_CC:
+			size = 3;
+			buf[0] = LV2_MIDI_MSG_CONTROLLER;
+			buf[1] = slot.key.num;
+			buf[2] = static_cast<int8_t>(value);
+			break;
+		case Type::MIDI_CHANNEL_PRESSURE:
+			size = 2;
+			buf[0] = LV2_MIDI_MSG_CHANNEL_PRESSURE;
+			buf[1] = static_cast<int8_t>(value);
+			break;
+		case Type::MIDI_BENDER:
+			size = 3;
+			buf[0] = LV2_MIDI_MSG_BENDER;
+			buf[1] = (value & 0x007F);
+			buf[2] = (value & 0x7F00) >> 7;
+			break;
+		case Type::MIDI_NOTE:
+			size = 3;
+			buf[0] = value ? LV2_MIDI_MSG_NOTE_ON : LV2_MIDI_MSG_NOTE_OFF;
+			buf[1] = slot.key.num;
+			buf[2] = 0x64; // MIDI spec default
+			break;
+		default:
+			break;
+		}
+
+		if (emit && size > 0 && value != slot.value) {
+			buffer->append_event(context.nframes() - 1,
+			                     size,
+			                     (LV2_URID)uris.midi_MidiEvent,
+			                     buf);
+		}
+
+		slot.value  = value;
+		slot.output = -1;
 	}
+	_n_outputs = 0;
 }
 
 } // namespace server
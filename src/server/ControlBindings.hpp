@@ -21,8 +21,7 @@
 #include <cstdint>
 #include <vector>
 
-#include <boost/intrusive/options.hpp>
-#include <boost/intrusive/set.hpp>
+#include <boost/intrusive/list.hpp>
 
 #include "ingen/Atom.hpp"
 #include "ingen/types.hpp"
@@ -66,23 +65,14 @@ public:
 	};
 
 	/** One binding of a controller to a port. */
-	struct Binding : public boost::intrusive::set_base_hook<>,
+	struct Binding : public boost::intrusive::list_base_hook<>,
 	                 public Raul::Maid::Disposable {
 		Binding(Key k=Key(), PortImpl* p=nullptr) : key(std::move(k)), port(p) {}
 
-		inline bool operator<(const Binding& rhs) const { return key < rhs.key; }
-
 		Key       key;
 		PortImpl* port;
 	};
 
-	/** Comparator for bindings by key. */
-	struct BindingLess {
-		bool operator()(const Binding& lhs, const Binding& rhs) const {
-			return lhs.key < rhs.key;
-		}
-	};
-
 	explicit ControlBindings(Engine& engine);
 	~ControlBindings();
 
@@ -112,9 +102,28 @@ public:
 	void remove(RunContext& ctx, const std::vector<Binding*>& bindings);
 
 private:
-	typedef boost::intrusive::multiset<
-		Binding,
-		boost::intrusive::compare<BindingLess> > Bindings;
+	typedef boost::intrusive::list<Binding> Bindings;
+
+	/** Number of keys that can be bound: bender, pressure, CCs, and notes. */
+	static const size_t n_slots = 2 + 128 + 128;
+
+	/** The bindings for a key, and the state of that control.
+	 *
+	 * Values are only applied once per cycle, and feedback is only sent when
+	 * the value differs from the one the controller last sent or was sent.
+	 */
+	struct Slot {
+		Slot() : value(-1), input(-1), output(-1) {}
+
+		Key      key;
+		Bindings bindings;
+		int32_t  value;   ///< Last value received or sent, or -1
+		int32_t  input;   ///< Latest value received this cycle, or -1
+		int32_t  output;  ///< Latest value to send this cycle, or -1
+	};
+
+	/** Return the index of the slot for `key`, or n_slots if it has none. */
+	static size_t slot_index(const Key& key);
 
 	Key midi_event_key(uint16_t size, const uint8_t* buf, uint16_t& value);
 
@@ -137,8 +146,12 @@ private:
 
 	Engine&               _engine;
 	std::atomic<Binding*> _learn_binding;
-	SPtr<Bindings>        _bindings;
-	BufferRef             _feedback;
+	Slot                  _slots[n_slots];
+	size_t                _n_bindings;
+	uint16_t              _inputs[n_slots];   ///< Slots with input this cycle
+	size_t                _n_inputs;
+	uint16_t              _outputs[n_slots];  ///< Slots with output this cycle
+	size_t                _n_outputs;
 	LV2_Atom_Forge        _forge;
 };
 
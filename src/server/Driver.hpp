@@ -17,6 +17,7 @@
 #ifndef INGEN_ENGINE_DRIVER_HPP
 #define INGEN_ENGINE_DRIVER_HPP
 
+#include "ingen/Properties.hpp"
 #include "raul/Noncopyable.hpp"
 
 #include "DuplexPort.hpp"
@@ -102,6 +103,9 @@ public:
 
 	/** Return the real-time priority of the audio thread, or -1. */
 	virtual int real_time_priority() = 0;
+
+	/** Return timing statistics as properties for clients, if any. */
+	virtual Properties stats_properties() const { return Properties(); }
 };
 
 } // namespace server
@@ -18,6 +18,9 @@
 
 #include <sys/mman.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <limits>
 #include <thread>
 
@@ -27,10 +30,12 @@
 #include "events/CreateGraph.hpp"
 #include "ingen/AtomReader.hpp"
 #include "ingen/Configuration.hpp"
+#include "ingen/Forge.hpp"
 #include "ingen/Log.hpp"
 #include "ingen/Store.hpp"
 #include "ingen/StreamWriter.hpp"
 #include "ingen/Tee.hpp"
+#include "ingen/URIMap.hpp"
 #include "ingen/URIs.hpp"
 #include "ingen/World.hpp"
 #include "ingen/types.hpp"
@@ -45,18 +50,24 @@
 #include "Engine.hpp"
 #include "Event.hpp"
 #include "EventWriter.hpp"
+#include "FlightRecorder.hpp"
 #include "GraphImpl.hpp"
 #include "LV2Options.hpp"
+#include "PortImpl.hpp"
 #include "PostProcessor.hpp"
 #include "PreProcessContext.hpp"
 #include "PreProcessor.hpp"
 #include "RunContext.hpp"
 #include "ThreadManager.hpp"
+#include "Tracer.hpp"
 #include "UndoStack.hpp"
 #include "Worker.hpp"
 #ifdef HAVE_SOCKET
 #include "SocketListener.hpp"
 #endif
+#ifdef HAVE_SHM_OPEN
+#include "ShmServer.hpp"
+#endif
 
 namespace ingen {
 namespace server {
@@ -64,18 +75,33 @@ namespace server {
 INGEN_THREAD_LOCAL unsigned ThreadManager::flags(0);
 bool               ThreadManager::single_threaded(true);
 
+/** Return the memory limit for each undo stack in bytes. */
+static size_t
+undo_memory_limit(ingen::World* world)
+{
+	const int32_t mib = world->conf().option("undo-memory").get<int32_t>();
+	return mib > 0 ? size_t(mib) * 1024 * 1024 : 0;
+}
+
 Engine::Engine(ingen::World* world)
 	: _world(world)
 	, _options(new LV2Options(world->uris()))
 	, _buffer_factory(new BufferFactory(*this, world->uris()))
 	, _maid(new Raul::Maid)
-	, _worker(new Worker(world->log(), event_queue_size()))
-	, _sync_worker(new Worker(world->log(), event_queue_size(), true))
-	, _broadcaster(new Broadcaster())
+	, _worker(new Worker(world->log(),
+	                     event_queue_size(),
+	                     world->conf().option("threads").get<int32_t>(),
+	                     std::max(1, world->conf().option("worker-threads").get<int32_t>())))
+	, _sync_worker(new Worker(world->log(), event_queue_size(), 0, 0, true))
+	, _broadcaster(new Broadcaster(world->uris()))
 	, _control_bindings(new ControlBindings(*this))
 	, _block_factory(new BlockFactory(world))
-	, _undo_stack(new UndoStack(_world->uris(), _world->uri_map()))
-	, _redo_stack(new UndoStack(_world->uris(), _world->uri_map()))
+	, _undo_stack(new UndoStack(_world->uris(),
+	                            _world->uri_map(),
+	                            undo_memory_limit(world)))
+	, _redo_stack(new UndoStack(_world->uris(),
+	                            _world->uri_map(),
+	                            undo_memory_limit(world)))
 	, _post_processor(new PostProcessor(*this))
 	, _pre_processor(new PreProcessor(*this))
 	, _event_writer(new EventWriter(*this))
@@ -84,8 +110,10 @@ Engine::Engine(ingen::World* world)
 		new AtomReader(world->uri_map(), world->uris(), world->log(), *_interface))
 	, _root_graph(nullptr)
 	, _cycle_start_time(0)
+	, _merged_notifications(0)
 	, _rand_engine(0)
 	, _uniform_dist(0.0f, 1.0f)
+	, _trace_requested(false)
 	, _quit_flag(false)
 	, _reset_load_flag(false)
 	, _atomic_bundles(world->conf().option("atomic-bundles").get<int32_t>())
@@ -96,11 +124,34 @@ Engine::Engine(ingen::World* world)
 	}
 
 	for (int i = 0; i < world->conf().option("threads").get<int32_t>(); ++i) {
-		Raul::RingBuffer* ring = new Raul::RingBuffer(24 * event_queue_size());
+		NotificationRing* ring = new NotificationRing(24 * event_queue_size());
 		_notifications.push_back(ring);
 		_run_contexts.push_back(new RunContext(*this, ring, i, i > 0));
 	}
 
+	// Pin worker threads to CPUs, the main context runs in the driver thread
+	if (world->conf().option("pin-threads").get<int32_t>()) {
+		const unsigned n_cpus = std::max(std::thread::hardware_concurrency(), 1U);
+		for (size_t i = 1; i < _run_contexts.size(); ++i) {
+			_run_contexts[i]->set_cpu(i % n_cpus);
+		}
+	}
+
+	// Record traces for every run context and the post-processor if enabled
+	_tracer = UPtr<Tracer>(
+		new Tracer(world->uri_map(),
+		           (world->conf().option("trace-file").is_valid()
+		            ? _run_contexts.size() + 1
+		            : 0)));
+
+	// Record block timings for every run context to diagnose overruns
+	_flight_recorder = UPtr<FlightRecorder>(
+		new FlightRecorder(
+			world->uri_map(),
+			_run_contexts.size(),
+			std::max(1, world->conf().option("overrun-cycles").get<int32_t>()),
+			std::max(0, world->conf().option("overrun-threshold").get<int32_t>())));
+
 	_world->lv2_features().add_feature(_worker->schedule_feature());
 	_world->lv2_features().add_feature(_options);
 	_world->lv2_features().add_feature(
@@ -133,6 +184,12 @@ Engine::~Engine()
 	_root_graph = nullptr;
 	deactivate();
 
+	// Stop reading from shared memory clients
+	{
+		std::lock_guard<std::mutex> lock(_shm_mutex);
+		_shm_servers.clear();
+	}
+
 	// Process all pending events
 	const FrameTime end = std::numeric_limits<FrameTime>::max();
 	RunContext&     ctx = run_context();
@@ -153,7 +210,7 @@ Engine::~Engine()
 		ctx->join();
 		delete ctx;
 	}
-	for (Raul::RingBuffer* ring : _notifications) {
+	for (NotificationRing* ring : _notifications) {
 		delete ring;
 	}
 
@@ -203,7 +260,19 @@ Engine::set_root_graph(GraphImpl* graph)
 void
 Engine::flush_events(const std::chrono::milliseconds& sleep_ms)
 {
-	bool finished = !pending_events();
+	/* Run until events scheduled in the next second have been executed as
+	   well, but not those further ahead (or events waiting for them), which
+	   could take practically forever. */
+	const uint64_t horizon = uint64_t(run_context().start()) + sample_rate();
+	const auto     pending = [this, horizon]() {
+		if (_pre_processor->next_scheduled() < horizon) {
+			return true;
+		}
+		return (_post_processor->pending() ||
+		        (!_pre_processor->queue_empty() && !_pre_processor->waiting()));
+	};
+
+	bool finished = !pending();
 	while (!finished) {
 		// Run one audio block to execute prepared events
 		run(block_length());
@@ -213,25 +282,149 @@ Engine::flush_events(const std::chrono::milliseconds& sleep_ms)
 		main_iteration();
 
 		// Sleep before continuing if there are still events to process
-		if (!(finished = !pending_events())) {
+		if (!(finished = !pending())) {
 			std::this_thread::sleep_for(sleep_ms);
 		}
 	}
 }
 
+float
+Engine::note_float(const Note& note) const
+{
+	float value = 0.0f;
+	memcpy(&value, _note_values.data() + note.offset, sizeof(value));
+	return value;
+}
+
+const URI*
+Engine::key_uri(LV2_URID key)
+{
+	auto k = _key_uris.find(key);
+	if (k == _key_uris.end()) {
+		const char* const str = _world->uri_map().unmap_uri(key);
+		if (!str) {
+			return nullptr;
+		}
+		k = _key_uris.emplace(key, URI(str)).first;
+	}
+	return &k->second;
+}
+
 void
 Engine::emit_notifications(FrameTime end)
 {
-	for (RunContext* ctx : _run_contexts) {
-		ctx->emit_notifications(end);
+	const URIs& uris  = world()->uris();
+	Forge&      forge = world()->forge();
+
+	// Read notifications from every ring, packing values into a single buffer
+	_notes.clear();
+	_note_values.clear();
+	for (NotificationRing* ring : _notifications) {
+		Notification header;
+		while (ring->read(end, header, _note_values)) {
+			const size_t offset = _note_values.size() - header.size;
+			_notes.push_back({header, offset, 0, true});
+		}
+	}
+
+	/* Order notifications by time.  The notifications from each ring are
+	   already in order, so breaking ties by index keeps notifications from
+	   the same context in the order they were sent. */
+	_emit_order.clear();
+	for (size_t i = 0; i < _notes.size(); ++i) {
+		_emit_order.push_back(i);
+	}
+
+	std::sort(_emit_order.begin(), _emit_order.end(),
+	          [this](const size_t lhs, const size_t rhs) {
+		          const FrameTime l = _notes[lhs].header.time;
+		          const FrameTime r = _notes[rhs].header.time;
+		          return l < r || (l == r && lhs < rhs);
+	          });
+
+	for (size_t i = 0; i < _emit_order.size(); ++i) {
+		_notes[_emit_order[i]].rank = i;
+	}
+
+	/* Find monitor updates that can be merged, that is, values and activity
+	   for ports that are not explicitly monitored (by plugin UIs, which get
+	   every update), and sort them by port and key so updates for the same
+	   property are adjacent, but still in time order. */
+	_merge_order.clear();
+	for (size_t i = 0; i < _notes.size(); ++i) {
+		const Notification& note = _notes[i].header;
+		if (!note.port->is_monitored() &&
+		    (note.key == uris.ingen_value || note.key == uris.ingen_activity)) {
+			_merge_order.push_back(i);
+		}
+	}
+
+	std::sort(_merge_order.begin(), _merge_order.end(),
+	          [this](const size_t lhs, const size_t rhs) {
+		          const Note& l = _notes[lhs];
+		          const Note& r = _notes[rhs];
+		          return (l.header.port < r.header.port ||
+		                  (l.header.port == r.header.port &&
+		                   (l.header.key < r.header.key ||
+		                    (l.header.key == r.header.key && l.rank < r.rank))));
+	          });
+
+	// Merge each run of updates into the first, keeping its position
+	for (size_t i = 0; i < _merge_order.size();) {
+		Note& first = _notes[_merge_order[i]];
+		size_t j = i + 1;
+		for (; j < _merge_order.size(); ++j) {
+			Note& note = _notes[_merge_order[j]];
+			if (note.header.port != first.header.port ||
+			    note.header.key != first.header.key) {
+				break;
+			}
+
+			// Keep latest value, or peak for audio activity
+			if (note.header.key != uris.ingen_activity ||
+			    note.header.type != forge.Float ||
+			    first.header.type != forge.Float ||
+			    note_float(note) > note_float(first)) {
+				first.header.size = note.header.size;
+				first.header.type = note.header.type;
+				first.offset      = note.offset;
+			}
+			note.emit = false;
+			++_merged_notifications;
+		}
+		i = j;
+	}
+
+	for (const size_t i : _emit_order) {
+		const Note& n = _notes[i];
+		if (!n.emit) {
+			continue;
+		}
+
+		const Notification& note = n.header;
+		const URI* const    key  = key_uri(note.key);
+		if (key) {
+			const Atom value(
+				note.size, note.type, _note_values.data() + n.offset);
+			_broadcaster->set_property(note.port->uri(), *key, value);
+			if (note.port->is_input() &&
+			    (note.key == uris.ingen_value ||
+			     note.key == uris.midi_binding)) {
+				// Update the port's properties, which the store may be reading
+				std::lock_guard<Store::Mutex> lock(store()->mutex());
+				note.port->set_property(*key, value);
+			}
+		} else {
+			log().rt_error("Error unmapping notification key URI\n");
+		}
 	}
 }
 
 bool
 Engine::pending_notifications()
 {
-	for (const RunContext* ctx : _run_contexts) {
-		if (ctx->pending_notifications()) {
+	for (const NotificationRing* ring : _notifications) {
+		if (ring->pending()) {
 			return true;
 		}
 	}
@@ -320,10 +513,34 @@ Engine::load_properties() const
 		       uris.forge.make(_run_load.max / 100.0f) } };
 }
 
+Properties
+Engine::overrun_properties(bool record) const
+{
+	const ingen::URIs& uris = world()->uris();
+
+	Properties props = {
+		{ uris.ingen_overruns,
+		  uris.forge.make(int32_t(_flight_recorder->n_overruns())) } };
+
+	const FlightRecorder::Snapshot* const snapshot =
+		_flight_recorder->last_snapshot();
+	if (snapshot && snapshot->slowest) {
+		props.emplace(uris.ingen_slowestBlock,
+		              uris.forge.make_urid(int32_t(snapshot->slowest)));
+	}
+	if (snapshot && record) {
+		props.emplace(uris.ingen_flightRecord,
+		              uris.forge.alloc(snapshot->json));
+	}
+
+	return props;
+}
+
 bool
 Engine::main_iteration()
 {
 	_post_processor->process();
+	_broadcaster->flush_updates();
 	_maid->cleanup();
 
 	if (_run_load.changed) {
@@ -331,6 +548,14 @@ Engine::main_iteration()
 		_run_load.changed = false;
 	}
 
+	if (_trace_requested.exchange(false) && _tracer->enabled()) {
+		write_trace();
+	}
+
+	if (_flight_recorder->overran()) {
+		write_overrun();
+	}
+
 	return !_quit_flag;
 }
 
@@ -432,15 +657,65 @@ Engine::deactivate()
 		_root_graph->deactivate();
 	}
 
+	if (_activated && _tracer->enabled()) {
+		write_trace();
+	}
+
 	ThreadManager::single_threaded = true;
 	_activated = false;
 }
 
+void
+Engine::write_trace()
+{
+	const std::string path = world()->conf().option("trace-file").ptr<char>();
+	if (_tracer->write(path)) {
+		log().info(fmt("Wrote execution trace to %1%\n") % path);
+	} else {
+		log().error(fmt("Failed to write execution trace to %1%\n") % path);
+	}
+}
+
+void
+Engine::write_overrun()
+{
+	const FlightRecorder::Snapshot& snapshot = _flight_recorder->take_snapshot();
+	const char* const slowest = world()->uri_map().unmap_uri(snapshot.slowest);
+	log().warn(fmt("Cycle %1% overran at %2%%% load, slowest block %3% took %4% us\n")
+	           % snapshot.cycle % snapshot.load
+	           % (slowest ? slowest : "(none)") % snapshot.duration);
+
+	const Atom& prefix = world()->conf().option("overrun-file");
+	if (prefix.is_valid()) {
+		const std::string path = (std::string(prefix.ptr<char>()) + "-" +
+		                          std::to_string(snapshot.cycle) + ".json");
+		const std::string& json    = snapshot.json;
+		FILE*              out     = fopen(path.c_str(), "w");
+		bool               written = false;
+		if (out) {
+			written = fwrite(json.c_str(), 1, json.size(), out) == json.size();
+			written = !fclose(out) && written;
+		}
+
+		if (written) {
+			log().info(fmt("Wrote flight record to %1%\n") % path);
+		} else {
+			log().error(fmt("Failed to write flight record to %1%\n") % path);
+		}
+	}
+
+	_broadcaster->put(URI("ingen:/engine/overrun"), overrun_properties(false));
+}
+
 unsigned
 Engine::run(uint32_t sample_count)
 {
 	RunContext& ctx = run_context();
+	ctx.set_current();
 	_cycle_start_time = current_time();
+	if (_flight_recorder->enabled()) {
+		_flight_recorder->begin_cycle();
+	}
 
 	post_processor()->set_end_time(ctx.end());
 
@@ -469,8 +744,23 @@ Engine::run(uint32_t sample_count)
 	}
 
 	// Update load for this cycle
+	const uint64_t cycle_end_time = current_time();
 	if (ctx.duration() > 0) {
-		_run_load.update(current_time() - _cycle_start_time, ctx.duration());
+		_run_load.update(cycle_end_time - _cycle_start_time, ctx.duration());
+	}
+
+	if (_tracer->enabled()) {
+		_tracer->record(ctx.id(), Tracer::Type::CYCLE,
+		                _cycle_start_time, cycle_end_time);
+	}
+
+	if (_flight_recorder->enabled() && ctx.duration() > 0) {
+		_flight_recorder->end_cycle(_cycle_start_time,
+		                            cycle_end_time,
+		                            ctx.duration(),
+		                            (_root_graph
+		                             ? _root_graph->compiled_graph().get()
+		                             : nullptr));
 	}
 
 	return n_processed_events;
@@ -479,7 +769,7 @@ Engine::run(uint32_t sample_count)
 bool
 Engine::pending_events() const
 {
-	return !_pre_processor->empty() || _post_processor->pending();
+	return !_pre_processor->queue_empty() || _post_processor->pending();
 }
 
 void
@@ -519,7 +809,79 @@ bool
 Engine::unregister_client(SPtr<Interface> client)
 {
 	log().info(fmt("Unregistering client <%1%>\n") % client->uri().c_str());
-	return _broadcaster->unregister_client(client);
+
+	SPtr<ShmServer> shm;
+	{
+		std::lock_guard<std::mutex> lock(_shm_mutex);
+		const auto s = _shm_servers.find(client);
+		if (s != _shm_servers.end()) {
+			shm = s->second;
+			_shm_servers.erase(s);
+		}
+	}
+
+	const bool removed = _broadcaster->unregister_client(client);
+	if (removed && store()) {
+		std::lock_guard<Store::Mutex> lock(store()->mutex());
+		update_watched_ports(Raul::Path("/"));
+	}
+
+	return removed;
+}
+
+void
+Engine::update_watched_ports(const Raul::Path& root)
+{
+	const Broadcaster::Paths watched = _broadcaster->watched_paths();
+	Store&                   store   = *this->store();
+
+	Store::iterator begin = store.begin();
+	Store::iterator end   = store.end();
+	if (!root.is_root()) {
+		if ((begin = store.find(root)) == store.end()) {
+			return;
+		}
+		end = store.find_descendants_end(begin);
+	}
+
+	for (auto i = begin; i != end; ++i) {
+		PortImpl* const port = dynamic_cast<PortImpl*>(i->second.get());
+		if (port) {
+			port->set_watched(Broadcaster::is_watched(watched, port->path()));
+		}
+	}
+}
+
+Status
+Engine::attach_shared_memory(SPtr<Interface> client, const std::string& name)
+{
+#ifdef HAVE_SHM_OPEN
+	// Only clients with their own queue (remote clients) can be switched
+	SPtr<ClientQueue> queue = dynamic_ptr_cast<ClientQueue>(client);
+	if (!queue) {
+		return Status::BAD_REQUEST;
+	}
+
+	SPtr<ShmSegment> segment(ShmSegment::open(name));
+	if (!segment) {
+		log().error(fmt("Failed to open shared memory `%1%' (%2%)\n")
+		            % name % strerror(errno));
+		return Status::FAILURE;
+	}
+
+	std::lock_guard<std::mutex> lock(_shm_mutex);
+	if (_shm_servers.count(client)) {
+		return Status::EXISTS;
+	}
+
+	_shm_servers.emplace(client, std::make_shared<ShmServer>(
+		                     *_world, *this, queue, segment));
+	log().info(fmt("Client <%1%> using shared memory `%2%'\n")
+	           % client->uri() % name);
+	return Status::SUCCESS;
+#else
+	return Status::FAILURE;
+#endif
 }
 
 } // namespace server
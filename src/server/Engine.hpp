@@ -17,23 +17,29 @@
 #ifndef INGEN_ENGINE_ENGINE_HPP
 #define INGEN_ENGINE_ENGINE_HPP
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <map>
 #include <mutex>
 #include <random>
+#include <string>
+#include <vector>
 
 #include "ingen/Clock.hpp"
 #include "ingen/EngineBase.hpp"
 #include "ingen/Properties.hpp"
+#include "ingen/Status.hpp"
+#include "ingen/URI.hpp"
 #include "ingen/ingen.h"
 #include "ingen/types.hpp"
 
 #include "Event.hpp"
 #include "Load.hpp"
+#include "NotificationRing.hpp"
 
 namespace Raul {
 class Maid;
-class RingBuffer;
 }
 
 namespace ingen {
@@ -52,13 +58,16 @@ class BufferFactory;
 class ControlBindings;
 class Driver;
 class EventWriter;
+class FlightRecorder;
 class GraphImpl;
 class LV2Options;
 class PostProcessor;
 class PreProcessor;
 class RunContext;
+class ShmServer;
 class SocketListener;
 class Task;
+class Tracer;
 class UndoStack;
 class Worker;
 
@@ -89,11 +98,26 @@ public:
 	unsigned run(uint32_t sample_count) override;
 	void quit() override;
 	bool main_iteration() override;
+	void request_trace() override { _trace_requested = true; }
 	void register_client(SPtr<Interface> client) override;
 	bool unregister_client(SPtr<Interface> client) override;
 
 	void listen() override;
 
+	/** Switch a client to the shared memory segment called `name`.
+	 *
+	 * After this, all messages to and from the client go through the segment,
+	 * until the client is unregistered.
+	 */
+	Status attach_shared_memory(SPtr<Interface> client, const std::string& name);
+
+	/** Update whether ports at or under `root` are watched by a client.
+	 *
+	 * This must be called with the store locked whenever subscriptions change
+	 * or ports are moved, so ports only compute monitor values when needed.
+	 */
+	void update_watched_ports(const Raul::Path& root);
+
 	/** Return a random [0..1] float with uniform distribution */
 	float frand() { return _uniform_dist(_rand_engine); }
 
@@ -146,6 +170,8 @@ public:
     const UPtr<UndoStack>&       redo_stack()       const { return _redo_stack; }
     const UPtr<Worker>&          worker()           const { return _worker; }
     const UPtr<Worker>&          sync_worker()      const { return _sync_worker; }
+    const UPtr<Tracer>&          tracer()           const { return _tracer; }
+    const UPtr<FlightRecorder>&  flight_recorder()  const { return _flight_recorder; }
 
     GraphImpl* root_graph() const { return _root_graph; }
 	void       set_root_graph(GraphImpl* graph);
@@ -156,6 +182,14 @@ public:
 	void advance(SampleCount nframes) override;
 	void locate(FrameTime s, SampleCount nframes) override;
 
+	/** Emit notifications from the audio threads before `end`.
+	 *
+	 * Notifications from all run contexts are merged in time order.  Monitor
+	 * updates for the same port that are emitted together are merged so that
+	 * only the latest value (or peak, for activity) is broadcast.
+	 * Notifications are read into buffers that are reused for every call, so
+	 * this does not allocate once the buffers have grown large enough.
+	 */
 	void  emit_notifications(FrameTime end);
 	bool  pending_notifications();
 	bool  wait_for_tasks();
@@ -175,7 +209,34 @@ public:
 
 	Properties load_properties() const;
 
+	/** Return a description of overruns, with the last flight record if
+	 * `record` is true.
+	 */
+	Properties overrun_properties(bool record) const;
+
+	/** Return the number of monitor updates merged before broadcasting. */
+	uint64_t merged_notifications() const { return _merged_notifications; }
+
+	/** Return the notification rings of every run context. */
+	const std::vector<NotificationRing*>& notification_rings() const {
+		return _notifications;
+	}
+
 private:
+	/** A notification being emitted, with its value in _note_values. */
+	struct Note {
+		Notification header;
+		size_t       offset;  ///< Offset of value in _note_values
+		size_t       rank;    ///< Index in time order
+		bool         emit;    ///< False if merged into an earlier note
+	};
+
+	float      note_float(const Note& note) const;
+	const URI* key_uri(LV2_URID key);
+
+	void write_trace();
+	void write_overrun();
+
 	ingen::World* _world;
 
 	SPtr<LV2Options>      _options;
@@ -195,20 +256,35 @@ private:
 	SPtr<EventWriter>     _event_writer;
 	SPtr<Interface>       _interface;
 	UPtr<AtomReader>      _atom_interface;
+	UPtr<Tracer>          _tracer;
+	UPtr<FlightRecorder>  _flight_recorder;
 	GraphImpl*            _root_graph;
 
-	std::vector<Raul::RingBuffer*> _notifications;
+	std::vector<NotificationRing*> _notifications;
 	std::vector<RunContext*>       _run_contexts;
 	uint64_t                       _cycle_start_time;
 	Load                           _run_load;
 	Clock                          _clock;
 
+	uint64_t _merged_notifications;  ///< Number of merged monitor updates
+
+	std::vector<Note>       _notes;        ///< Notes being emitted
+	std::vector<uint8_t>    _note_values;  ///< Values of notes being emitted
+	std::vector<size_t>     _emit_order;   ///< Notes in time order
+	std::vector<size_t>     _merge_order;  ///< Mergeable notes by port and key
+	std::map<LV2_URID, URI> _key_uris;     ///< Notification key URIs
+
 	std::mt19937                          _rand_engine;
 	std::uniform_real_distribution<float> _uniform_dist;
 
 	std::condition_variable _tasks_available;
 	std::mutex              _tasks_mutex;
 
+	std::map<SPtr<Interface>, SPtr<ShmServer>> _shm_servers;
+	std::mutex                                 _shm_mutex;
+
+	std::atomic<bool> _trace_requested;
+
 	bool _quit_flag;
 	bool _reset_load_flag;
 	bool _atomic_bundles;
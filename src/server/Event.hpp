@@ -63,6 +63,9 @@ public:
 		UNBLOCK  ///< Finish atomic executed block of events
 	};
 
+	/** Stage of processing, for measuring latency. */
+	enum class Stage { ENQUEUED, PREPARED, EXECUTED };
+
 	/** Pre-process event before execution (non-realtime). */
 	virtual bool pre_process(PreProcessContext& ctx) = 0;
 
@@ -84,6 +87,16 @@ public:
 	/** Set the time stamp of this event. */
 	inline void set_time(SampleCount time) { _time = time; }
 
+	/** Return when this event reached a stage in microseconds, or zero. */
+	inline uint64_t stage_time(Stage stage) const {
+		return _stage_times[static_cast<unsigned>(stage)];
+	}
+
+	/** Set when this event reached a stage (see Engine::current_time()). */
+	inline void set_stage_time(Stage stage, uint64_t time) {
+		_stage_times[static_cast<unsigned>(stage)] = time;
+	}
+
 	/** Get the next event to be processed after this one. */
 	Event* next() const { return _next.load(); }
 
@@ -96,6 +109,21 @@ public:
 	/** Return the blocking behaviour of this event (after construction). */
 	virtual Execution get_execution() const { return Execution::NORMAL; }
 
+	/** Return true iff this event may be held until its time while events
+	 * enqueued after it are executed (after pre-processing).
+	 */
+	virtual bool is_schedulable() const { return false; }
+
+	/** Return the only object this event may change, or null if unknown.
+	 *
+	 * Events that change an object unrelated to the subjects of scheduled
+	 * events do not have to wait for them (see PreProcessor::process()).
+	 */
+	virtual const Node* subject() const { return nullptr; }
+
+	/** Return true iff this event does not change anything. */
+	virtual bool is_read_only() const { return false; }
+
 	/** Return undo mode of this event. */
 	Mode get_mode() const { return _mode; }
 
@@ -113,6 +141,7 @@ protected:
 		, _time(time)
 		, _status(Status::NOT_PREPARED)
 		, _mode(Mode::NORMAL)
+		, _stage_times{0, 0, 0}
 	{}
 
 	/** Constructor for internal events only */
@@ -123,6 +152,7 @@ protected:
 		, _time(0)
 		, _status(Status::NOT_PREPARED)
 		, _mode(Mode::NORMAL)
+		, _stage_times{0, 0, 0}
 	{}
 
 	inline bool pre_process_done(Status st) {
@@ -155,6 +185,7 @@ protected:
 	Status              _status;
 	std::string         _err_subject;
 	Mode                _mode;
+	uint64_t            _stage_times[3];
 };
 
 } // namespace server
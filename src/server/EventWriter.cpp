@@ -14,6 +14,8 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <limits>
+
 #include <boost/variant/apply_visitor.hpp>
 
 #include "ingen/URIs.hpp"
@@ -37,6 +39,25 @@ EventWriter::now() const
 	return _engine.event_time();
 }
 
+bool
+EventWriter::check_time(int32_t seq, const URI& subject, int64_t frame)
+{
+	if (frame < 0 || frame > std::numeric_limits<FrameTime>::max()) {
+		if (_respondee) {
+			_respondee->response(seq, Status::BAD_REQUEST, subject);
+		}
+		return false;
+	}
+
+	return true;
+}
+
+SampleCount
+EventWriter::time(int64_t frame) const
+{
+	return frame ? SampleCount(frame) : now();
+}
+
 void
 EventWriter::message(const Message& msg)
 {
@@ -60,14 +81,22 @@ EventWriter::operator()(const BundleEnd& msg)
 void
 EventWriter::operator()(const Put& msg)
 {
-	_engine.enqueue_event(new events::Delta(_engine, _respondee, now(), msg),
+	if (!check_time(msg.seq, msg.uri, msg.time)) {
+		return;
+	}
+
+	_engine.enqueue_event(new events::Delta(_engine, _respondee, time(msg.time), msg),
 	                      _event_mode);
 }
 
 void
 EventWriter::operator()(const Delta& msg)
 {
-	_engine.enqueue_event(new events::Delta(_engine, _respondee, now(), msg),
+	if (!check_time(msg.seq, msg.uri, msg.time)) {
+		return;
+	}
+
+	_engine.enqueue_event(new events::Delta(_engine, _respondee, time(msg.time), msg),
 	                      _event_mode);
 }
 
@@ -118,7 +147,11 @@ EventWriter::operator()(const DisconnectAll& msg)
 void
 EventWriter::operator()(const SetProperty& msg)
 {
-	_engine.enqueue_event(new events::Delta(_engine, _respondee, now(), msg),
+	if (!check_time(msg.seq, msg.subject, msg.time)) {
+		return;
+	}
+
+	_engine.enqueue_event(new events::Delta(_engine, _respondee, time(msg.time), msg),
 	                      _event_mode);
 }
 
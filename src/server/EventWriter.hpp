@@ -78,6 +78,20 @@ protected:
 
 private:
 	SampleCount now() const;
+
+	/** Return true iff `frame` is a valid message time, or respond if not.
+	 *
+	 * Engine time is 32 bits, so frames outside that range are rejected rather
+	 * than silently truncated to some other time.
+	 */
+	bool check_time(int32_t seq, const URI& subject, int64_t frame);
+
+	/** Return the time for a message scheduled at `frame`, or now if zero.
+	 *
+	 * Zero is the time of messages that do not specify one, so an event can
+	 * not be scheduled for exactly frame zero (it is executed immediately).
+	 */
+	SampleCount time(int64_t frame) const;
 };
 
 } // namespace server
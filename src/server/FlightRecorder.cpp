@@ -0,0 +1,194 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "ingen/URIMap.hpp"
+
+#include "CompiledGraph.hpp"
+#include "FlightRecorder.hpp"
+
+namespace ingen {
+namespace server {
+
+/** Number of block records kept for each thread (must be a power of two). */
+static const size_t ring_size = 1 << 14;
+
+FlightRecorder::FlightRecorder(URIMap&  map,
+                               unsigned n_threads,
+                               unsigned n_cycles,
+                               unsigned threshold)
+	: _map(map)
+	, _cycles(std::max(n_cycles, 1u), Cycle{0, 0, 0, 0})
+	, _cycle(0)
+	, _stopped(false)
+	, _n_overruns(0)
+	, _overrun(0)
+	, _threshold(threshold)
+	, _snapshot{0, 0, 0, 0, std::string()}
+{
+	if (threshold) {
+		for (unsigned i = 0; i < n_threads; ++i) {
+			_rings.emplace_back(new Ring(ring_size));
+		}
+	}
+}
+
+void
+FlightRecorder::record(unsigned thread,
+                       LV2_URID urid,
+                       uint64_t start,
+                       uint64_t end)
+{
+	if (!_stopped.load(std::memory_order_acquire)) {
+		Ring& ring = *_rings[thread];
+		ring.records[ring.head++ & (ring_size - 1)] = {
+			_cycle.load(std::memory_order_relaxed),
+			start,
+			uint32_t(end - start),
+			urid };
+	}
+}
+
+void
+FlightRecorder::end_cycle(uint64_t             start,
+                          uint64_t             end,
+                          uint64_t             duration,
+                          const CompiledGraph* graph)
+{
+	if (_stopped.load(std::memory_order_relaxed)) {
+		if ((end - start) * 100 > duration * _threshold) {
+			++_n_overruns;  // Missed while waiting for a snapshot
+		}
+		return;
+	}
+
+	const uint64_t cycle = _cycle.load(std::memory_order_relaxed);
+	_cycles[cycle % _cycles.size()] = { cycle, start, end, duration };
+
+	if ((end - start) * 100 > duration * _threshold) {
+		++_n_overruns;
+		_overrun = cycle;
+		if (graph) {
+			_layout = graph->layout();  // Previous was released by take_snapshot()
+		}
+		_stopped.store(true, std::memory_order_release);
+	}
+}
+
+/** Append `str` to `out` as a JSON string. */
+static void
+append_string(std::string& out, const std::string& str)
+{
+	out += '"';
+	for (const char c : str) {
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		} else if (c == '\n') {
+			out += "\\n";
+		} else if ((unsigned char)c < 0x20) {
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)c);
+			out += buf;
+		} else {
+			out += c;
+		}
+	}
+	out += '"';
+}
+
+const FlightRecorder::Snapshot&
+FlightRecorder::take_snapshot()
+{
+	const uint64_t n_cycles = _cycles.size();
+	const uint64_t first    = _overrun > n_cycles ? _overrun - n_cycles + 1 : 1;
+
+	Snapshot snapshot{_overrun, 0, 0, 0, "{\"traceEvents\":["};
+	std::string& json = snapshot.json;
+
+	// Add cycles, which are all run by the main run context
+	const char* sep = "\n";
+	for (const Cycle& c : _cycles) {
+		if (c.cycle >= first && c.cycle <= _overrun) {
+			const uint64_t load = c.duration ? (c.end - c.start) * 100 / c.duration : 0;
+			if (c.cycle == _overrun) {
+				snapshot.load = uint32_t(load);
+			}
+
+			json += sep;
+			json += "{\"name\":\"cycle\",\"cat\":\"cycle\",\"ph\":\"X\",\"ts\":";
+			json += std::to_string(c.start);
+			json += ",\"dur\":" + std::to_string(c.end - c.start);
+			json += ",\"pid\":1,\"tid\":0,\"args\":{\"cycle\":";
+			json += std::to_string(c.cycle);
+			json += ",\"load\":" + std::to_string(load) + "}}";
+			sep = ",\n";
+		}
+	}
+
+	// Add the blocks run by each thread
+	for (size_t t = 0; t < _rings.size(); ++t) {
+		const Ring&    ring  = *_rings[t];
+		const uint64_t begin = ring.head > ring_size ? ring.head - ring_size : 0;
+
+		json += sep;
+		json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+		json += std::to_string(t);
+		json += ",\"args\":{\"name\":\"run " + std::to_string(t) + "\"}}";
+
+		for (uint64_t i = ring.head; i > begin; --i) {
+			const Record& r = ring.records[(i - 1) & (ring_size - 1)];
+			if (r.cycle < first) {
+				break;
+			} else if (r.cycle == _overrun && r.duration >= snapshot.duration) {
+				snapshot.slowest  = r.urid;
+				snapshot.duration = r.duration;
+			}
+
+			const char* const uri = _map.unmap_uri(r.urid);
+			json += ",\n{\"name\":";
+			append_string(json, uri ? uri : "block");
+			json += ",\"cat\":\"block\",\"ph\":\"X\",\"ts\":";
+			json += std::to_string(r.start);
+			json += ",\"dur\":" + std::to_string(r.duration);
+			json += ",\"pid\":1,\"tid\":" + std::to_string(t);
+			json += ",\"args\":{\"cycle\":" + std::to_string(r.cycle) + "}}";
+		}
+	}
+
+	// Describe the overrun and the task layout at the time
+	json += "\n],\"otherData\":{\"overrunCycle\":";
+	json += std::to_string(_overrun);
+	json += ",\"load\":" + std::to_string(snapshot.load);
+	json += ",\"threshold\":" + std::to_string(_threshold);
+	json += ",\"layout\":";
+	append_string(json, _layout ? *_layout : std::string());
+	json += "}}\n";
+
+	_snapshot = std::move(snapshot);
+
+	// Resume recording
+	_layout.reset();
+	_stopped.store(false, std::memory_order_release);
+
+	return _snapshot;
+}
+
+} // namespace server
+} // namespace ingen
@@ -0,0 +1,148 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_FLIGHTRECORDER_HPP
+#define INGEN_ENGINE_FLIGHTRECORDER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ingen/types.hpp"
+#include "lv2/urid/urid.h"
+
+namespace ingen {
+
+class URIMap;
+
+namespace server {
+
+class CompiledGraph;
+
+/** A recorder of block timings that keeps the cycles before an overrun.
+ *
+ * Every run context records the time it spends running each block into its
+ * own fixed-size ring, so the timings of the last few cycles are always
+ * available.  When a cycle takes longer than a threshold fraction of its
+ * duration, recording stops until the main thread takes a snapshot of the
+ * cycles up to and including the overrun, so they can be inspected after the
+ * fact.  Snapshots are Chrome trace event JSON, like those of the Tracer, with
+ * the layout of the root graph's tasks at the time of the overrun.
+ *
+ * \ingroup engine
+ */
+class FlightRecorder
+{
+public:
+	/** A snapshot of the cycles leading up to an overrun. */
+	struct Snapshot {
+		uint64_t    cycle;     ///< Number of the overrun cycle
+		uint32_t    load;      ///< Percentage of cycle duration spent running
+		LV2_URID    slowest;   ///< Slowest block in the overrun cycle, or 0
+		uint32_t    duration;  ///< Time spent running slowest in microseconds
+		std::string json;      ///< Chrome trace event JSON
+	};
+
+	/** Create a recorder, or a disabled one if `threshold` is zero.
+	 *
+	 * @param n_threads Number of run contexts that record timings.
+	 * @param n_cycles Number of cycles kept in a snapshot.
+	 * @param threshold Percentage of cycle duration that is an overrun.
+	 */
+	FlightRecorder(URIMap&  map,
+	               unsigned n_threads,
+	               unsigned n_cycles,
+	               unsigned threshold);
+
+	/** Return true iff timings are being recorded. */
+	bool enabled() const { return !_rings.empty(); }
+
+	/** Start a new cycle (realtime safe, main run context only). */
+	void begin_cycle() {
+		_cycle.store(_cycle.load(std::memory_order_relaxed) + 1,
+		             std::memory_order_relaxed);
+	}
+
+	/** Record the time spent running a block (realtime safe). */
+	void record(unsigned thread, LV2_URID urid, uint64_t start, uint64_t end);
+
+	/** Finish a cycle, and stop recording if it overran.
+	 *
+	 * Realtime safe, main run context only.
+	 *
+	 * @param start Start time of the cycle in microseconds.
+	 * @param end End time of the cycle in microseconds.
+	 * @param duration Duration of the cycle in microseconds.
+	 * @param graph Compiled root graph run in this cycle, or null.
+	 */
+	void end_cycle(uint64_t             start,
+	               uint64_t             end,
+	               uint64_t             duration,
+	               const CompiledGraph* graph);
+
+	/** Return true iff an overrun is waiting for a snapshot to be taken. */
+	bool overran() const { return _stopped.load(std::memory_order_acquire); }
+
+	/** Take a snapshot of an overrun and resume recording (main thread). */
+	const Snapshot& take_snapshot();
+
+	/** Return the last snapshot taken, if any. */
+	const Snapshot* last_snapshot() const {
+		return _snapshot.cycle ? &_snapshot : nullptr;
+	}
+
+	/** Return the total number of overruns, including those not captured. */
+	uint32_t n_overruns() const { return _n_overruns; }
+
+private:
+	struct Record {
+		uint64_t cycle;
+		uint64_t start;
+		uint32_t duration;
+		LV2_URID urid;
+	};
+
+	struct Cycle {
+		uint64_t cycle;
+		uint64_t start;
+		uint64_t end;
+		uint64_t duration;
+	};
+
+	struct Ring {
+		explicit Ring(size_t size) : head(0), records(new Record[size]) {}
+
+		uint64_t       head;  ///< Total number of records written
+		UPtr<Record[]> records;
+	};
+
+	URIMap&                  _map;
+	std::vector<UPtr<Ring>>  _rings;
+	std::vector<Cycle>       _cycles;     ///< Ring of the last cycles
+	std::atomic<uint64_t>    _cycle;      ///< Number of the current cycle
+	std::atomic<bool>        _stopped;    ///< True iff recording has stopped
+	std::atomic<uint32_t>    _n_overruns;
+	SPtr<const std::string>  _layout;     ///< Task layout of overrun cycle
+	uint64_t                 _overrun;    ///< Number of the overrun cycle
+	unsigned                 _threshold;
+	Snapshot                 _snapshot;
+};
+
+} // namespace server
+} // namespace ingen
+
+#endif // INGEN_ENGINE_FLIGHTRECORDER_HPP
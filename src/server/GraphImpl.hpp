@@ -167,6 +167,9 @@ public:
 	/** Set a new compiled graph to run, and return the old one. */
 	void set_compiled_graph(MPtr<CompiledGraph>&& cg);
 
+	/** Return the compiled graph that is run (process thread only). */
+	const MPtr<CompiledGraph>& compiled_graph() const { return _compiled_graph; }
+
 	const MPtr<Ports>& external_ports() { return _ports; }
 
 	void set_external_ports(MPtr<Ports>&& pa) { _ports = std::move(pa); }
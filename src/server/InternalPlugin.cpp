@@ -17,7 +17,11 @@
 #include "ingen/URIs.hpp"
 #include "internals/Controller.hpp"
 #include "internals/BlockDelay.hpp"
+#include "internals/Crossfade.hpp"
+#include "internals/Gain.hpp"
+#include "internals/Mixer.hpp"
 #include "internals/Note.hpp"
+#include "internals/Pan.hpp"
 #include "internals/Time.hpp"
 #include "internals/Trigger.hpp"
 
@@ -52,8 +56,16 @@ InternalPlugin::instantiate(BufferFactory&      bufs,
 		return new BlockDelayNode(this, bufs, symbol, polyphonic, parent, srate);
 	} else if (uri() == NS_INTERNALS "Controller") {
 		return new ControllerNode(this, bufs, symbol, polyphonic, parent, srate);
+	} else if (uri() == NS_INTERNALS "Crossfade") {
+		return new CrossfadeNode(this, bufs, symbol, polyphonic, parent, srate);
+	} else if (uri() == NS_INTERNALS "Gain") {
+		return new GainNode(this, bufs, symbol, polyphonic, parent, srate);
+	} else if (uri() == NS_INTERNALS "Mixer") {
+		return new MixerNode(this, bufs, symbol, polyphonic, parent, srate);
 	} else if (uri() == NS_INTERNALS "Note") {
 		return new NoteNode(this, bufs, symbol, polyphonic, parent, srate);
+	} else if (uri() == NS_INTERNALS "Pan") {
+		return new PanNode(this, bufs, symbol, polyphonic, parent, srate);
 	} else if (uri() == NS_INTERNALS "Time") {
 		return new TimeNode(this, bufs, symbol, polyphonic, parent, srate);
 	} else if (uri() == NS_INTERNALS "Trigger") {
@@ -61,6 +61,8 @@ LV2Block::LV2Block(LV2Plugin*          plugin,
 	: BlockImpl(plugin, symbol, polyphonic, parent, srate)
 	, _lv2_plugin(plugin)
 	, _worker_iface(nullptr)
+	, _work_requested(0)
+	, _work_finished(0)
 {
 	assert(_lv2_plugin);
 }
@@ -453,6 +455,11 @@ LV2Block::instantiate(BufferFactory& bufs, const LilvState* state)
 		_worker_iface = (const LV2_Worker_Interface*)
 			lilv_instance_get_extension_data(instance(0),
 			                                 LV2_WORKER__interface);
+
+		// Responses are copied through a ring to avoid allocating per response
+		const uint32_t size = bufs.engine().event_queue_size();
+		_responses       = UPtr<Raul::RingBuffer>(new Raul::RingBuffer(size));
+		_response_buffer = UPtr<uint8_t[]>(new uint8_t[size]);
 	}
 
 	return ret;
@@ -548,9 +555,14 @@ LV2Block::work_respond(LV2_Worker_Respond_Handle handle,
                        uint32_t                  size,
                        const void*               data)
 {
-	LV2Block* block = (LV2Block*)handle;
-	LV2Block::Response* r = new LV2Block::Response(size, data);
-	block->_responses.push_back(*r);
+	LV2Block* const   block     = (LV2Block*)handle;
+	Raul::RingBuffer& responses = *block->_responses;
+	if (responses.write_space() < sizeof(size) + size) {
+		return LV2_WORKER_ERR_NO_SPACE;
+	}
+
+	responses.write(sizeof(size), &size);
+	responses.write(size, data);
 	return LV2_WORKER_SUCCESS;
 }
 
@@ -587,11 +599,12 @@ LV2Block::post_process(RunContext& context)
 	   monitored notification ports. */
 	if (_worker_iface) {
 		LV2_Handle inst = lilv_instance_get_handle(instance(0));
-		while (!_responses.empty()) {
-			Response& r = _responses.front();
-			_worker_iface->work_response(inst, r.size, r.data);
-			_responses.pop_front();
-			context.engine().maid()->dispose(&r);
+		uint32_t size = 0;
+		while (_responses->peek(sizeof(size), &size) == sizeof(size) &&
+		       _responses->read_space() >= sizeof(size) + size) {
+			_responses->skip(sizeof(size));
+			_responses->read(size, _response_buffer.get());
+			_worker_iface->work_response(inst, size, _response_buffer.get());
 		}
 
 		if (_worker_iface->end_run) {
@@ -17,11 +17,13 @@
 #ifndef INGEN_ENGINE_LV2BLOCK_HPP
 #define INGEN_ENGINE_LV2BLOCK_HPP
 
+#include <atomic>
 #include <mutex>
 
 #include "lilv/lilv.h"
 #include "lv2/worker/worker.h"
 #include "raul/Maid.hpp"
+#include "raul/RingBuffer.hpp"
 
 #include "BufferRef.hpp"
 #include "BlockImpl.hpp"
@@ -65,6 +67,18 @@ public:
 
 	LV2_Worker_Status work(uint32_t size, const void* data);
 
+	/** Return the sequence number of a new work request (realtime safe). */
+	uint32_t next_work_seq() { return _work_requested++; }
+
+	/** Return true iff the work request `seq` is the next to be worked. */
+	bool work_is_next(uint32_t seq) const { return _work_finished == seq; }
+
+	/** Finish working the next request, allowing the one after to start. */
+	void finish_work() { ++_work_finished; }
+
+	/** Skip requests before `seq`, which were lost and will never be worked. */
+	void skip_work(uint32_t seq) { _work_finished = seq; }
+
 	void run(RunContext& context) override;
 	void post_process(RunContext& context) override;
 
@@ -110,30 +124,6 @@ protected:
 		}
 	}
 
-	struct Response : public Raul::Maid::Disposable
-	                , public Raul::Noncopyable
-	                , public boost::intrusive::slist_base_hook<>
-	{
-		inline Response(uint32_t s, const void* d)
-			: size(s)
-			, data(malloc(s))
-		{
-			memcpy(data, d, s);
-		}
-
-		~Response() {
-			free(data);
-		}
-
-		const uint32_t size;
-		void* const    data;
-	};
-
-	typedef boost::intrusive::slist<Response,
-	                                boost::intrusive::cache_last<true>,
-	                                boost::intrusive::constant_time_size<false>
-	                                > Responses;
-
 	static LV2_Worker_Status work_respond(
 		LV2_Worker_Respond_Handle handle, uint32_t size, const void* data);
 
@@ -142,7 +132,10 @@ protected:
 	MPtr<Instances>                 _prepared_instances;
 	const LV2_Worker_Interface*     _worker_iface;
 	std::mutex                      _work_mutex;
-	Responses                       _responses;
+	std::atomic<uint32_t>           _work_requested;
+	std::atomic<uint32_t>           _work_finished;
+	UPtr<Raul::RingBuffer>          _responses;
+	UPtr<uint8_t[]>                 _response_buffer;
 	SPtr<LV2Features::FeatureArray> _features;
 };
 
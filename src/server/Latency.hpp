@@ -0,0 +1,94 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_LATENCY_HPP
+#define INGEN_ENGINE_LATENCY_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace ingen {
+namespace server {
+
+/** A histogram of latencies in microseconds.
+ *
+ * Buckets are logarithmic with 8 linear sub-buckets per power of two, so
+ * percentiles are accurate to within 12.5% with constant memory.  Latencies
+ * over 2^32 microseconds (over an hour) are counted as 2^32.
+ *
+ * \ingroup engine
+ */
+struct Latency
+{
+	void update(uint64_t usec) {
+		++buckets[bucket(std::min(usec, uint64_t(max_usec)))];
+		max = std::max(max, usec);
+		++n;
+	}
+
+	/** Return the latency below which `percent` percent of samples fall. */
+	uint64_t percentile(unsigned percent) const {
+		const uint64_t rank  = (n * percent + 99) / 100;
+		uint64_t       count = 0;
+		for (size_t i = 0; i < n_buckets; ++i) {
+			count += buckets[i];
+			if (count >= rank && count > 0) {
+				return std::min(upper(i), max);
+			}
+		}
+		return max;
+	}
+
+	static const unsigned sub_bits  = 3;
+	static const unsigned n_subs    = 1 << sub_bits;
+	static const uint64_t max_usec  = uint64_t(1) << 32;
+	static const size_t   n_buckets = n_subs + (32 - sub_bits + 1) * n_subs;
+
+	std::array<uint32_t, n_buckets> buckets{};
+	uint64_t                        max = 0;
+	uint64_t                        n   = 0;
+
+private:
+	static size_t bucket(uint64_t usec) {
+		if (usec < n_subs) {
+			return usec;
+		}
+
+		unsigned e = sub_bits;
+		while (usec >> (e + 1)) {
+			++e;
+		}
+
+		const uint64_t sub = (usec >> (e - sub_bits)) & (n_subs - 1);
+		return n_subs + (e - sub_bits) * n_subs + sub;
+	}
+
+	static uint64_t upper(size_t i) {
+		if (i < n_subs) {
+			return i;
+		}
+
+		const unsigned shift = (i - n_subs) / n_subs;
+		const uint64_t sub   = (i - n_subs) % n_subs;
+		return ((n_subs + sub + 1) << shift) - 1;
+	}
+};
+
+} // namespace server
+} // namespace ingen
+
+#endif // INGEN_ENGINE_LATENCY_HPP
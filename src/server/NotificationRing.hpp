@@ -0,0 +1,131 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_NOTIFICATIONRING_HPP
+#define INGEN_ENGINE_NOTIFICATIONRING_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "lv2/urid/urid.h"
+#include "raul/Noncopyable.hpp"
+#include "raul/RingBuffer.hpp"
+
+#include "types.hpp"
+
+namespace ingen {
+namespace server {
+
+class PortImpl;
+
+/** Header of a notification from the audio thread, followed by its value. */
+struct Notification
+{
+	PortImpl* port;  ///< Port the notification is about
+	FrameTime time;  ///< Time of notification
+	LV2_URID  key;   ///< Property key
+	uint32_t  size;  ///< Size of value
+	LV2_URID  type;  ///< Type of value
+};
+
+/** A ring of notifications from a run context to the post-processor.
+ *
+ * Each run context has its own ring, which is only written by the thread
+ * running that context and only read by the post-processor, so no locking is
+ * required.  The ring keeps statistics about its use, so its size can be
+ * tuned for heavily monitored graphs.
+ *
+ * \ingroup engine
+ */
+class NotificationRing : public Raul::Noncopyable
+{
+public:
+	explicit NotificationRing(uint32_t size)
+		: _ring(size)
+		, _n_written(0)
+		, _n_read(0)
+		, _max_length(0)
+		, _n_dropped(0)
+	{}
+
+	/** Write a notification (realtime safe, writer only).
+	 * @return false if the ring is full, and the notification was dropped.
+	 */
+	bool write(const Notification& header, const void* body) {
+		if (_ring.write_space() < sizeof(header) + header.size) {
+			_n_dropped.store(_n_dropped.load(std::memory_order_relaxed) + 1,
+			                 std::memory_order_relaxed);
+			return false;
+		}
+
+		_ring.write(sizeof(header), &header);
+		_ring.write(header.size, body);
+
+		const uint64_t n_written = _n_written.load(std::memory_order_relaxed) + 1;
+		const uint32_t length    = n_written - _n_read.load(std::memory_order_relaxed);
+		_n_written.store(n_written, std::memory_order_relaxed);
+		if (length > _max_length.load(std::memory_order_relaxed)) {
+			_max_length.store(length, std::memory_order_relaxed);
+		}
+		return true;
+	}
+
+	/** Read the next notification if it is before `end` (reader only).
+	 *
+	 * The value is appended to `values`, which is only resized, so reading
+	 * does not allocate once it has grown large enough.
+	 */
+	bool read(FrameTime end, Notification& header, std::vector<uint8_t>& values) {
+		if (_ring.peek(sizeof(header), &header) != sizeof(header) ||
+		    header.time >= end ||
+		    _ring.read_space() < sizeof(header) + header.size) {
+			return false;  // Empty, later, or not completely written yet
+		}
+
+		const size_t offset = values.size();
+		values.resize(offset + header.size);
+		_ring.skip(sizeof(header));
+		_ring.read(header.size, values.data() + offset);
+		_n_read.store(_n_read.load(std::memory_order_relaxed) + 1,
+		              std::memory_order_relaxed);
+		return true;
+	}
+
+	/** Return true iff any notifications are waiting. */
+	bool pending() const { return _ring.read_space(); }
+
+	/** Return the number of notifications waiting. */
+	uint32_t length() const { return _n_written - _n_read; }
+
+	/** Return the maximum number of notifications that have been waiting. */
+	uint32_t max_length() const { return _max_length; }
+
+	/** Return the number of notifications dropped because the ring was full. */
+	uint64_t n_dropped() const { return _n_dropped; }
+
+private:
+	Raul::RingBuffer      _ring;
+	std::atomic<uint64_t> _n_written;
+	std::atomic<uint64_t> _n_read;
+	std::atomic<uint32_t> _max_length;
+	std::atomic<uint64_t> _n_dropped;
+};
+
+} // namespace server
+} // namespace ingen
+
+#endif // INGEN_ENGINE_NOTIFICATIONRING_HPP
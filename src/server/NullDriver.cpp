@@ -0,0 +1,207 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "ingen/Configuration.hpp"
+#include "ingen/Forge.hpp"
+#include "ingen/Log.hpp"
+#include "ingen/URIs.hpp"
+#include "ingen/World.hpp"
+
+#include "DuplexPort.hpp"
+#include "Engine.hpp"
+#include "NullDriver.hpp"
+#include "RunContext.hpp"
+#include "ThreadManager.hpp"
+#include "util.hpp"
+
+namespace ingen {
+namespace server {
+
+static uint64_t
+now_nanoseconds()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return uint64_t(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+/** Sleep until the monotonic clock reaches `time` in nanoseconds. */
+static void
+sleep_until(uint64_t time)
+{
+	struct timespec until;
+	until.tv_sec  = time / 1000000000;
+	until.tv_nsec = time % 1000000000;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) ==
+	       EINTR) {}
+}
+
+NullDriver::NullDriver(Engine& engine)
+	: _engine(engine)
+	, _xruns(0)
+	, _running(false)
+	, _seq_size(engine.world()->conf().option("queue-size").get<int32_t>())
+	, _block_length(engine.world()->conf().option("buffer-size").get<int32_t>())
+	, _sample_rate(engine.world()->conf().option("sample-rate").get<int32_t>())
+{
+}
+
+NullDriver::~NullDriver()
+{
+	deactivate();
+	_ports.clear_and_dispose([](EnginePort* p) { delete p; });
+}
+
+bool
+NullDriver::activate()
+{
+	if (_running) {
+		return true;
+	} else if (!_block_length || !_sample_rate) {
+		_engine.log().error("Null driver requires a block length and rate\n");
+		return false;
+	}
+
+	_running = true;
+	_thread  = std::thread(&NullDriver::run, this);
+
+	sched_param sp;
+	sp.sched_priority = real_time_priority();
+	const int st = pthread_setschedparam(_thread.native_handle(), SCHED_FIFO, &sp);
+	if (st) {
+		_engine.log().warn(
+			fmt("Failed to set real-time priority of null driver (%1%)\n")
+			% strerror(st));
+	}
+
+	_engine.log().info(fmt("Running %1% frame cycles at %2% Hz\n")
+	                   % _block_length % _sample_rate);
+	return true;
+}
+
+void
+NullDriver::deactivate()
+{
+	if (_running) {
+		_running = false;
+		_thread.join();
+	}
+}
+
+SampleCount
+NullDriver::frame_time() const
+{
+	return _engine.run_context().start();
+}
+
+EnginePort*
+NullDriver::create_port(DuplexPort* graph_port)
+{
+	return new EnginePort(graph_port);
+}
+
+EnginePort*
+NullDriver::get_port(const Raul::Path& path)
+{
+	for (auto& p : _ports) {
+		if (p.graph_port()->path() == path) {
+			return &p;
+		}
+	}
+
+	return nullptr;
+}
+
+void
+NullDriver::add_port(RunContext& context, EnginePort* port)
+{
+	_ports.push_back(*port);
+}
+
+void
+NullDriver::remove_port(RunContext& context, EnginePort* port)
+{
+	_ports.erase(_ports.iterator_to(*port));
+}
+
+Properties
+NullDriver::stats_properties() const
+{
+	const URIs&    uris     = _engine.world()->uris();
+	const uint64_t max_usec = std::numeric_limits<int32_t>::max();
+
+	Latency jitter;
+	{
+		std::lock_guard<std::mutex> lock(_stats_mutex);
+		jitter = _stats_jitter;
+	}
+
+	return {
+		{ uris.ingen_xruns,
+		  uris.forge.make(int32_t(_xruns.load())) },
+		{ uris.ingen_medianLatency,
+		  uris.forge.make(int32_t(std::min(jitter.percentile(50), max_usec))) },
+		{ uris.ingen_tailLatency,
+		  uris.forge.make(int32_t(std::min(jitter.percentile(99), max_usec))) },
+		{ uris.ingen_maxLatency,
+		  uris.forge.make(int32_t(std::min(jitter.max, max_usec))) } };
+}
+
+void
+NullDriver::run()
+{
+	ThreadManager::set_flag(THREAD_PROCESS);
+	ThreadManager::set_flag(THREAD_IS_REAL_TIME);
+
+	const uint64_t period = uint64_t(_block_length) * 1000000000 / _sample_rate;
+
+	uint64_t due = now_nanoseconds();
+	while (_running) {
+		sleep_until(due);
+
+		const uint64_t start = now_nanoseconds();
+		_jitter.update((std::max(start, due) - due) / 1000);
+
+		_engine.advance(_block_length);
+		_engine.run(_block_length);
+
+		/* If the cycle took longer than a period, skip the cycles that were
+		   missed and continue with the next that is still in the future. */
+		const uint64_t end    = now_nanoseconds();
+		const uint64_t missed = (std::max(end, due) - due) / period;
+		if (missed) {
+			++_xruns;
+		}
+		due += (missed + 1) * period;
+
+		// Publish statistics, unless they are being read right now
+		if (_stats_mutex.try_lock()) {
+			_stats_jitter = _jitter;
+			_stats_mutex.unlock();
+		}
+	}
+}
+
+} // namespace server
+} // namespace ingen
@@ -0,0 +1,110 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_NULLDRIVER_HPP
+#define INGEN_ENGINE_NULLDRIVER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include <boost/intrusive/slist.hpp>
+
+#include "Driver.hpp"
+#include "EnginePort.hpp"
+#include "Latency.hpp"
+
+namespace Raul { class Path; }
+
+namespace ingen {
+namespace server {
+
+class DuplexPort;
+class Engine;
+
+/** Driver that runs the engine in real time without an audio device.
+ *
+ * The engine is run in a real-time thread that sleeps until the start of each
+ * cycle, so sessions can be run with realistic timing on machines with no
+ * sound hardware.  Cycles that start late are recorded in a histogram, and
+ * cycles that do not finish before the next is due are counted as xruns.
+ * Ports have no external connections, so audio inputs are silent and outputs
+ * are discarded.
+ *
+ * \ingroup engine
+ */
+class NullDriver : public Driver
+{
+public:
+	explicit NullDriver(Engine& engine);
+	~NullDriver();
+
+	bool activate() override;
+	void deactivate() override;
+
+	bool dynamic_ports() const override { return true; }
+
+	EnginePort* create_port(DuplexPort* graph_port) override;
+	EnginePort* get_port(const Raul::Path& path) override;
+
+	void add_port(RunContext& context, EnginePort* port) override;
+	void remove_port(RunContext& context, EnginePort* port) override;
+	void rename_port(const Raul::Path& old_path,
+	                 const Raul::Path& new_path) override {}
+	void port_property(const Raul::Path& path,
+	                   const URI&        uri,
+	                   const Atom&       value) override {}
+	void register_port(EnginePort& port) override {}
+	void unregister_port(EnginePort& port) override {}
+
+	void append_time_events(RunContext& context, Buffer& buffer) override {}
+
+	SampleCount frame_time() const override;
+
+	int real_time_priority() override { return 80; }
+
+	SampleCount block_length() const override { return _block_length; }
+	size_t      seq_size()     const override { return _seq_size; }
+	SampleCount sample_rate()  const override { return _sample_rate; }
+
+	/** Return the xrun count and cycle start jitter as properties. */
+	Properties stats_properties() const override;
+
+private:
+	void run();
+
+	typedef boost::intrusive::slist<EnginePort,
+	                                boost::intrusive::cache_last<true>
+	                                > Ports;
+
+	Engine&               _engine;
+	Ports                 _ports;
+	std::thread           _thread;
+	mutable std::mutex    _stats_mutex;
+	Latency               _jitter;        ///< Cycle start lateness (run thread)
+	Latency               _stats_jitter;  ///< Last published copy of _jitter
+	std::atomic<uint32_t> _xruns;
+	std::atomic<bool>     _running;
+	size_t                _seq_size;
+	uint32_t              _block_length;
+	uint32_t              _sample_rate;
+};
+
+} // namespace server
+} // namespace ingen
+
+#endif // INGEN_ENGINE_NULLDRIVER_HPP
@@ -21,6 +21,7 @@
 #include "raul/Maid.hpp"
 
 #include "BlockImpl.hpp"
+#include "Broadcaster.hpp"
 #include "Buffer.hpp"
 #include "BufferFactory.hpp"
 #include "Engine.hpp"
@@ -67,6 +68,7 @@ PortImpl::PortImpl(BufferFactory&      bufs,
 	, _voices(bufs.maid().make_managed<Voices>(poly))
 	, _connected_flag(false)
 	, _monitored(false)
+	, _watched(false)
 	, _force_monitor_update(false)
 	, _is_morph(false)
 	, _is_auto_morph(false)
@@ -100,6 +102,8 @@ PortImpl::PortImpl(BufferFactory&      bufs,
 		}
 	}
 
+	_watched = bufs.engine().broadcaster()->is_watched(path());
+
 	get_buffers(bufs, &BufferFactory::get_buffer, _voices, poly, 0);
 }
 
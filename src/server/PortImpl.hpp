@@ -17,6 +17,7 @@
 #ifndef INGEN_ENGINE_PORTIMPL_HPP
 #define INGEN_ENGINE_PORTIMPL_HPP
 
+#include <atomic>
 #include <cstdlib>
 
 #include "ingen/Atom.hpp"
@@ -227,6 +228,14 @@ public:
 	/** Explicitly turn on monitoring for this port. */
 	void enable_monitoring(bool monitored) { _monitored = monitored; }
 
+	/** Return true iff a client has subscribed to this port or a parent. */
+	bool is_watched() const { return _watched.load(std::memory_order_relaxed); }
+
+	/** Set whether a client has subscribed to this port or a parent. */
+	void set_watched(bool watched) {
+		_watched.store(watched, std::memory_order_relaxed);
+	}
+
 	/** Monitor port value and broadcast to clients periodically. */
 	void monitor(RunContext& context, bool send_now=false);
 
@@ -279,31 +288,32 @@ protected:
 	                         uint32_t            poly,
 	                         size_t              num_in_arcs) const;
 
- 	BufferFactory&   _bufs;
-	uint32_t         _index;
-	uint32_t         _poly;
-	uint32_t         _buffer_size;
-	uint32_t         _frames_since_monitor;
-	float            _monitor_value;
-	float            _peak;
-	PortType         _type;
-	LV2_URID         _buffer_type;
-	Atom             _value;
-	Atom             _min;
-	Atom             _max;
-	MPtr<Voices>     _voices;
-	MPtr<Voices>     _prepared_voices;
-	BufferRef        _user_buffer;
-	std::atomic_flag _connected_flag;
-	bool             _monitored;
-	bool             _force_monitor_update;
-	bool             _is_morph;
-	bool             _is_auto_morph;
-	bool             _is_logarithmic;
-	bool             _is_sample_rate;
-	bool             _is_toggled;
-	bool             _is_driver_port;
-	bool             _is_output;
+	BufferFactory&    _bufs;
+	uint32_t          _index;
+	uint32_t          _poly;
+	uint32_t          _buffer_size;
+	uint32_t          _frames_since_monitor;
+	float             _monitor_value;
+	float             _peak;
+	PortType          _type;
+	LV2_URID          _buffer_type;
+	Atom              _value;
+	Atom              _min;
+	Atom              _max;
+	MPtr<Voices>      _voices;
+	MPtr<Voices>      _prepared_voices;
+	BufferRef         _user_buffer;
+	std::atomic_flag  _connected_flag;
+	bool              _monitored;
+	std::atomic<bool> _watched;
+	bool              _force_monitor_update;
+	bool              _is_morph;
+	bool              _is_auto_morph;
+	bool              _is_logarithmic;
+	bool              _is_sample_rate;
+	bool              _is_toggled;
+	bool              _is_driver_port;
+	bool              _is_output;
 };
 
 } // namespace server
@@ -15,11 +15,18 @@
 */
 
 #include <cassert>
+#include <cstdlib>
+#include <typeinfo>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
 
 #include "Engine.hpp"
 #include "Event.hpp"
 #include "PostProcessor.hpp"
 #include "RunContext.hpp"
+#include "Tracer.hpp"
 
 namespace ingen {
 namespace server {
@@ -39,6 +46,7 @@ PostProcessor::PostProcessor(Engine& engine)
 	, _tail(_head.load())
 	, _max_time(0)
 {
+	_total_latencies.name = "Event";
 }
 
 PostProcessor::~PostProcessor()
@@ -75,6 +83,7 @@ void
 PostProcessor::process()
 {
 	const FrameTime end_time = _max_time;
+	Tracer&         tracer   = *_engine.tracer();
 
 	/* We can never empty the list and set _head = _tail = null since this
 	   would cause a race with append.  Instead, head is an already
@@ -96,7 +105,15 @@ PostProcessor::process()
 		_engine.emit_notifications(ev->time());
 
 		// Post-process event
-		ev->post_process();
+		if (tracer.enabled()) {
+			const uint64_t start = _engine.current_time();
+			ev->post_process();
+			tracer.record(_engine.n_threads(), Tracer::Type::POST_PROCESS,
+			              start, _engine.current_time(), typeid(*ev).name());
+		} else {
+			ev->post_process();
+		}
+		update_latencies(*ev);
 		next = ev->next();  // [1] (see below)
 	} while (next && next->time() < end_time);
 
@@ -110,5 +127,47 @@ PostProcessor::process()
 	_engine.emit_notifications(end_time);
 }
 
+/** Return the unqualified class name of an event. */
+static std::string
+event_name(const Event& ev)
+{
+	std::string name = typeid(ev).name();
+#ifdef __GNUC__
+	int   status    = 0;
+	char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+	if (demangled) {
+		name = demangled;
+		free(demangled);
+	}
+#endif
+	const size_t last_sep = name.rfind("::");
+	return last_sep == std::string::npos ? name : name.substr(last_sep + 2);
+}
+
+void
+PostProcessor::update_latencies(const Event& ev)
+{
+	const uint64_t enqueued = ev.stage_time(Event::Stage::ENQUEUED);
+	const uint64_t prepared = ev.stage_time(Event::Stage::PREPARED);
+	const uint64_t executed = ev.stage_time(Event::Stage::EXECUTED);
+	if (!enqueued || !prepared || !executed) {
+		return;  // Internal event that never went through the queue
+	}
+
+	const uint64_t now = _engine.current_time();
+
+	auto l = _latencies.find(typeid(ev));
+	if (l == _latencies.end()) {
+		l = _latencies.emplace(typeid(ev), EventLatencies()).first;
+		l->second.name = event_name(ev);
+	}
+
+	for (EventLatencies* latencies : { &l->second, &_total_latencies }) {
+		latencies->prepared.update(prepared - enqueued);
+		latencies->executed.update(executed - enqueued);
+		latencies->post_processed.update(now - enqueued);
+	}
+}
+
 } // namespace server
 } // namespace ingen
@@ -18,9 +18,13 @@
 #define INGEN_ENGINE_POSTPROCESSOR_HPP
 
 #include <atomic>
+#include <map>
+#include <string>
+#include <typeindex>
 
 #include "ingen/ingen.h"
 
+#include "Latency.hpp"
 #include "types.hpp"
 
 namespace ingen {
@@ -61,11 +65,31 @@ public:
 	/** Set the latest event time that should be post-processed */
 	void set_end_time(FrameTime time) { _max_time = time; }
 
+	/** Latencies of events since they were enqueued. */
+	struct EventLatencies {
+		std::string name;            ///< Event class name, like "Delta"
+		Latency     prepared;        ///< Until pre-processed
+		Latency     executed;        ///< Until executed in the audio thread
+		Latency     post_processed;  ///< Until post-processed and replied to
+	};
+
+	typedef std::map<std::type_index, EventLatencies> Latencies;
+
+	/** Return latencies by event type (post-processing thread only). */
+	const Latencies& latencies() const { return _latencies; }
+
+	/** Return latencies of all events (post-processing thread only). */
+	const EventLatencies& total_latencies() const { return _total_latencies; }
+
 private:
+	void update_latencies(const Event& ev);
+
 	Engine&                _engine;
 	std::atomic<Event*>    _head;
 	std::atomic<Event*>    _tail;
 	std::atomic<FrameTime> _max_time;
+	Latencies              _latencies;
+	EventLatencies         _total_latencies;
 };
 
 } // namespace server
@@ -14,7 +14,11 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <stdexcept>
+#include <typeinfo>
 
 #include "ingen/AtomSink.hpp"
 #include "ingen/AtomWriter.hpp"
@@ -28,20 +32,30 @@
 #include "PreProcessor.hpp"
 #include "RunContext.hpp"
 #include "ThreadManager.hpp"
+#include "Tracer.hpp"
 #include "UndoStack.hpp"
 
 namespace ingen {
 namespace server {
 
+/** Maximum number of events held for a future time. */
+static const size_t schedule_size = 4096;
+
 PreProcessor::PreProcessor(Engine& engine)
 	: _engine(engine)
 	, _sem(0)
 	, _head(nullptr)
 	, _tail(nullptr)
 	, _block_state(BlockState::UNBLOCKED)
+	, _n_ordered(0)
+	, _n_scheduled(0)
+	, _next_scheduled(std::numeric_limits<FrameTime>::max())
+	, _waiting(false)
 	, _exit_flag(false)
 	, _thread(&PreProcessor::run, this)
-{}
+{
+	_schedule.reserve(schedule_size);
+}
 
 PreProcessor::~PreProcessor()
 {
@@ -50,6 +64,10 @@ PreProcessor::~PreProcessor()
 		_sem.post();
 		_thread.join();
 	}
+
+	for (const auto& s : _schedule) {
+		delete s.event;
+	}
 }
 
 void
@@ -62,6 +80,7 @@ PreProcessor::event(Event* const ev, Event::Mode mode)
 	assert(!ev->is_prepared());
 	assert(!ev->next());
 	ev->set_mode(mode);
+	ev->set_stage_time(Event::Stage::ENQUEUED, _engine.current_time());
 
 	/* Note that tail is only used here, not in process().  The head must be
 	   checked first here, since if it is null the tail pointer is junk. */
@@ -77,14 +96,137 @@ PreProcessor::event(Event* const ev, Event::Mode mode)
 	_sem.post();
 }
 
+bool
+PreProcessor::schedule(Event* const ev)
+{
+	/* The preprocessor has moved past an event once the next is prepared, so
+	   it is safe to take out of the queue.  The tail is never taken, since
+	   event() may be appending to it. */
+	const Event* const next = ev->next();
+	if (!ev->is_schedulable() || !next || !next->is_prepared() ||
+	    _schedule.size() == schedule_size) {
+		return false;
+	}
+
+	_schedule.push_back({ev->time(), _n_ordered++, ev, ev->subject()});
+	std::push_heap(_schedule.begin(), _schedule.end(),
+	               std::greater<Scheduled>());
+	update_schedule_state();
+	return true;
+}
+
+/** Return true iff `a` and `b` are the same object, or one contains the other.
+ *
+ * This is called in the audio thread, so unlike Raul::Path::is_child_of(), it
+ * does not allocate.
+ */
+static bool
+is_related(const Raul::Path& a, const Raul::Path& b)
+{
+	const Raul::Path& shorter = a.length() < b.length() ? a : b;
+	const Raul::Path& longer  = a.length() < b.length() ? b : a;
+	if (longer.compare(0, shorter.length(), shorter)) {
+		return false;  // Shorter is not a prefix of longer
+	}
+
+	return (shorter.length() == longer.length() || shorter.is_root() ||
+	        longer[shorter.length()] == '/');
+}
+
+/** Return true iff `ev` must wait for the scheduled events to be executed. */
+bool
+PreProcessor::is_held(const Event& ev) const
+{
+	if (_schedule.empty() || ev.is_schedulable() || ev.is_read_only()) {
+		return false;
+	}
+
+	const Node* const subject = ev.subject();
+	if (!subject) {
+		return true;  // May change anything
+	}
+
+	for (const Scheduled& s : _schedule) {
+		if (!s.subject || is_related(s.subject->path(), subject->path())) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+PreProcessor::update_schedule_state()
+{
+	_n_scheduled    = _schedule.size();
+	_next_scheduled = (_schedule.empty()
+	                   ? std::numeric_limits<FrameTime>::max()
+	                   : _schedule.front().time);
+}
+
+Event*
+PreProcessor::pop_scheduled(const RunContext& context, FrameTime end)
+{
+	if (_schedule.empty() || _schedule.front().time >= end) {
+		return nullptr;
+	}
+
+	Event* const ev = _schedule.front().event;
+	std::pop_heap(_schedule.begin(), _schedule.end(),
+	              std::greater<Scheduled>());
+	_schedule.pop_back();
+	update_schedule_state();
+
+	if (ev->time() < context.start()) {
+		ev->set_time(context.start());  // Missed cycle, nudge to context start
+	}
+
+	return ev;
+}
+
 unsigned
 PreProcessor::process(RunContext& context, PostProcessor& dest, size_t limit)
 {
+	Engine&      engine      = context.engine();
+	Tracer&      tracer      = *engine.tracer();
 	Event* const head        = _head.load();
 	size_t       n_processed = 0;
 	Event*       ev          = head;
-	Event*       last        = ev;
+	Event*       first       = nullptr;
+	Event*       last        = nullptr;
+
+	// Execute an event and append it to the list for post-processing
+	auto execute = [&](Event* const e) {
+		const uint64_t start = tracer.enabled() ? engine.current_time() : 0;
+		e->execute(context);
+		e->set_stage_time(Event::Stage::EXECUTED, engine.current_time());
+		if (tracer.enabled()) {
+			tracer.record(context.id(), Tracer::Type::EXECUTE,
+			              start, e->stage_time(Event::Stage::EXECUTED),
+			              typeid(*e).name());
+		}
+		++n_processed;
+
+		if (last) {
+			last->next(e);
+		} else {
+			first = e;
+		}
+		last = e;
+	};
+
+	bool waiting = false;
 	while (ev && ev->is_prepared()) {
+		if (is_held(*ev)) {
+			// Execute the scheduled events for this cycle, which may release it
+			while (Event* const s = pop_scheduled(context, context.end())) {
+				execute(s);
+			}
+			if ((waiting = is_held(*ev))) {
+				break;  // Wait until related scheduled events have been executed
+			}
+		}
+
 		switch (_block_state.load()) {
 		case BlockState::UNBLOCKED:
 			break;
@@ -113,14 +255,23 @@ PreProcessor::process(RunContext& context, PostProcessor& dest, size_t limit)
 			break;  // Waiting for PRE_UNBLOCKED
 		} else if (ev->time() < context.start()) {
 			ev->set_time(context.start());  // Too late, nudge to context start
+		} else if (_block_state != BlockState::PROCESSING &&
+		           ev->time() > context.start() && schedule(ev)) {
+			ev = ev->next();  // Held until its time, move on to the next
+			continue;
 		} else if (_block_state != BlockState::PROCESSING &&
 		           ev->time() >= context.end()) {
 			break;  // Event is for a future cycle
 		}
 
-		// Execute event
-		ev->execute(context);
-		++n_processed;
+		// Execute any scheduled events that come first, then this event
+		const FrameTime until = std::min(ev->time() + 1, context.end());
+		while (Event* const s = pop_scheduled(context, until)) {
+			execute(s);
+		}
+
+		Event* const next = ev->next();
+		execute(ev);
 
 		// Unblock pre-processing if this is a non-bundled atomic event
 		if (ev->get_execution() == Event::Execution::ATOMIC) {
@@ -129,8 +280,7 @@ PreProcessor::process(RunContext& context, PostProcessor& dest, size_t limit)
 		}
 
 		// Move to next event
-		last = ev;
-		ev   = ev->next();
+		ev = next;
 
 		if (_block_state != BlockState::PROCESSING &&
 		    limit && n_processed >= limit) {
@@ -138,9 +288,14 @@ PreProcessor::process(RunContext& context, PostProcessor& dest, size_t limit)
 		}
 	}
 
+	// Execute the remaining scheduled events for this cycle
+	while (Event* const s = pop_scheduled(context, context.end())) {
+		execute(s);
+	}
+	_waiting = waiting && is_held(*ev);
+
 	if (n_processed > 0) {
 #ifndef NDEBUG
-		Engine& engine = context.engine();
 		if (engine.world()->conf().option("trace").get<int32_t>()) {
 			const uint64_t start = engine.cycle_start_time(context);
 			const uint64_t end   = engine.current_time();
@@ -149,16 +304,17 @@ PreProcessor::process(RunContext& context, PostProcessor& dest, size_t limit)
 		}
 #endif
 
-		Event* next = (Event*)last->next();
 		last->next(nullptr);
-		dest.append(context, head, last);
+		dest.append(context, first, last);
+	}
 
+	if (ev != head) {
 		// Since _head was not null, we know it hasn't been changed since
-		_head = next;
+		_head = ev;
 
-		/* If next is null, then _tail may now be invalid.  However, it would cause
-		   a race to reset _tail here.  Instead, append() checks only _head for
-		   emptiness, and resets the tail appropriately. */
+		/* If ev is null, then _tail may now be invalid.  However, it would
+		   cause a race to reset _tail here.  Instead, append() checks only
+		   _head for emptiness, and resets the tail appropriately. */
 	}
 
 	return n_processed;
@@ -184,8 +340,9 @@ PreProcessor::run()
 			continue;
 		}
 
-		if (!back) {
-			// Ran off end, find new unprepared back
+		if (!back || back->is_prepared()) {
+			/* Ran off end, or process() linked the last event to one it
+			   executed from the schedule, find new unprepared back */
 			back = _head;
 			while (back && back->is_prepared()) {
 				back = back->next();
@@ -233,6 +390,7 @@ PreProcessor::run()
 				break;
 			}
 		}
+		ev->set_stage_time(Event::Stage::PREPARED, _engine.current_time());
 		assert(ev->is_prepared());
 
 		// Wait for process() if necessary
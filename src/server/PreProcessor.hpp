@@ -18,12 +18,19 @@
 #define INGEN_ENGINE_PREPROCESSOR_HPP
 
 #include <atomic>
+#include <cstdint>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 #include "raul/Semaphore.hpp"
 
+#include "types.hpp"
+
 namespace ingen {
+
+class Node;
+
 namespace server {
 
 class Engine;
@@ -38,8 +45,17 @@ public:
 
 	~PreProcessor();
 
-	/** Return true iff no events are enqueued. */
-	inline bool empty() const { return !_head.load(); }
+	/** Return true iff no events are enqueued or scheduled. */
+	inline bool empty() const { return !_head.load() && !_n_scheduled.load(); }
+
+	/** Return true iff no events are enqueued, ignoring scheduled events. */
+	inline bool queue_empty() const { return !_head.load(); }
+
+	/** Return the time of the next scheduled event, or the maximum time. */
+	inline FrameTime next_scheduled() const { return _next_scheduled.load(); }
+
+	/** Return true iff the next event is waiting for scheduled events. */
+	inline bool waiting() const { return _waiting.load(); }
 
 	/** Enqueue an event.
 	 * This is safe to call from any non-realtime thread (it locks).
@@ -47,6 +63,13 @@ public:
 	void event(Event* ev, Event::Mode mode);
 
 	/** Process events for a cycle.
+	 *
+	 * Events are executed in order, except that port value changes for a
+	 * future time are held in a time-ordered schedule so they do not hold up
+	 * the events behind them, and executed in order of time in their cycle.
+	 * Other events wait until the scheduled events for related objects have
+	 * been executed, except for events that change nothing.
+	 *
 	 * @return The number of events processed.
 	 */
 	unsigned process(RunContext&    context,
@@ -71,12 +94,37 @@ private:
 		}
 	}
 
+	/** An event held until its time, ordered by time then arrival. */
+	struct Scheduled {
+		bool operator>(const Scheduled& rhs) const {
+			return time > rhs.time || (time == rhs.time && order > rhs.order);
+		}
+
+		FrameTime   time;
+		uint64_t    order;
+		Event*      event;
+		const Node* subject;
+	};
+
+	bool schedule(Event* ev);
+
+	bool is_held(const Event& ev) const;
+
+	void update_schedule_state();
+
+	Event* pop_scheduled(const RunContext& context, FrameTime end);
+
 	Engine&                 _engine;
 	std::mutex              _mutex;
 	Raul::Semaphore         _sem;
 	std::atomic<Event*>     _head;
 	std::atomic<Event*>     _tail;
 	std::atomic<BlockState> _block_state;
+	std::vector<Scheduled>  _schedule;        ///< Heap of held events
+	uint64_t                _n_ordered;       ///< Number ever scheduled
+	std::atomic<size_t>     _n_scheduled;     ///< Size of _schedule
+	std::atomic<FrameTime>  _next_scheduled;  ///< Time of first in _schedule
+	std::atomic<bool>       _waiting;         ///< Head is held by _schedule
 	bool                    _exit_flag;
 	std::thread             _thread;
 };
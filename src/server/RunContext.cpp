@@ -14,6 +14,13 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include "ingen_config.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <utility>
+
 #include "ingen/Forge.hpp"
 #include "ingen/Log.hpp"
 #include "ingen/URIMap.hpp"
@@ -28,25 +35,10 @@
 namespace ingen {
 namespace server {
 
-struct Notification
-{
-	inline Notification(PortImpl* p = nullptr,
-	                    FrameTime f = 0,
-	                    LV2_URID  k = 0,
-	                    uint32_t  s = 0,
-	                    LV2_URID  t = 0)
-		: port(p), time(f), key(k), size(s), type(t)
-	{}
-
-	PortImpl* port;
-	FrameTime time;
-	LV2_URID  key;
-	uint32_t  size;
-	LV2_URID  type;
-};
+INGEN_THREAD_LOCAL int RunContext::_current_id(-1);
 
 RunContext::RunContext(Engine&           engine,
-                       Raul::RingBuffer* event_sink,
+                       NotificationRing* event_sink,
                        unsigned          id,
                        bool              threaded)
 	: _engine(engine)
@@ -77,7 +69,9 @@ RunContext::RunContext(const RunContext& copy)
 bool
 RunContext::must_notify(const PortImpl* port) const
 {
-	return (port->is_monitored() || _engine.broadcaster()->must_broadcast());
+	return (port->is_monitored() ||
+	        port->is_watched() ||
+	        _engine.broadcaster()->must_broadcast());
 }
 
 bool
@@ -88,56 +82,8 @@ RunContext::notify(LV2_URID    key,
                    LV2_URID    type,
                    const void* body)
 {
-	const Notification n(port, time, key, size, type);
-	if (_event_sink->write_space() < sizeof(n) + size) {
-		return false;
-	}
-	if (_event_sink->write(sizeof(n), &n) != sizeof(n)) {
-		_engine.log().rt_error("Error writing header to notification ring\n");
-	} else if (_event_sink->write(size, body) != size) {
-		_engine.log().rt_error("Error writing body to notification ring\n");
-	} else {
-		return true;
-	}
-	return false;
-}
-
-void
-RunContext::emit_notifications(FrameTime end)
-{
-	const URIs&    uris       = _engine.buffer_factory()->uris();
-	const uint32_t read_space = _event_sink->read_space();
-	Notification   note;
-	for (uint32_t i = 0; i < read_space; i += sizeof(note)) {
-		if (_event_sink->peek(sizeof(note), &note) != sizeof(note) ||
-		    note.time >= end) {
-			return;
-		}
-		if (_event_sink->read(sizeof(note), &note) == sizeof(note)) {
-			Atom value = _engine.world()->forge().alloc(
-				note.size, note.type, nullptr);
-			if (_event_sink->read(note.size, value.get_body()) == note.size) {
-				i += note.size;
-				const char* key = _engine.world()->uri_map().unmap_uri(note.key);
-				if (key) {
-					_engine.broadcaster()->set_property(
-						note.port->uri(), URI(key), value);
-					if (note.port->is_input() &&
-					    (note.key == uris.ingen_value ||
-					     note.key == uris.midi_binding)) {
-						// FIXME: not thread safe
-						note.port->set_property(URI(key), value);
-					}
-				} else {
-					_engine.log().rt_error("Error unmapping notification key URI\n");
-				}
-			} else {
-				_engine.log().rt_error("Error reading body from notification ring\n");
-			}
-		} else {
-			_engine.log().rt_error("Error reading header from notification ring\n");
-		}
-	}
+	const Notification n = { port, time, key, size, type };
+	return _event_sink->write(n, body);
 }
 
 void
@@ -170,6 +116,24 @@ RunContext::set_priority(int priority)
 	}
 }
 
+void
+RunContext::set_cpu(unsigned cpu)
+{
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+	if (_thread) {
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		if (pthread_setaffinity_np(_thread->native_handle(), sizeof(cpus), &cpus)) {
+			_engine.log().error(
+				fmt("Failed to pin run thread to CPU %1%\n") % cpu);
+		}
+	}
+#else
+	_engine.log().warn("Pinning threads to CPUs is not supported\n");
+#endif
+}
+
 void
 RunContext::join()
 {
@@ -184,6 +148,7 @@ RunContext::join()
 void
 RunContext::run()
 {
+	set_current();
 	while (_engine.wait_for_tasks()) {
 		for (Task* t; (t = _engine.steal_task(0));) {
 			t->run(*this);
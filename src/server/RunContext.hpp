@@ -21,9 +21,10 @@
 #include <thread>
 
 #include "lv2/urid/urid.h"
-#include "raul/RingBuffer.hpp"
 
+#include "NotificationRing.hpp"
 #include "types.hpp"
+#include "util.hpp"
 
 namespace ingen {
 namespace server {
@@ -56,7 +57,7 @@ public:
 	 * a thread and execute tasks as they become available.
 	 */
 	RunContext(Engine&           engine,
-	           Raul::RingBuffer* event_sink,
+	           NotificationRing* event_sink,
 	           unsigned          id,
 	           bool              threaded);
 
@@ -85,11 +86,8 @@ public:
 	            LV2_URID    type = 0,
 	            const void* body = nullptr);
 
-	/** Emit pending notifications in some other non-realtime thread. */
-	void emit_notifications(FrameTime end);
-
-	/** Return true iff any notifications are pending. */
-	bool pending_notifications() const { return _event_sink->read_space(); }
+	/** Return the ring notifications from this context are written to. */
+	NotificationRing& notifications() const { return *_event_sink; }
 
 	/** Return the duration of this cycle in microseconds.
 	 *
@@ -121,10 +119,19 @@ public:
 	Task* steal_task() const;
 
 	void set_priority(int priority);
+
+	/** Run this context's thread only on the given CPU, if supported. */
+	void set_cpu(unsigned cpu);
 	void set_rate(SampleCount rate) { _rate = rate; }
 
     void join();
 
+	/** Make this the context of the calling thread (see current_id()). */
+	void set_current() const { _current_id = int(_id); }
+
+	/** Return the ID of the context run by the calling thread, or -1. */
+	static int current_id() { return _current_id; }
+
 	inline Engine&     engine()   const { return _engine; }
 	inline Task*       task()     const { return _task; }
 	inline unsigned    id()       const { return _id; }
@@ -142,7 +149,7 @@ protected:
 	void run();
 
 	Engine&           _engine;      ///< Engine we're running in
-	Raul::RingBuffer* _event_sink;  ///< Port updates from process context
+	NotificationRing* _event_sink;  ///< Port updates from process context
 	Task*             _task;        ///< Currently executing task
 	std::thread*      _thread;      ///< Thread (null for main run context)
 	unsigned          _id;          ///< Context ID
@@ -153,6 +160,8 @@ protected:
 	SampleCount _nframes;    ///< Number of frames past offset to process
 	SampleCount _rate;       ///< Sample rate in Hz
 	bool        _realtime;   ///< True iff context is hard realtime
+
+	static INGEN_THREAD_LOCAL int _current_id;  ///< Context of this thread
 };
 
 } // namespace server
@@ -0,0 +1,71 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_SERVER_SHM_SERVER_HPP
+#define INGEN_SERVER_SHM_SERVER_HPP
+
+#include "ingen/ShmReader.hpp"
+#include "ingen/ShmSegment.hpp"
+#include "ingen/ShmWriter.hpp"
+#include "ingen/World.hpp"
+
+#include "ClientQueue.hpp"
+#include "EventWriter.hpp"
+
+namespace ingen {
+namespace server {
+
+/** The server side of a shared memory connection.
+ *
+ * This takes over an existing client: messages to the client are written to
+ * the segment instead of its original sink, and messages from the client are
+ * read from the segment by a thread.  The original connection stays open, and
+ * this is destroyed when it closes.
+ */
+class ShmServer
+{
+public:
+	ShmServer(World&            world,
+	          server::Engine&   engine,
+	          SPtr<ClientQueue> client,
+	          SPtr<ShmSegment>  segment)
+		: _segment(segment)
+		, _sink(new EventWriter(engine))
+		, _reader(world, *_sink.get(), segment, segment->to_engine())
+	{
+		_sink->set_respondee(client);
+		client->set_sink(SPtr<Interface>(new ShmWriter(world.uri_map(),
+		                                               world.uris(),
+		                                               world.log(),
+		                                               client->uri(),
+		                                               segment,
+		                                               segment->to_client())));
+	}
+
+	~ShmServer() {
+		_segment->close();
+	}
+
+private:
+	SPtr<ShmSegment> _segment;
+	SPtr<Interface>  _sink;
+	ShmReader        _reader;
+};
+
+}  // namespace server
+}  // namespace ingen
+
+#endif  // INGEN_SERVER_SHM_SERVER_HPP
@@ -34,7 +34,7 @@
 #include "../server/EventWriter.hpp"
 
 #include "SocketListener.hpp"
-#include "SocketServer.hpp"
+#include "SocketReactor.hpp"
 
 namespace ingen {
 namespace server {
@@ -61,26 +61,36 @@ get_link_target(const char* link_path)
 	return std::string();
 }
 
-static void ingen_listen(Engine*       engine,
-                         Raul::Socket* unix_sock,
-                         Raul::Socket* net_sock);
+static void ingen_listen(Engine*        engine,
+                         SocketReactor* reactor,
+                         Raul::Socket*  unix_sock,
+                         Raul::Socket*  net_sock);
 
 
 SocketListener::SocketListener(Engine& engine)
 	: unix_sock(Raul::Socket::Type::UNIX)
 	, net_sock(Raul::Socket::Type::TCP)
-	, thread(new std::thread(ingen_listen, &engine, &unix_sock, &net_sock))
+	, reactor(new SocketReactor(
+		          *engine.world(),
+		          engine,
+		          engine.world()->conf().option("io-threads").get<int32_t>()))
+	, thread(new std::thread(
+		         ingen_listen, &engine, reactor.get(), &unix_sock, &net_sock))
 {}
 
 SocketListener::~SocketListener() {
 	unix_sock.shutdown();
 	net_sock.shutdown();
 	thread->join();
+	reactor.reset();
 	unlink(unix_sock.uri().substr(strlen(unix_scheme)).c_str());
 }
 
 static void
-ingen_listen(Engine* engine, Raul::Socket* unix_sock, Raul::Socket* net_sock)
+ingen_listen(Engine*        engine,
+             SocketReactor* reactor,
+             Raul::Socket*  unix_sock,
+             Raul::Socket*  net_sock)
 {
 	ingen::World* world = engine->world();
 
@@ -169,14 +179,14 @@ ingen_listen(Engine* engine, Raul::Socket* unix_sock, Raul::Socket* net_sock)
 		if (pfds[0].revents & POLLIN) {
 			SPtr<Raul::Socket> conn = unix_sock->accept();
 			if (conn) {
-				new SocketServer(*world, *engine, conn);
+				reactor->add(conn);
 			}
 		}
 
 		if (pfds[1].revents & POLLIN) {
 			SPtr<Raul::Socket> conn = net_sock->accept();
 			if (conn) {
-				new SocketServer(*world, *engine, conn);
+				reactor->add(conn);
 			}
 		}
 	}
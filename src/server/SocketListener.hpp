@@ -23,8 +23,9 @@ namespace ingen {
 namespace server {
 
 class Engine;
+class SocketReactor;
 
-/** Listens on main sockets and spawns socket servers for new connections. */
+/** Listens on main sockets and passes new connections to a SocketReactor. */
 class SocketListener
 {
 public:
@@ -32,9 +33,10 @@ public:
 	~SocketListener();
 
 private:
-	Raul::Socket                 unix_sock;
-	Raul::Socket                 net_sock;
-	std::unique_ptr<std::thread> thread;
+	Raul::Socket                   unix_sock;
+	Raul::Socket                   net_sock;
+	std::unique_ptr<SocketReactor> reactor;
+	std::unique_ptr<std::thread>   thread;
 };
 
 } // namespace server
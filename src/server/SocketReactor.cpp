@@ -0,0 +1,255 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ingen_config.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef HAVE_EPOLL
+#    include <sys/epoll.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "ingen/Configuration.hpp"
+#include "ingen/Log.hpp"
+#include "ingen/World.hpp"
+#include "raul/Socket.hpp"
+
+#include "Engine.hpp"
+#include "SocketReactor.hpp"
+#include "SocketServer.hpp"
+
+namespace ingen {
+namespace server {
+
+/** An I/O thread and the connections it serves. */
+struct SocketReactor::IOThread
+{
+	typedef std::map<int, UPtr<SocketServer>> Connections;
+
+	IOThread() : poll_fd(-1), wake_fds{-1, -1} {}
+
+	int         poll_fd;      ///< Epoll instance, or -1
+	int         wake_fds[2];  ///< Pipe to interrupt wait()
+	std::mutex  mutex;        ///< Protects connections
+	Connections connections;  ///< Connections by file descriptor
+	std::thread thread;
+};
+
+SocketReactor::SocketReactor(World& world, Engine& engine, unsigned n_threads)
+	: _world(world)
+	, _engine(engine)
+	, _next_thread(0)
+	, _exit_flag(false)
+{
+	for (unsigned i = 0; i < std::max(n_threads, 1u); ++i) {
+		UPtr<IOThread> io(new IOThread());
+		if (pipe(io->wake_fds)) {
+			_world.log().error(fmt("Failed to create pipe (%1%)\n")
+			                   % strerror(errno));
+			break;
+		}
+		fcntl(io->wake_fds[0], F_SETFL, O_NONBLOCK);
+
+#ifdef HAVE_EPOLL
+		io->poll_fd = epoll_create1(EPOLL_CLOEXEC);
+		if (io->poll_fd == -1) {
+			_world.log().error(fmt("Failed to create epoll instance (%1%)\n")
+			                   % strerror(errno));
+			close(io->wake_fds[0]);
+			close(io->wake_fds[1]);
+			break;
+		}
+
+		struct epoll_event ev;
+		ev.events  = EPOLLIN;
+		ev.data.fd = io->wake_fds[0];
+		epoll_ctl(io->poll_fd, EPOLL_CTL_ADD, io->wake_fds[0], &ev);
+#endif
+
+		IOThread& ref = *io;
+		_threads.push_back(std::move(io));
+		ref.thread = std::thread(&SocketReactor::run, this, std::ref(ref));
+	}
+}
+
+SocketReactor::~SocketReactor()
+{
+	_exit_flag = true;
+	for (auto& io : _threads) {
+		wake(*io);
+		io->thread.join();
+		io->connections.clear();
+		if (io->poll_fd != -1) {
+			close(io->poll_fd);
+		}
+		close(io->wake_fds[0]);
+		close(io->wake_fds[1]);
+	}
+}
+
+void
+SocketReactor::add(SPtr<Raul::Socket> sock)
+{
+	if (_threads.empty()) {
+		// No I/O threads, fall back to a thread for this connection
+		new SocketServer(_world, _engine, sock);
+		return;
+	}
+
+	IOThread& io = *_threads[_next_thread++ % _threads.size()];
+	const int fd = sock->fd();
+	{
+		std::lock_guard<std::mutex> lock(io.mutex);
+		io.connections[fd] = UPtr<SocketServer>(
+			new SocketServer(_world, _engine, sock, false));
+	}
+
+#ifdef HAVE_EPOLL
+	struct epoll_event ev;
+	ev.events  = EPOLLIN | EPOLLRDHUP;
+	ev.data.fd = fd;
+	if (epoll_ctl(io.poll_fd, EPOLL_CTL_ADD, fd, &ev)) {
+		_world.log().error(fmt("Failed to watch connection (%1%)\n")
+		                   % strerror(errno));
+		std::lock_guard<std::mutex> lock(io.mutex);
+		io.connections.erase(fd);
+	}
+#else
+	wake(io);  // Wake thread to poll the new connection
+#endif
+}
+
+void
+SocketReactor::wake(IOThread& io)
+{
+	const char c = 0;
+	if (write(io.wake_fds[1], &c, 1) != 1) {
+		_world.log().error("Failed to wake I/O thread\n");
+	}
+}
+
+/** Wait for input, and append the descriptors that are ready to `ready`.
+ *
+ * Descriptors with an error or hangup are also considered ready, since
+ * reading from them will detect the closed connection.
+ *
+ * @return False on error.
+ */
+bool
+SocketReactor::wait(IOThread& io, std::vector<int>& ready)
+{
+#ifdef HAVE_EPOLL
+	static const int max_events = 64;
+
+	struct epoll_event events[max_events];
+	const int n = epoll_wait(io.poll_fd, events, max_events, -1);
+	if (n == -1) {
+		return errno == EINTR;
+	}
+
+	for (int i = 0; i < n; ++i) {
+		ready.push_back(events[i].data.fd);
+	}
+#else
+	std::vector<struct pollfd> pfds;
+	pfds.push_back({ io.wake_fds[0], POLLIN, 0 });
+	{
+		std::lock_guard<std::mutex> lock(io.mutex);
+		for (const auto& c : io.connections) {
+			pfds.push_back({ c.first, POLLIN, 0 });
+		}
+	}
+
+	if (poll(pfds.data(), pfds.size(), -1) == -1) {
+		return errno == EINTR;
+	}
+
+	for (const auto& p : pfds) {
+		if (p.revents) {
+			ready.push_back(p.fd);
+		}
+	}
+#endif
+
+	return true;
+}
+
+void
+SocketReactor::remove(IOThread& io, int fd)
+{
+#ifdef HAVE_EPOLL
+	epoll_ctl(io.poll_fd, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+
+	UPtr<SocketServer> server;
+	{
+		std::lock_guard<std::mutex> lock(io.mutex);
+		auto c = io.connections.find(fd);
+		if (c != io.connections.end()) {
+			server = std::move(c->second);
+			io.connections.erase(c);
+		}
+	}
+
+	// Server is destroyed here, outside the lock, which unregisters the client
+}
+
+void
+SocketReactor::run(IOThread& io)
+{
+	std::vector<int> ready;
+	while (!_exit_flag) {
+		ready.clear();
+		if (!wait(io, ready)) {
+			_world.log().error(fmt("I/O thread error (%1%)\n")
+			                   % strerror(errno));
+			break;
+		}
+
+		for (const int fd : ready) {
+			if (fd == io.wake_fds[0]) {
+				char buf[64];
+				while (read(fd, buf, sizeof(buf)) > 0) {}
+				continue;
+			}
+
+			// Only this thread removes connections, so server stays valid
+			SocketServer* server = nullptr;
+			{
+				std::lock_guard<std::mutex> lock(io.mutex);
+				auto c = io.connections.find(fd);
+				if (c != io.connections.end()) {
+					server = c->second.get();
+				}
+			}
+
+			if (server && !server->read()) {
+				remove(io, fd);
+			}
+		}
+	}
+}
+
+} // namespace server
+} // namespace ingen
@@ -0,0 +1,72 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_SOCKETREACTOR_HPP
+#define INGEN_ENGINE_SOCKETREACTOR_HPP
+
+#include <atomic>
+#include <vector>
+
+#include "ingen/types.hpp"
+
+namespace Raul { class Socket; }
+
+namespace ingen {
+
+class World;
+
+namespace server {
+
+class Engine;
+
+/** Serves socket connections with a small fixed pool of I/O threads.
+ *
+ * Rather than running a thread for every connection, each I/O thread waits
+ * for input on all of its connections at once (using epoll where available),
+ * and reads messages from whichever are ready.  Parser state is kept per
+ * connection, so a single thread can serve any number of clients, and only as
+ * many threads as there are in the pool contend for the RDF world.
+ *
+ * \ingroup engine
+ */
+class SocketReactor
+{
+public:
+	SocketReactor(World& world, Engine& engine, unsigned n_threads);
+	~SocketReactor();
+
+	/** Serve a new connection, which is owned by the reactor until closed. */
+	void add(SPtr<Raul::Socket> sock);
+
+private:
+	struct IOThread;
+
+	void run(IOThread& io);
+	bool wait(IOThread& io, std::vector<int>& ready);
+	void remove(IOThread& io, int fd);
+	void wake(IOThread& io);
+
+	World&                      _world;
+	Engine&                     _engine;
+	std::vector<UPtr<IOThread>> _threads;
+	std::atomic<unsigned>       _next_thread;
+	std::atomic<bool>           _exit_flag;
+};
+
+} // namespace server
+} // namespace ingen
+
+#endif // INGEN_ENGINE_SOCKETREACTOR_HPP
@@ -23,18 +23,24 @@
 #include "ingen/Tee.hpp"
 #include "raul/Socket.hpp"
 
+#include "ClientQueue.hpp"
 #include "EventWriter.hpp"
 
 namespace ingen {
 namespace server {
 
-/** The server side of an Ingen socket connection. */
+/** The server side of an Ingen socket connection.
+ *
+ * If `threaded` is false, the connection does not read from the socket by
+ * itself, and read() must be called when it is readable (see SocketReactor).
+ */
 class SocketServer
 {
 public:
 	SocketServer(World&             world,
 	             server::Engine&    engine,
-	             SPtr<Raul::Socket> sock)
+	             SPtr<Raul::Socket> sock,
+	             bool               threaded = true)
 		: _engine(engine)
 		, _sink(world.conf().option("dump").get<int32_t>()
 		        ? SPtr<Interface>(
@@ -45,11 +51,14 @@ public:
 					                                          stderr,
 					                                          ColorContext::Color::CYAN))}))
 		        : SPtr<Interface>(new EventWriter(engine)))
-		, _reader(new SocketReader(world, *_sink.get(), sock))
-		, _writer(new SocketWriter(world.uri_map(),
-		                           world.uris(),
-		                           URI(sock->uri()),
-		                           sock))
+		, _reader(new SocketReader(world, *_sink.get(), sock, threaded))
+		, _writer(new ClientQueue(engine,
+		                          SPtr<Interface>(
+			                          new SocketWriter(world.uri_map(),
+			                                           world.uris(),
+			                                           URI(sock->uri()),
+			                                           sock)),
+		                          [sock]() { sock->shutdown(); }))
 	{
 		_sink->set_respondee(_writer);
 		engine.register_client(_writer);
@@ -61,6 +70,9 @@ public:
 		}
 	}
 
+	/** Read all available messages, return false if the connection closed. */
+	bool read() { return _reader->read(); }
+
 protected:
 	void on_hangup() {
 		_engine.unregister_client(_writer);
@@ -71,7 +83,7 @@ private:
 	server::Engine&    _engine;
 	SPtr<Interface>    _sink;
 	SPtr<SocketReader> _reader;
-	SPtr<SocketWriter> _writer;
+	SPtr<ClientQueue>  _writer;
 };
 
 }  // namespace ingen
@@ -15,7 +15,10 @@
 */
 
 #include "BlockImpl.hpp"
+#include "Engine.hpp"
+#include "FlightRecorder.hpp"
 #include "Task.hpp"
+#include "Tracer.hpp"
 
 namespace ingen {
 namespace server {
@@ -25,8 +28,27 @@ Task::run(RunContext& context)
 {
 	switch (_mode) {
 	case Mode::SINGLE:
-		// fprintf(stderr, "%u run %s\n", context.id(), _block->path().c_str());
-		_block->process(context);
+		if (context.engine().tracer()->enabled() ||
+		    context.engine().flight_recorder()->enabled()) {
+			Engine&        engine = context.engine();
+			const uint64_t start  = engine.current_time();
+			_block->process(context);
+			const uint64_t end = engine.current_time();
+			if (engine.tracer()->enabled()) {
+				engine.tracer()->record(context.id(),
+				                        Tracer::Type::BLOCK,
+				                        start,
+				                        end,
+				                        nullptr,
+				                        _block->urid());
+			}
+			if (engine.flight_recorder()->enabled()) {
+				engine.flight_recorder()->record(
+					context.id(), _block->urid(), start, end);
+			}
+		} else {
+			_block->process(context);
+		}
 		break;
 	case Mode::SEQUENTIAL:
 		for (const auto& task : _children) {
@@ -71,6 +93,18 @@ Task::steal(RunContext& context)
 	return nullptr;
 }
 
+/** Record the time spent waiting for tasks if any, and return the time. */
+static uint64_t
+record_wait(RunContext& context, uint64_t start)
+{
+	const uint64_t now = context.engine().current_time();
+	if (now > start) {
+		context.engine().tracer()->record(
+			context.id(), Tracer::Type::WAIT, start, now);
+	}
+	return now;
+}
+
 Task*
 Task::get_task(RunContext& context)
 {
@@ -80,6 +114,9 @@ Task::get_task(RunContext& context)
 		return t;
 	}
 
+	Tracer* const  tracer     = context.engine().tracer().get();
+	const bool     tracing    = tracer->enabled();
+	const uint64_t wait_start = tracing ? context.engine().current_time() : 0;
 	while (true) {
 		// Push done end index as forward as possible
 		while (_done_end < _children.size() && _children[_done_end]->done()) {
@@ -87,11 +124,18 @@ Task::get_task(RunContext& context)
 		}
 
 		if (_done_end >= _children.size()) {
+			if (tracing) {
+				record_wait(context, wait_start);
+			}
 			return nullptr;  // All child tasks are finished
 		}
 
 		// All child tasks claimed, but some are unfinished, steal a task
 		if ((t = context.steal_task())) {
+			if (tracing) {
+				const uint64_t now = record_wait(context, wait_start);
+				tracer->record(context.id(), Tracer::Type::STEAL, now, now);
+			}
 			return t;
 		}
 
@@ -0,0 +1,177 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+#include "ingen/URIMap.hpp"
+
+#include "Tracer.hpp"
+
+namespace ingen {
+namespace server {
+
+/** Number of records kept for each thread (must be a power of two). */
+static const size_t ring_size = 1 << 16;
+
+Tracer::Tracer(URIMap& map, unsigned n_threads)
+	: _map(map)
+{
+	for (unsigned i = 0; i < n_threads; ++i) {
+		_rings.emplace_back(new Ring(ring_size));
+	}
+}
+
+void
+Tracer::record(unsigned    thread,
+               Type        type,
+               uint64_t    start,
+               uint64_t    end,
+               const char* name,
+               LV2_URID    urid)
+{
+	Ring&          ring = *_rings[thread];
+	const uint64_t n    = ring.head.load(std::memory_order_relaxed);
+
+	ring.records[n & (ring_size - 1)] = {
+		start, uint32_t(end - start), urid, name, type };
+
+	ring.head.store(n + 1, std::memory_order_release);
+}
+
+static const char*
+type_name(Tracer::Type type)
+{
+	switch (type) {
+	case Tracer::Type::CYCLE:        return "cycle";
+	case Tracer::Type::BLOCK:        return "block";
+	case Tracer::Type::STEAL:        return "steal";
+	case Tracer::Type::WAIT:         return "wait";
+	case Tracer::Type::EXECUTE:      return "execute";
+	case Tracer::Type::POST_PROCESS: return "post_process";
+	}
+	return "";
+}
+
+/** Return a type name from RTTI in readable form if possible. */
+static std::string
+demangle(const char* name)
+{
+#ifdef __GNUC__
+	int   status    = 0;
+	char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+	if (demangled) {
+		const std::string result(demangled);
+		free(demangled);
+		return result;
+	}
+#endif
+	return name;
+}
+
+/** Write `str` as a JSON string. */
+static void
+write_string(FILE* out, const std::string& str)
+{
+	fputc('"', out);
+	for (const char c : str) {
+		if (c == '"' || c == '\\') {
+			fputc('\\', out);
+			fputc(c, out);
+		} else if ((unsigned char)c < 0x20) {
+			fprintf(out, "\\u%04x", (unsigned)c);
+		} else {
+			fputc(c, out);
+		}
+	}
+	fputc('"', out);
+}
+
+bool
+Tracer::write(const std::string& path) const
+{
+	FILE* out = fopen(path.c_str(), "w");
+	if (!out) {
+		return false;
+	}
+
+	fprintf(out, "{\"traceEvents\":[");
+
+	const char* sep = "\n";
+	for (size_t t = 0; t < _rings.size(); ++t) {
+		const Ring& ring = *_rings[t];
+
+		// Name thread
+		const std::string thread_name = ((t + 1 == _rings.size())
+		                                 ? "post process"
+		                                 : "run " + std::to_string(t));
+		fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+		        "\"tid\":%zu,\"args\":{\"name\":", sep, t);
+		write_string(out, thread_name);
+		fprintf(out, "}}");
+		sep = ",\n";
+
+		// Copy records, which may be overwritten by the thread meanwhile
+		const uint64_t      head  = ring.head.load(std::memory_order_acquire);
+		const uint64_t      first = head > ring_size ? head - ring_size : 0;
+		std::vector<Record> records;
+		records.reserve(head - first);
+		for (uint64_t i = first; i < head; ++i) {
+			records.push_back(ring.records[i & (ring_size - 1)]);
+		}
+
+		// Skip any records that were overwritten while copying
+		const uint64_t after = ring.head.load(std::memory_order_acquire);
+		const size_t   skip  = std::min(
+			size_t(after > first + ring_size ? after - first - ring_size : 0),
+			records.size());
+
+		for (size_t i = skip; i < records.size(); ++i) {
+			const Record& r = records[i];
+
+			std::string name = type_name(r.type);
+			if (r.urid) {
+				const char* const uri = _map.unmap_uri(r.urid);
+				name = uri ? uri : name;
+			} else if (r.name) {
+				name = demangle(r.name);
+			}
+
+			fprintf(out, "%s{\"name\":", sep);
+			write_string(out, name);
+			fprintf(out, ",\"cat\":\"%s\",", type_name(r.type));
+			if (r.type == Type::STEAL) {
+				fprintf(out, "\"ph\":\"i\",\"s\":\"t\",");
+			} else {
+				fprintf(out, "\"ph\":\"X\",\"dur\":%u,", r.duration);
+			}
+			fprintf(out, "\"ts\":%llu,\"pid\":1,\"tid\":%zu}",
+			        (unsigned long long)r.start, t);
+		}
+	}
+
+	fprintf(out, "\n]}\n");
+	return !fclose(out);
+}
+
+} // namespace server
+} // namespace ingen
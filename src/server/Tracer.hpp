@@ -0,0 +1,103 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_ENGINE_TRACER_HPP
+#define INGEN_ENGINE_TRACER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ingen/types.hpp"
+#include "lv2/urid/urid.h"
+
+namespace ingen {
+
+class URIMap;
+
+namespace server {
+
+/** A recorder of what the engine threads are doing and when.
+ *
+ * Each thread records spans (with a start and end time in microseconds) into
+ * its own fixed-size ring, so recording is real-time safe and lock-free.  When
+ * a ring is full, the oldest records are overwritten.  The rings can be
+ * written out at any time from a non-realtime thread as a Chrome trace event
+ * file, which can be viewed with chrome://tracing or Perfetto.
+ *
+ * Run contexts use the thread index of their ID, and the post-processor uses
+ * the index after them.
+ *
+ * \ingroup engine
+ */
+class Tracer
+{
+public:
+	enum class Type : uint8_t {
+		CYCLE,        ///< Run of an entire process cycle
+		BLOCK,        ///< Run of a single block
+		STEAL,        ///< A task stolen from another thread (instant)
+		WAIT,         ///< Spinning while waiting for parallel tasks
+		EXECUTE,      ///< Execution of an event
+		POST_PROCESS  ///< Post-processing of an event
+	};
+
+	/** Create a tracer for `n_threads` threads, or a disabled one if zero. */
+	Tracer(URIMap& map, unsigned n_threads);
+
+	/** Return true iff records are being kept. */
+	bool enabled() const { return !_rings.empty(); }
+
+	/** Record a span on a thread (realtime safe).
+	 *
+	 * @param name A static string naming an event, or null.
+	 * @param urid The URID of the block's URI, for BLOCK spans.
+	 */
+	void record(unsigned    thread,
+	            Type        type,
+	            uint64_t    start,
+	            uint64_t    end,
+	            const char* name = nullptr,
+	            LV2_URID    urid = 0);
+
+	/** Write all current records to a Chrome trace event JSON file. */
+	bool write(const std::string& path) const;
+
+private:
+	struct Record {
+		uint64_t    start;
+		uint32_t    duration;
+		LV2_URID    urid;
+		const char* name;
+		Type        type;
+	};
+
+	struct Ring {
+		explicit Ring(size_t size) : head(0), records(new Record[size]) {}
+
+		std::atomic<uint64_t> head;  ///< Total number of records written
+		UPtr<Record[]>        records;
+	};
+
+	URIMap&                 _map;
+	std::vector<UPtr<Ring>> _rings;
+};
+
+} // namespace server
+} // namespace ingen
+
+#endif // INGEN_ENGINE_TRACER_HPP
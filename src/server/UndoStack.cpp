@@ -14,6 +14,9 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <ctime>
 
 #include "ingen/URIMap.hpp"
@@ -32,13 +35,42 @@
 namespace ingen {
 namespace server {
 
+/** Default size of a chunk of undo history in bytes. */
+static const size_t chunk_size = 64 * 1024;
+
+UndoStack::Chunk*
+UndoStack::add_chunk(size_t size)
+{
+	_chunks.emplace_back(new Chunk(size));
+	_chunk_bytes += size;
+	return _chunks.back().get();
+}
+
+void
+UndoStack::pop_chunk_back()
+{
+	_chunk_bytes -= _chunks.back()->capacity;
+	_chunks.pop_back();
+}
+
+void
+UndoStack::update_memory()
+{
+	_memory = _chunk_bytes + _records.size() * sizeof(Record);
+}
+
 int
 UndoStack::start_entry()
 {
 	if (_depth == 0) {
 		time_t now;
 		time(&now);
-		_stack.push_back(Entry(now));
+
+		Chunk* const chunk = (_chunks.empty()
+		                      ? add_chunk(chunk_size)
+		                      : _chunks.back().get());
+
+		_records.push_back({now, chunk, chunk->used, 0, 0});
 	}
 	return ++_depth;
 }
@@ -46,7 +78,35 @@ UndoStack::start_entry()
 bool
 UndoStack::write(const LV2_Atom* msg, int32_t default_id)
 {
-	_stack.back().push_event(msg);
+	Record&        record = _records.back();
+	Chunk*         chunk  = record.chunk;
+	const uint32_t size   = lv2_atom_total_size(msg);
+	const uint32_t padded = lv2_atom_pad_size(size);
+
+	if (chunk->used + padded > chunk->capacity) {
+		/* Move this entry to a new chunk with room for it to double, so a
+		   large entry is only copied a logarithmic number of times. */
+		Chunk* const next = add_chunk(
+			std::max(chunk_size, 2 * (record.size + padded)));
+
+		memcpy(next->data(), chunk->data() + record.offset, record.size);
+		next->used  = record.size;
+		chunk->used = record.offset;
+		if (chunk->used == 0) {
+			// Entry was alone in the previous chunk, which is now empty
+			_chunk_bytes -= chunk->capacity;
+			_chunks.erase(_chunks.end() - 2);
+		}
+
+		record.chunk  = next;
+		record.offset = 0;
+		chunk         = next;
+	}
+
+	memcpy(chunk->data() + chunk->used, msg, size);
+	chunk->used += padded;
+	record.size += padded;
+	++record.n_events;
 	return true;
 }
 
@@ -85,30 +145,81 @@ UndoStack::finish_entry()
 {
 	if (--_depth > 0) {
 		return _depth;
-	} else if (_stack.back().events.empty()) {
+	} else if (_records.back().n_events == 0) {
 		// Disregard empty entry
-		_stack.pop_back();
-	} else if (_stack.size() > 1 && _stack.back().events.size() == 1) {
+		pop_record();
+	} else if (_records.size() > 1 && _records.back().n_events == 1) {
 		// This entry and the previous one have one event, attempt to merge
-		auto i = _stack.rbegin();
-		++i;
-		if (i->events.size() == 1) {
-			if (ignore_later_event(i->events[0], _stack.back().events[0])) {
-				_stack.pop_back();
-			}
+		const Record& prev = _records[_records.size() - 2];
+		if (prev.n_events == 1 &&
+		    ignore_later_event(first_event(prev),
+		                       first_event(_records.back()))) {
+			pop_record();
 		}
 	}
 
+	evict();
+	update_memory();
 	return _depth;
 }
 
+/** Remove the newest entry, which is always in the last chunk. */
+void
+UndoStack::pop_record()
+{
+	Chunk* const chunk = _records.back().chunk;
+	assert(chunk == _chunks.back().get());
+
+	chunk->used = _records.back().offset;
+	_records.pop_back();
+	if (chunk->used == 0 && _chunks.size() > 1) {
+		pop_chunk_back();
+	}
+}
+
+/** Free the chunks with the oldest entries until under the memory limit. */
+void
+UndoStack::evict()
+{
+	while (_max_memory && _chunks.size() > 1 &&
+	       _chunk_bytes + _records.size() * sizeof(Record) > _max_memory) {
+		Chunk* const chunk = _chunks.front().get();
+		while (!_records.empty() && _records.front().chunk == chunk) {
+			_records.pop_front();
+		}
+
+		_chunk_bytes -= chunk->capacity;
+		_chunks.pop_front();
+	}
+}
+
+UndoStack::Entry
+UndoStack::entry(const Record& record) const
+{
+	Entry result(record.time);
+	result.data.resize(record.size / sizeof(uint64_t));
+	memcpy(result.data.data(), record.chunk->data() + record.offset, record.size);
+
+	// Events are undone in the reverse order they were written
+	const uint8_t* const data = (const uint8_t*)result.data.data();
+	for (size_t offset = 0; offset < record.size;) {
+		const LV2_Atom* const atom = (const LV2_Atom*)(data + offset);
+		result.events.push_back(atom);
+		offset += lv2_atom_pad_size(lv2_atom_total_size(atom));
+	}
+	std::reverse(result.events.begin(), result.events.end());
+
+	return result;
+}
+
 UndoStack::Entry
 UndoStack::pop()
 {
 	Entry top;
-	if (!_stack.empty()) {
-		top = _stack.back();
-		_stack.pop_back();
+	if (!_records.empty()) {
+		top = entry(_records.back());
+		pop_record();
+		update_memory();
 	}
 	return top;
 }
@@ -236,11 +347,11 @@ UndoStack::save(FILE* stream, const char* name)
 
 	BlankIDs    ids('u');
 	ListContext ctx(ids, 0, &s, &p);
-	for (const Entry& e : _stack) {
-		const SerdNode entry = ids.get();
-		ctx.append(writer, SERD_ANON_O_BEGIN, &entry);
-		write_entry(sratom, writer, &entry, e);
-		serd_writer_end_anon(writer, &entry);
+	for (const Record& r : _records) {
+		const SerdNode node = ids.get();
+		ctx.append(writer, SERD_ANON_O_BEGIN, &node);
+		write_entry(sratom, writer, &node, entry(r));
+		serd_writer_end_anon(writer, &node);
 	}
 	ctx.end(writer);
 
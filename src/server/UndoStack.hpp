@@ -17,11 +17,15 @@
 #ifndef INGEN_ENGINE_UNDOSTACK_HPP
 #define INGEN_ENGINE_UNDOSTACK_HPP
 
+#include <atomic>
+#include <cstdint>
 #include <ctime>
 #include <deque>
+#include <vector>
 
 #include "ingen/AtomSink.hpp"
 #include "ingen/ingen.h"
+#include "ingen/types.hpp"
 #include "lv2/atom/atom.h"
 #include "serd/serd.h"
 #include "sratom/sratom.h"
@@ -33,60 +37,87 @@ class URIs;
 
 namespace server {
 
+/** A stack of undo (or redo) entries, each a sequence of events.
+ *
+ * Events are copied into large chunks of memory rather than allocated
+ * individually.  If a memory limit is set, the chunks with the oldest entries
+ * are freed when the limit is exceeded.
+ */
 class INGEN_API UndoStack : public AtomSink {
 public:
+	/** An entry removed from the stack, which owns a copy of its events. */
 	struct Entry {
 		Entry(time_t time=0) : time(time) {}
 
-		Entry(const Entry& copy)
-			: time(copy.time)
-		{
-			for (const LV2_Atom* ev : copy.events) {
-				push_event(ev);
-			}
-		}
-
-		~Entry() { clear(); }
-
-		Entry& operator=(const Entry& rhs) {
-			clear();
-			time = rhs.time;
-			for (const LV2_Atom* ev : rhs.events) {
-				push_event(ev);
-			}
-			return *this;
-		}
-
-		void clear() {
-			for (LV2_Atom* ev : events) {
-				free(ev);
-			}
-			events.clear();
-		}
-
-		void push_event(const LV2_Atom* ev) {
-			const uint32_t size = lv2_atom_total_size(ev);
-			LV2_Atom*      copy = (LV2_Atom*)malloc(size);
-			memcpy(copy, ev, size);
-			events.push_front(copy);
-		}
-
-		time_t                time;
-		std::deque<LV2_Atom*> events;
+		Entry(const Entry&) = delete;
+		Entry& operator=(const Entry&) = delete;
+
+		Entry(Entry&&)            = default;
+		Entry& operator=(Entry&&) = default;
+
+		time_t                       time;
+		std::vector<uint64_t>        data;    ///< Storage for events
+		std::vector<const LV2_Atom*> events;  ///< Events in undo order
 	};
 
-	UndoStack(URIs& uris, URIMap& map) : _uris(uris), _map(map), _depth(0) {}
+	/** Create a stack which uses at most `max_memory` bytes (zero for none). */
+	UndoStack(URIs& uris, URIMap& map, size_t max_memory=0)
+		: _uris(uris)
+		, _map(map)
+		, _max_memory(max_memory)
+		, _chunk_bytes(0)
+		, _memory(0)
+		, _depth(0)
+	{}
 
 	int  start_entry();
 	bool write(const LV2_Atom* msg, int32_t default_id=0) override;
 	int  finish_entry();
 
-	bool  empty() const { return _stack.empty(); }
+	bool  empty() const { return _records.empty(); }
 	Entry pop();
 
+	/** Return the memory used by this stack in bytes, from any thread. */
+	size_t memory() const { return _memory.load(); }
+
 	void save(FILE* stream, const char* name="undo");
 
 private:
+	/** A chunk of memory which entries are written to contiguously. */
+	struct Chunk {
+		explicit Chunk(size_t size)
+			: buf(new uint64_t[size / sizeof(uint64_t)])
+			, capacity(size)
+			, used(0)
+		{}
+
+		uint8_t* data() { return (uint8_t*)buf.get(); }
+
+		UPtr<uint64_t[]> buf;
+		size_t           capacity;  ///< Size of buf in bytes
+		size_t           used;      ///< Bytes used by entries
+	};
+
+	/** An entry on the stack, stored in a chunk. */
+	struct Record {
+		time_t   time;
+		Chunk*   chunk;
+		size_t   offset;    ///< Offset of first event in chunk
+		size_t   size;      ///< Size of all (padded) events
+		uint32_t n_events;
+	};
+
+	Chunk* add_chunk(size_t size);
+	void   pop_chunk_back();
+	void   pop_record();
+	void   evict();
+	void   update_memory();
+	Entry  entry(const Record& record) const;
+
+	const LV2_Atom* first_event(const Record& record) const {
+		return (const LV2_Atom*)(record.chunk->data() + record.offset);
+	}
+
 	bool ignore_later_event(const LV2_Atom* first,
 	                        const LV2_Atom* second) const;
 
@@ -95,10 +126,14 @@ private:
 	                 const SerdNode* subject,
 	                 const Entry&    entry);
 
-	URIs&             _uris;
-	URIMap&           _map;
-	std::deque<Entry> _stack;
-	int               _depth;
+	URIs&                   _uris;
+	URIMap&                 _map;
+	std::deque<UPtr<Chunk>> _chunks;
+	std::deque<Record>      _records;
+	size_t                  _max_memory;
+	size_t                  _chunk_bytes;
+	std::atomic<size_t>     _memory;
+	int                     _depth;
 };
 
 } // namespace server
@@ -14,6 +14,9 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <chrono>
+
 #include "ingen/LV2Features.hpp"
 #include "ingen/Log.hpp"
 #include "lv2/worker/worker.h"
@@ -21,15 +24,18 @@
 #include "Engine.hpp"
 #include "GraphImpl.hpp"
 #include "LV2Block.hpp"
+#include "RunContext.hpp"
 #include "Worker.hpp"
 
 namespace ingen {
 namespace server {
 
-/// A message in the Worker::_requests ring
+/// A message in a Worker request ring
 struct MessageHeader {
 	LV2Block* block;  ///< Node this message is from
-	uint32_t  size;  ///< Size of following data
+	uint32_t  size;   ///< Size of following data
+	uint32_t  seq;    ///< Sequence number of request from block
+	uint64_t  time;   ///< Time of request in microseconds
 	// `size' bytes of data follow here
 };
 
@@ -64,22 +70,39 @@ Worker::request(LV2Block*   block,
 		return block->work(size, data);
 	}
 
+	/* Run contexts write to their own ring without locking, any other thread
+	   (like the pre-processor restoring state) locks the shared ring. */
+	const int ring_index = RunContext::current_id();
+	const bool shared    = ring_index < 0 || ring_index + 1 >= int(_rings.size());
+	Ring&      ring      = *_rings[shared ? _rings.size() - 1 : ring_index];
+
+	std::unique_lock<std::mutex> lock(ring.mutex, std::defer_lock);
+	if (shared) {
+		lock.lock();
+	}
+
 	Engine& engine = block->parent_graph()->engine();
-	if (_requests.write_space() < sizeof(MessageHeader) + size) {
+	if (ring.requests.write_space() < sizeof(MessageHeader) + size) {
 		engine.log().error("Work request ring overflow\n");
 		return LV2_WORKER_ERR_NO_SPACE;
 	}
 
-	const MessageHeader msg = { block, size };
-	if (_requests.write(sizeof(msg), &msg) != sizeof(msg)) {
+	const MessageHeader msg = {
+		block, size, block->next_work_seq(), engine.current_time() };
+	if (ring.requests.write(sizeof(msg), &msg) != sizeof(msg)) {
 		engine.log().error("Error writing header to work request ring\n");
 		return LV2_WORKER_ERR_UNKNOWN;
 	}
-	if (_requests.write(size, data) != size) {
+	if (ring.requests.write(size, data) != size) {
 		engine.log().error("Error writing body to work request ring\n");
 		return LV2_WORKER_ERR_UNKNOWN;
 	}
 
+	// Update queue length statistics
+	const uint32_t length = ++_queue_length;
+	uint32_t       max    = _max_queue_length.load();
+	while (length > max && !_max_queue_length.compare_exchange_weak(max, length)) {}
+
 	_sem.post();
 
 	return LV2_WORKER_SUCCESS;
@@ -105,56 +128,162 @@ Worker::Schedule::feature(World* world, Node* n)
 	return SPtr<LV2_Feature>(f, &free_feature);
 }
 
-Worker::Worker(Log& log, uint32_t buffer_size, bool synchronous)
+Worker::Worker(Log&     log,
+               uint32_t buffer_size,
+               unsigned n_rings,
+               unsigned n_threads,
+               bool     synchronous)
 	: _schedule(new Schedule(synchronous))
 	, _log(log)
 	, _sem(0)
-	, _requests(buffer_size)
-	, _responses(buffer_size)
-	, _buffer((uint8_t*)malloc(buffer_size))
 	, _buffer_size(buffer_size)
-	, _thread(nullptr)
+	, _queue_length(0)
+	, _max_queue_length(0)
+	, _n_working(0)
 	, _exit_flag(false)
 	, _synchronous(synchronous)
 {
 	if (!synchronous) {
-		_thread = new std::thread(&Worker::run, this);
+		for (unsigned i = 0; i < n_rings + 1; ++i) {
+			_rings.emplace_back(new Ring(buffer_size));
+		}
+		for (unsigned i = 0; i < std::max(n_threads, 1u); ++i) {
+			_threads.emplace_back(&Worker::run, this);
+		}
 	}
 }
 
 Worker::~Worker()
 {
 	_exit_flag = true;
-	_sem.post();
-	if (_thread) {
-		_thread->join();
-		delete _thread;
+	for (size_t i = 0; i < _threads.size(); ++i) {
+		_sem.post();
+	}
+	_finished.notify_all();
+	for (auto& t : _threads) {
+		t.join();
 	}
-	free(_buffer);
 }
 
-void
-Worker::run()
+Latency
+Worker::latency() const
 {
-	while (_sem.wait() && !_exit_flag) {
+	std::lock_guard<std::mutex> lock(_latency_mutex);
+	return _latency;
+}
+
+bool
+Worker::handle_request(uint8_t* buffer)
+{
+	for (auto& ring : _rings) {
+		std::unique_lock<std::mutex> lock(ring->mutex);
+
 		MessageHeader msg;
-		if (_requests.read_space() > sizeof(msg)) {
-			if (_requests.read(sizeof(msg), &msg) != sizeof(msg)) {
-				_log.error("Error reading header from work request ring\n");
-				continue;
-			}
+		if (ring->requests.read_space() < sizeof(msg) ||
+		    ring->requests.peek(sizeof(msg), &msg) != sizeof(msg) ||
+		    ring->requests.read_space() < sizeof(msg) + msg.size) {
+			continue;  // Empty, or request not completely written yet
+		} else if (msg.size > _buffer_size - sizeof(msg)) {
+			/* The blocks of the dropped requests can not be known, they are
+			   recovered when their next request stalls (see check_stall()). */
+			_log.error("Corrupt work request ring\n");
+			ring->requests.reset();
+			continue;
+		} else if (!msg.block->work_is_next(msg.seq)) {
+			continue;  // Block is busy with an earlier request
+		}
 
-			if (msg.size >= _buffer_size - sizeof(msg)) {
-				_log.error("Corrupt work request ring\n");
-				return;
-			}
+		ring->requests.skip(sizeof(msg));
+		const bool read = ring->requests.read(msg.size, buffer) == msg.size;
+		++_n_working;
+		lock.unlock();
 
-			if (_requests.read(msg.size, _buffer) != msg.size) {
-				_log.error("Error reading body from work request ring\n");
-				continue;
-			}
+		--_queue_length;
+		if (!read) {
+			_log.error("Error reading body from work request ring\n");
+			msg.block->finish_work();
+			--_n_working;
+			continue;
+		}
+
+		Engine& engine = msg.block->parent_graph()->engine();
+		{
+			std::lock_guard<std::mutex> latency_lock(_latency_mutex);
+			_latency.update(engine.current_time() - msg.time);
+		}
 
-			msg.block->work(msg.size, _buffer);
+		msg.block->work(msg.size, buffer);
+		msg.block->finish_work();
+		--_n_working;
+
+		// Wake any threads waiting for this block to finish
+		{
+			std::lock_guard<std::mutex> finished_lock(_finished_mutex);
+		}
+		_finished.notify_all();
+		return true;
+	}
+
+	return false;
+}
+
+/** Check why no request can be worked, and skip lost requests.
+ *
+ * Requests of a block are written in order, so if no request is being worked,
+ * the earliest request at the head of a ring can only be waiting for earlier
+ * requests from its block that were lost.  Those are skipped so it can run.
+ */
+Worker::Stall
+Worker::check_stall()
+{
+	std::vector<std::unique_lock<std::mutex>> locks;
+	for (auto& ring : _rings) {
+		locks.emplace_back(ring->mutex);
+	}
+
+	bool          empty = true;
+	MessageHeader first = { nullptr, 0, 0, 0 };
+	for (auto& ring : _rings) {
+		MessageHeader msg;
+		if (ring->requests.read_space() < sizeof(msg) ||
+		    ring->requests.peek(sizeof(msg), &msg) != sizeof(msg) ||
+		    ring->requests.read_space() < sizeof(msg) + msg.size ||
+		    msg.size > _buffer_size - sizeof(msg)) {
+			continue;  // Empty, incomplete, or corrupt (see handle_request())
+		} else if (msg.block->work_is_next(msg.seq)) {
+			return Stall::BUSY;  // Can be worked now
+		} else if (empty || msg.time < first.time) {
+			first = msg;
+		}
+		empty = false;
+	}
+
+	if (empty) {
+		return Stall::EMPTY;
+	} else if (_n_working) {
+		return Stall::BUSY;
+	}
+
+	_log.warn("Skipping lost work requests\n");
+	first.block->skip_work(first.seq);
+	return Stall::RECOVERED;
+}
+
+void
+Worker::run()
+{
+	UPtr<uint8_t[]> buffer(new uint8_t[_buffer_size]);
+	while (_sem.wait() && !_exit_flag) {
+		/* Handle one request.  If every pending request is for a block that
+		   is busy with an earlier one, wait for a block to finish. */
+		while (!handle_request(buffer.get()) && !_exit_flag) {
+			const Stall stall = check_stall();
+			if (stall == Stall::EMPTY) {
+				break;  // Request was dropped, or taken by another thread
+			} else if (stall == Stall::BUSY) {
+				std::unique_lock<std::mutex> lock(_finished_mutex);
+				_finished.wait_for(lock, std::chrono::milliseconds(10));
+			}
 		}
 	}
 }
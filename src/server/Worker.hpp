@@ -17,13 +17,21 @@
 #ifndef INGEN_ENGINE_WORKER_HPP
 #define INGEN_ENGINE_WORKER_HPP
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "ingen/LV2Features.hpp"
+#include "ingen/types.hpp"
 #include "lv2/worker/worker.h"
 #include "raul/RingBuffer.hpp"
 #include "raul/Semaphore.hpp"
 
+#include "Latency.hpp"
+
 namespace ingen {
 
 class Log;
@@ -32,10 +40,32 @@ namespace server {
 
 class LV2Block;
 
+/** A pool of threads that do non-realtime work for LV2 plugins.
+ *
+ * Each run context writes requests to its own lock-free ring, and requests
+ * from other threads are written to a shared ring under a mutex.  Any worker
+ * thread may serve any ring, but the requests of a block are always worked
+ * one at a time in the order they were made.
+ *
+ * \ingroup engine
+ */
 class Worker
 {
 public:
-	Worker(Log& log, uint32_t buffer_size, bool synchronous=false);
+	/** Create a worker.
+	 *
+	 * @param log Log for errors.
+	 * @param buffer_size Size of each request ring in bytes.
+	 * @param n_rings Number of run contexts that make requests.
+	 * @param n_threads Number of worker threads.
+	 * @param synchronous If true, work immediately in the requesting thread.
+	 */
+	Worker(Log&     log,
+	       uint32_t buffer_size,
+	       unsigned n_rings,
+	       unsigned n_threads,
+	       bool     synchronous=false);
+
 	~Worker();
 
 	struct Schedule : public LV2Features::Feature {
@@ -54,20 +84,50 @@ public:
 
 	SPtr<Schedule> schedule_feature() { return _schedule; }
 
+	/** Return the number of requests waiting to be worked. */
+	uint32_t queue_length() const { return _queue_length; }
+
+	/** Return the maximum number of requests that were waiting at once. */
+	uint32_t max_queue_length() const { return _max_queue_length; }
+
+	/** Return the times requests waited before being worked. */
+	Latency latency() const;
+
 private:
+	struct Ring {
+		explicit Ring(uint32_t size) : requests(size) {}
+
+		Raul::RingBuffer requests;
+		std::mutex       mutex;  ///< Held by readers, and writers to shared
+	};
+
+	/** State of the request rings when no request can be worked. */
+	enum class Stall {
+		EMPTY,     ///< No requests, wait for more
+		BUSY,      ///< Requests are waiting for blocks to finish earlier ones
+		RECOVERED  ///< Skipped requests that were lost, try again
+	};
+
+	bool  handle_request(uint8_t* buffer);
+	Stall check_stall();
+	void  run();
+
 	SPtr<Schedule> _schedule;
 
-	Log&             _log;
-	Raul::Semaphore  _sem;
-	Raul::RingBuffer _requests;
-	Raul::RingBuffer _responses;
-	uint8_t* const   _buffer;
-	const uint32_t   _buffer_size;
-	std::thread*     _thread;
-	bool             _exit_flag;
-	bool             _synchronous;
-
-	void run();
+	Log&                     _log;
+	Raul::Semaphore          _sem;
+	std::vector<UPtr<Ring>>  _rings;  ///< Per run context, then shared
+	std::vector<std::thread> _threads;
+	const uint32_t           _buffer_size;
+	std::mutex               _finished_mutex;
+	std::condition_variable  _finished;
+	mutable std::mutex       _latency_mutex;
+	Latency                  _latency;
+	std::atomic<uint32_t>    _queue_length;
+	std::atomic<uint32_t>    _max_queue_length;
+	std::atomic<unsigned>    _n_working;  ///< Number of requests being worked
+	std::atomic<bool>        _exit_flag;
+	bool                     _synchronous;
 };
 
 } // namespace server
@@ -14,6 +14,7 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <vector>
 #include <thread>
 
@@ -55,6 +56,7 @@ Delta::Delta(Engine&           engine,
 	, _context(msg.ctx)
 	, _type(Type::PUT)
 	, _block(false)
+	, _schedulable(false)
 {
 	init();
 }
@@ -75,6 +77,7 @@ Delta::Delta(Engine&             engine,
 	, _context(msg.ctx)
 	, _type(Type::PATCH)
 	, _block(false)
+	, _schedulable(false)
 {
 	init();
 }
@@ -94,6 +97,7 @@ Delta::Delta(Engine&                   engine,
 	, _context(msg.ctx)
 	, _type(Type::SET)
 	, _block(false)
+	, _schedulable(false)
 {
 	init();
 }
@@ -168,6 +172,91 @@ get_file_node(LilvWorld* lworld, const URIs& uris, const Atom& value)
 	return nullptr;
 }
 
+/** Update the subscription of the requesting client.
+ *
+ * This is called with the store locked, and records the ports whose watched
+ * flag must change in execute().
+ */
+bool
+Delta::update_subscription()
+{
+	const ingen::URIs& uris    = _engine.world()->uris();
+	Forge&             forge   = _engine.world()->forge();
+	Broadcaster&       bcaster = *_engine.broadcaster();
+
+	if (!_properties.count(uris.ingen_subscribe) &&
+	    !_properties.count(uris.ingen_filterProperty) &&
+	    !_properties.count(uris.ingen_updateRate) &&
+	    !_remove.count(uris.ingen_subscribe) &&
+	    !_remove.count(uris.ingen_filterProperty) &&
+	    !_remove.count(uris.ingen_updateRate)) {
+		return true;  // Subscription unchanged
+	}
+
+	Broadcaster::Subscription sub = bcaster.subscription(_request_client);
+	if (_type == Type::PUT || _type == Type::SET) {
+		if (_properties.count(uris.ingen_subscribe)) {
+			sub.paths.clear();
+		}
+		if (_properties.count(uris.ingen_filterProperty)) {
+			sub.properties.clear();
+		}
+	}
+
+	for (const auto& r : _remove) {
+		if (r.first == uris.ingen_subscribe) {
+			if (r.second == uris.patch_wildcard) {
+				sub.paths.clear();
+			} else if (forge.is_uri(r.second)) {
+				sub.paths.erase(uri_to_path(URI(forge.str(r.second, false))));
+			}
+		} else if (r.first == uris.ingen_filterProperty) {
+			if (r.second == uris.patch_wildcard) {
+				sub.properties.clear();
+			} else if (forge.is_uri(r.second)) {
+				sub.properties.erase(URI(forge.str(r.second, false)));
+			}
+		} else if (r.first == uris.ingen_updateRate) {
+			sub.rate = 0.0f;
+		}
+	}
+
+	for (const auto& p : _properties) {
+		if (p.first == uris.ingen_updateRate) {
+			if (p.second.type() == forge.Float) {
+				sub.rate = std::max(0.0f, p.second.get<float>());
+			} else if (p.second.type() == forge.Int) {
+				sub.rate = std::max(0, p.second.get<int32_t>());
+			} else {
+				_status = Status::BAD_VALUE_TYPE;
+				return false;
+			}
+			continue;
+		} else if (p.first != uris.ingen_subscribe &&
+		           p.first != uris.ingen_filterProperty) {
+			continue;
+		} else if (!forge.is_uri(p.second)) {
+			_status = Status::BAD_VALUE_TYPE;
+			return false;
+		}
+
+		const URI uri(forge.str(p.second, false));
+		if (p.first == uris.ingen_filterProperty) {
+			sub.properties.insert(uri);
+		} else if (uri_is_path(uri)) {
+			sub.paths.insert(uri_to_path(uri));
+		} else {
+			_status = Status::BAD_URI;
+			return false;
+		}
+	}
+
+	bcaster.set_subscription(_request_client, sub);
+	_engine.update_watched_ports(Raul::Path("/"));
+
+	return true;
+}
+
 bool
 Delta::pre_process(PreProcessContext& ctx)
 {
@@ -253,6 +342,10 @@ Delta::pre_process(PreProcessContext& ctx)
 		}
 	}
 
+	if (is_client && !update_subscription()) {
+		return Event::pre_process_done(_status, _subject);
+	}
+
 	_types.reserve(_properties.size());
 
 	NodeImpl* obj = dynamic_cast<NodeImpl*>(_object);
@@ -439,6 +532,13 @@ Delta::pre_process(PreProcessContext& ctx)
 		} else if (is_client && key == uris.ingen_broadcast) {
 			_engine.broadcaster()->set_broadcast(
 				_request_client, value.get<int32_t>());
+		} else if (is_client && key == uris.ingen_sharedMemory) {
+			if (value.type() != uris.forge.String) {
+				_status = Status::BAD_VALUE_TYPE;
+			} else {
+				_status = _engine.attach_shared_memory(_request_client,
+				                                       value.ptr<char>());
+			}
 		} else if (is_engine && key == uris.ingen_loadedBundle) {
  			LilvWorld* lworld = _engine.world()->lilv_world();
 			LilvNode*  bundle = get_file_node(lworld, uris, value);
@@ -469,6 +569,13 @@ Delta::pre_process(PreProcessContext& ctx)
 		s->pre_process(ctx);
 	}
 
+	// Only plain port value changes may be executed after later events
+	_schedulable = (!_create_event && !_preset && !_state && !_block &&
+	                !_set_events.empty() && _removed_bindings.empty() &&
+	                std::all_of(_types.begin(), _types.end(), [](SpecialType t) {
+		                return t == SpecialType::NONE;
+	                }));
+
 	return Event::pre_process_done(
 		_status == Status::NOT_PREPARED ? Status::SUCCESS : _status,
 		_subject);
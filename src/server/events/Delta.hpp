@@ -17,6 +17,7 @@
 #ifndef INGEN_EVENTS_DELTA_HPP
 #define INGEN_EVENTS_DELTA_HPP
 
+#include <utility>
 #include <vector>
 
 #include <boost/optional.hpp>
@@ -36,6 +37,7 @@ namespace server {
 
 class Engine;
 class GraphImpl;
+class PortImpl;
 class RunContext;
 
 namespace events {
@@ -77,6 +79,12 @@ public:
 
 	Execution get_execution() const override;
 
+	bool is_schedulable() const override { return _schedulable; }
+
+	const Node* subject() const override {
+		return dynamic_cast<const Node*>(_object);
+	}
+
 private:
 	enum class Type {
 		SET,
@@ -100,6 +108,8 @@ private:
 
 	void init();
 
+	bool update_subscription();
+
 	Event*                    _create_event;
 	SetEvents                 _set_events;
 	std::vector<SpecialType>  _types;
@@ -124,6 +134,7 @@ private:
 	boost::optional<Resource> _preset;
 
 	bool _block;
+	bool _schedulable;
 };
 
 } // namespace events
@@ -14,6 +14,10 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
 #include <utility>
 
 #include "ingen/Interface.hpp"
@@ -23,16 +27,69 @@
 #include "BlockImpl.hpp"
 #include "Broadcaster.hpp"
 #include "BufferFactory.hpp"
+#include "ClientQueue.hpp"
+#include "Driver.hpp"
 #include "Engine.hpp"
+#include "FlightRecorder.hpp"
 #include "Get.hpp"
 #include "GraphImpl.hpp"
 #include "PluginImpl.hpp"
 #include "PortImpl.hpp"
+#include "PostProcessor.hpp"
+#include "UndoStack.hpp"
+#include "Worker.hpp"
 
 namespace ingen {
 namespace server {
 namespace events {
 
+/** Maximum number of objects sent in one page of a graph. */
+static const size_t max_page_objects = 256;
+
+static Properties
+latency_properties(const URIs& uris, const Latency& latency)
+{
+	const uint64_t max_usec = std::numeric_limits<int32_t>::max();
+
+	return {
+		{ uris.ingen_medianLatency,
+		  uris.forge.make(int32_t(std::min(latency.percentile(50), max_usec))) },
+		{ uris.ingen_tailLatency,
+		  uris.forge.make(int32_t(std::min(latency.percentile(99), max_usec))) },
+		{ uris.ingen_maxLatency,
+		  uris.forge.make(int32_t(std::min(latency.max, max_usec))) } };
+}
+
+/** Describe the latency of events until each stage.
+ *
+ * Each stage is a resource like ingen:/engine/latency/executed, with a
+ * sub-resource for each type of event like ingen:/engine/latency/executed/Delta.
+ */
+static void
+put_latencies(Interface& client, const URIs& uris, const PostProcessor& pp)
+{
+	typedef PostProcessor::EventLatencies EventLatencies;
+
+	static const struct {
+		const char*              name;
+		Latency EventLatencies::*latency;
+	} stages[] = { { "prepared",       &EventLatencies::prepared },
+	               { "executed",       &EventLatencies::executed },
+	               { "post_processed", &EventLatencies::post_processed } };
+
+	for (const auto& stage : stages) {
+		const std::string base = std::string("ingen:/engine/latency/") + stage.name;
+
+		client.put(URI(base),
+		           latency_properties(uris, pp.total_latencies().*stage.latency));
+
+		for (const auto& l : pp.latencies()) {
+			client.put(URI(base + "/" + l.second.name),
+			           latency_properties(uris, l.second.*stage.latency));
+		}
+	}
+}
+
 Get::Get(Engine&           engine,
          SPtr<Interface>   client,
          SampleCount       timestamp,
@@ -41,26 +98,117 @@ Get::Get(Engine&           engine,
 	, _msg(msg)
 	, _object(nullptr)
 	, _plugin(nullptr)
+	, _more(false)
 {}
 
+Get::Get(Engine&                 engine,
+         SPtr<Interface>         client,
+         SampleCount             timestamp,
+         const ingen::Get&       msg,
+         const Raul::Path&       last,
+         std::vector<Raul::Path> graphs)
+	: Event(engine, client, msg.seq, timestamp)
+	, _msg(msg)
+	, _object(nullptr)
+	, _plugin(nullptr)
+	, _last(last)
+	, _graphs(std::move(graphs))
+	, _more(false)
+{}
+
+/** Send the arcs of the innermost open graph, if it still exists. */
+void
+Get::put_graph_arcs(const Store& store)
+{
+	const auto i = store.find(_graphs.back());
+	if (i != store.end()) {
+		const GraphImpl* graph = dynamic_cast<const GraphImpl*>(i->second.get());
+		if (graph) {
+			_response.put_arcs(graph);
+		}
+	}
+	_graphs.pop_back();
+}
+
+void
+Get::put_graph_page(const Store& store, Store::const_iterator top)
+{
+	const Raul::Path&           top_path = top->first;
+	const Store::const_iterator end      = store.find_descendants_end(top);
+
+	size_t                n = 0;
+	Store::const_iterator i = _last ? store.upper_bound(*_last) : top;
+	while (i != end && n < max_page_objects) {
+		const Raul::Path& path = i->first;
+		if (_msg.shallow && path != top_path && path.parent() != top_path) {
+			++i;  // Skip ports of a block sent in the previous page
+			continue;
+		}
+
+		// Send arcs of graphs that have been sent entirely
+		while (!_graphs.empty() && !path.is_child_of(_graphs.back())) {
+			put_graph_arcs(store);
+		}
+
+		const Node* const node  = i->second.get();
+		const GraphImpl*  graph = nullptr;
+		const BlockImpl*  block = nullptr;
+		const PortImpl*   port  = nullptr;
+		if ((graph = dynamic_cast<const GraphImpl*>(node))) {
+			_response.put_graph_properties(graph);
+			if (!_msg.shallow) {
+				_graphs.push_back(path);
+			}
+		} else if ((block = dynamic_cast<const BlockImpl*>(node))) {
+			_response.put(block->uri(), block->properties());
+		} else if ((port = dynamic_cast<const PortImpl*>(node))) {
+			_response.put_port(port);
+		}
+
+		_last = path;
+		++n;
+		if (_msg.shallow && path != top_path) {
+			i = store.find_descendants_end(i);
+		} else {
+			++i;
+		}
+	}
+
+	if (i == end) {
+		// Everything has been sent, finish with the arcs of open graphs
+		while (!_graphs.empty()) {
+			put_graph_arcs(store);
+		}
+	} else {
+		_more = true;
+	}
+}
+
 bool
 Get::pre_process(PreProcessContext& ctx)
 {
-	std::lock_guard<Store::Mutex> lock(_engine.store()->mutex());
+	const SPtr<Store>             store = _engine.store();
+	std::lock_guard<Store::Mutex> lock(store->mutex());
 
 	const auto& uri = _msg.subject;
 	if (uri == "ingen:/plugins") {
 		_plugins = _engine.block_factory()->plugins();
 		return Event::pre_process_done(Status::SUCCESS);
-	} else if (uri == "ingen:/engine") {
+	} else if (uri == "ingen:/engine" || uri == "ingen:/clients/this" ||
+	           uri == "ingen:/engine/overrun") {
 		return Event::pre_process_done(Status::SUCCESS);
 	} else if (uri_is_path(uri)) {
-		if ((_object = _engine.store()->get(uri_to_path(uri)))) {
+		const Store::const_iterator top = store->find(uri_to_path(uri));
+		if (top != store->end()) {
+			_object = top->second.get();
+
 			const BlockImpl* block = nullptr;
-			const GraphImpl* graph = nullptr;
 			const PortImpl*  port  = nullptr;
-			if ((graph = dynamic_cast<const GraphImpl*>(_object))) {
-				_response.put_graph(graph);
+			if (dynamic_cast<const GraphImpl*>(_object)) {
+				put_graph_page(*store, top);
+			} else if (_last) {
+				// Graph was replaced with something else since the last page
+				return Event::pre_process_done(Status::BAD_OBJECT_TYPE, uri);
 			} else if ((block = dynamic_cast<const BlockImpl*>(_object))) {
 				_response.put_block(block);
 			} else if ((port = dynamic_cast<const PortImpl*>(_object))) {
@@ -83,23 +231,92 @@ void
 Get::post_process()
 {
 	Broadcaster::Transfer t(*_engine.broadcaster());
+	if (_more && _request_client) {
+		// Send this page and continue after it, responding at the end
+		_response.send(*_request_client);
+		_engine.enqueue_event(new Get(_engine,
+		                              _request_client,
+		                              _time,
+		                              _msg,
+		                              *_last,
+		                              std::move(_graphs)));
+		return;
+	}
+
 	if (respond() == Status::SUCCESS && _request_client) {
 		if (_msg.subject == "ingen:/plugins") {
 			_engine.broadcaster()->send_plugins_to(_request_client.get(), _plugins);
 		} else if (_msg.subject == "ingen:/engine") {
 			// TODO: Keep a proper RDF model of the engine
-			URIs&      uris  = _engine.world()->uris();
-			Properties props = {
+			URIs&         uris  = _engine.world()->uris();
+			const int64_t frame = _engine.driver()->frame_time();
+			Properties    props = {
 				{ uris.param_sampleRate,
 				  uris.forge.make(int32_t(_engine.sample_rate())) },
+				{ uris.time_frame,
+				  Atom(sizeof(frame), uris.forge.Long, &frame) },
 				{ uris.bufsz_maxBlockLength,
 				  uris.forge.make(int32_t(_engine.block_length())) },
 				{ uris.ingen_numThreads,
-				  uris.forge.make(int32_t(_engine.n_threads())) } };
+				  uris.forge.make(int32_t(_engine.n_threads())) },
+				{ uris.ingen_mergedUpdates,
+				  uris.forge.make(int32_t(_engine.merged_notifications())) },
+				{ uris.ingen_undoMemory,
+				  uris.forge.make(int32_t(_engine.undo_stack()->memory() +
+				                          _engine.redo_stack()->memory())) } };
 
 			const Properties load_props = _engine.load_properties();
 			props.insert(load_props.begin(), load_props.end());
 			_request_client->put(URI("ingen:/engine"), props);
+			put_latencies(*_request_client, uris, *_engine.post_processor());
+
+			// Describe the plugin work queue
+			const Worker& worker       = *_engine.worker();
+			Properties    worker_props = latency_properties(uris, worker.latency());
+			worker_props.emplace(uris.ingen_queueLength,
+			                     uris.forge.make(int32_t(worker.queue_length())));
+			worker_props.emplace(uris.ingen_maxQueueLength,
+			                     uris.forge.make(int32_t(worker.max_queue_length())));
+			_request_client->put(URI("ingen:/engine/worker"), worker_props);
+
+			// Describe the driver, if it keeps statistics
+			const Properties driver_props = _engine.driver()->stats_properties();
+			if (!driver_props.empty()) {
+				_request_client->put(URI("ingen:/engine/driver"), driver_props);
+			}
+
+			// Describe overruns, if they are being recorded
+			if (_engine.flight_recorder()->enabled()) {
+				_request_client->put(URI("ingen:/engine/overrun"),
+				                     _engine.overrun_properties(false));
+			}
+
+			// Describe the notification ring of each run context
+			const auto& rings = _engine.notification_rings();
+			for (size_t i = 0; i < rings.size(); ++i) {
+				const NotificationRing& ring = *rings[i];
+				_request_client->put(
+					URI("ingen:/engine/notifications/" + std::to_string(i)),
+					{ { uris.ingen_queueLength,
+					    uris.forge.make(int32_t(ring.length())) },
+					  { uris.ingen_maxQueueLength,
+					    uris.forge.make(int32_t(ring.max_length())) },
+					  { uris.ingen_droppedMessages,
+					    uris.forge.make(int32_t(ring.n_dropped())) } });
+			}
+		} else if (_msg.subject == "ingen:/engine/overrun") {
+			_request_client->put(_msg.subject, _engine.overrun_properties(true));
+		} else if (_msg.subject == "ingen:/clients/this") {
+			Properties props =
+				_engine.broadcaster()->client_properties(_request_client);
+
+			const ClientQueue* queue =
+				dynamic_cast<const ClientQueue*>(_request_client.get());
+			if (queue) {
+				const Properties queue_props = queue->stats_properties();
+				props.insert(queue_props.begin(), queue_props.end());
+			}
+			_request_client->put(_msg.subject, props);
 		} else {
 			_response.send(*_request_client);
 		}
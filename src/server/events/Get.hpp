@@ -19,6 +19,11 @@
 
 #include <vector>
 
+#include <boost/optional.hpp>
+
+#include "ingen/Store.hpp"
+#include "raul/Path.hpp"
+
 #include "BlockFactory.hpp"
 #include "ClientUpdate.hpp"
 #include "Event.hpp"
@@ -35,6 +40,12 @@ class PortImpl;
 namespace events {
 
 /** A request from a client to send an object.
+ *
+ * Graphs are sent in pages of a bounded number of objects, in path order so
+ * parents are sent before their children.  After sending a page, the event
+ * enqueues another Get to continue after the last object sent, so the store
+ * is only locked, and a response only built, for one page at a time.  The
+ * arcs of a graph are sent once everything in it has been.
  *
  * \ingroup engine
  */
@@ -50,12 +61,28 @@ public:
 	void execute(RunContext& context) override {}
 	void post_process() override;
 
+	bool is_read_only() const override { return true; }
+
 private:
-	const ingen::Get      _msg;
-	const Node*           _object;
-	PluginImpl*           _plugin;
-	BlockFactory::Plugins _plugins;
-	ClientUpdate          _response;
+	/** Continue sending a graph after `last`, the last object sent. */
+	Get(Engine&                 engine,
+	    SPtr<Interface>         client,
+	    SampleCount             timestamp,
+	    const ingen::Get&       msg,
+	    const Raul::Path&       last,
+	    std::vector<Raul::Path> graphs);
+
+	void put_graph_page(const Store& store, Store::const_iterator top);
+	void put_graph_arcs(const Store& store);
+
+	const ingen::Get            _msg;
+	const Node*                 _object;
+	PluginImpl*                 _plugin;
+	BlockFactory::Plugins       _plugins;
+	ClientUpdate                _response;
+	boost::optional<Raul::Path> _last;    ///< Last object sent, if paging
+	std::vector<Raul::Path>     _graphs;  ///< Sent graphs with unsent arcs
+	bool                        _more;    ///< More pages are to be sent
 };
 
 } // namespace events
@@ -62,6 +62,7 @@ Move::pre_process(PreProcessContext& ctx)
 	}
 
 	_engine.store()->rename(i, _msg.new_path);
+	_engine.update_watched_ports(_msg.new_path);
 
 	return Event::pre_process_done(Status::SUCCESS);
 }
@@ -0,0 +1,92 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ingen/URIs.hpp"
+#include "raul/Array.hpp"
+#include "raul/Maid.hpp"
+
+#include "Buffer.hpp"
+#include "InputPort.hpp"
+#include "InternalPlugin.hpp"
+#include "OutputPort.hpp"
+#include "RunContext.hpp"
+#include "internals/Crossfade.hpp"
+#include "internals/dsp.hpp"
+
+namespace ingen {
+namespace server {
+namespace internals {
+
+InternalPlugin* CrossfadeNode::internal_plugin(URIs& uris) {
+	return new InternalPlugin(
+		uris, URI(NS_INTERNALS "Crossfade"), Raul::Symbol("crossfade"));
+}
+
+CrossfadeNode::CrossfadeNode(InternalPlugin*     plugin,
+                             BufferFactory&      bufs,
+                             const Raul::Symbol& symbol,
+                             bool                polyphonic,
+                             GraphImpl*          parent,
+                             SampleRate          srate)
+	: InternalBlock(plugin, symbol, polyphonic, parent, srate)
+{
+	const ingen::URIs& uris = bufs.uris();
+	_ports = bufs.maid().make_managed<Ports>(4);
+
+	const Atom zero = bufs.forge().make(0.0f);
+	const Atom one  = bufs.forge().make(1.0f);
+
+	_a_port = new InputPort(bufs, this, Raul::Symbol("a"), 0, _polyphony,
+	                        PortType::AUDIO, uris.atom_Sound, zero);
+	_a_port->set_property(uris.lv2_name, bufs.forge().alloc("A"));
+	_ports->at(0) = _a_port;
+
+	_b_port = new InputPort(bufs, this, Raul::Symbol("b"), 1, _polyphony,
+	                        PortType::AUDIO, uris.atom_Sound, zero);
+	_b_port->set_property(uris.lv2_name, bufs.forge().alloc("B"));
+	_ports->at(1) = _b_port;
+
+	_fade_port = new InputPort(bufs, this, Raul::Symbol("fade"), 2, _polyphony,
+	                           PortType::CONTROL, uris.atom_Sequence, zero);
+	_fade_port->set_property(uris.lv2_minimum, zero);
+	_fade_port->set_property(uris.lv2_maximum, one);
+	_fade_port->set_property(uris.lv2_name, bufs.forge().alloc("Fade"));
+	_fade_port->set_minimum(zero);
+	_fade_port->set_maximum(one);
+	_ports->at(2) = _fade_port;
+
+	_out_port = new OutputPort(bufs, this, Raul::Symbol("out"), 3, _polyphony,
+	                           PortType::AUDIO, uris.atom_Sound, zero);
+	_out_port->set_property(uris.lv2_name, bufs.forge().alloc("Out"));
+	_ports->at(3) = _out_port;
+}
+
+void
+CrossfadeNode::run(RunContext& context)
+{
+	const SampleCount offset = context.offset();
+	for (uint32_t v = 0; v < _polyphony; ++v) {
+		dsp::crossfade(_out_port->buffer(v)->samples() + offset,
+		               _a_port->buffer(v)->samples() + offset,
+		               _b_port->buffer(v)->samples() + offset,
+		               _fade_port->buffer(v)->value_at(0),
+		               context.nframes());
+	}
+}
+
+} // namespace internals
+} // namespace server
+} // namespace ingen
@@ -0,0 +1,63 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_INTERNALS_CROSSFADE_HPP
+#define INGEN_INTERNALS_CROSSFADE_HPP
+
+#include "InternalBlock.hpp"
+
+namespace ingen {
+namespace server {
+
+class InputPort;
+class OutputPort;
+class InternalPlugin;
+
+namespace internals {
+
+/** Audio crossfade block.
+ *
+ * Outputs a linear mix of two inputs, from only the first when the fade
+ * control is 0 to only the second when it is 1.
+ *
+ * \ingroup engine
+ */
+class CrossfadeNode : public InternalBlock
+{
+public:
+	CrossfadeNode(InternalPlugin*     plugin,
+	              BufferFactory&      bufs,
+	              const Raul::Symbol& symbol,
+	              bool                polyphonic,
+	              GraphImpl*          parent,
+	              SampleRate          srate);
+
+	void run(RunContext& context) override;
+
+	static InternalPlugin* internal_plugin(URIs& uris);
+
+private:
+	InputPort*  _a_port;
+	InputPort*  _b_port;
+	InputPort*  _fade_port;
+	OutputPort* _out_port;
+};
+
+} // namespace server
+} // namespace ingen
+} // namespace internals
+
+#endif // INGEN_INTERNALS_CROSSFADE_HPP
@@ -0,0 +1,87 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ingen/URIs.hpp"
+#include "raul/Array.hpp"
+#include "raul/Maid.hpp"
+
+#include "Buffer.hpp"
+#include "InputPort.hpp"
+#include "InternalPlugin.hpp"
+#include "OutputPort.hpp"
+#include "RunContext.hpp"
+#include "internals/Gain.hpp"
+#include "internals/dsp.hpp"
+
+namespace ingen {
+namespace server {
+namespace internals {
+
+InternalPlugin* GainNode::internal_plugin(URIs& uris) {
+	return new InternalPlugin(
+		uris, URI(NS_INTERNALS "Gain"), Raul::Symbol("gain"));
+}
+
+GainNode::GainNode(InternalPlugin*     plugin,
+                   BufferFactory&      bufs,
+                   const Raul::Symbol& symbol,
+                   bool                polyphonic,
+                   GraphImpl*          parent,
+                   SampleRate          srate)
+	: InternalBlock(plugin, symbol, polyphonic, parent, srate)
+{
+	const ingen::URIs& uris = bufs.uris();
+	_ports = bufs.maid().make_managed<Ports>(3);
+
+	const Atom zero = bufs.forge().make(0.0f);
+	const Atom one  = bufs.forge().make(1.0f);
+	const Atom max  = bufs.forge().make(4.0f);
+
+	_in_port = new InputPort(bufs, this, Raul::Symbol("in"), 0, _polyphony,
+	                         PortType::AUDIO, uris.atom_Sound, zero);
+	_in_port->set_property(uris.lv2_name, bufs.forge().alloc("In"));
+	_ports->at(0) = _in_port;
+
+	_gain_port = new InputPort(bufs, this, Raul::Symbol("gain"), 1, _polyphony,
+	                           PortType::CONTROL, uris.atom_Sequence, one);
+	_gain_port->set_property(uris.lv2_minimum, zero);
+	_gain_port->set_property(uris.lv2_maximum, max);
+	_gain_port->set_property(uris.lv2_name, bufs.forge().alloc("Gain"));
+	_gain_port->set_minimum(zero);
+	_gain_port->set_maximum(max);
+	_ports->at(1) = _gain_port;
+
+	_out_port = new OutputPort(bufs, this, Raul::Symbol("out"), 2, _polyphony,
+	                           PortType::AUDIO, uris.atom_Sound, zero);
+	_out_port->set_property(uris.lv2_name, bufs.forge().alloc("Out"));
+	_ports->at(2) = _out_port;
+}
+
+void
+GainNode::run(RunContext& context)
+{
+	const SampleCount offset = context.offset();
+	for (uint32_t v = 0; v < _polyphony; ++v) {
+		dsp::scale(_out_port->buffer(v)->samples() + offset,
+		           _in_port->buffer(v)->samples() + offset,
+		           _gain_port->buffer(v)->value_at(0),
+		           context.nframes());
+	}
+}
+
+} // namespace internals
+} // namespace server
+} // namespace ingen
@@ -0,0 +1,108 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string>
+
+#include "ingen/URIs.hpp"
+#include "raul/Array.hpp"
+#include "raul/Maid.hpp"
+
+#include "Buffer.hpp"
+#include "InputPort.hpp"
+#include "InternalPlugin.hpp"
+#include "OutputPort.hpp"
+#include "RunContext.hpp"
+#include "internals/Mixer.hpp"
+#include "internals/dsp.hpp"
+
+namespace ingen {
+namespace server {
+namespace internals {
+
+InternalPlugin* MixerNode::internal_plugin(URIs& uris) {
+	return new InternalPlugin(
+		uris, URI(NS_INTERNALS "Mixer"), Raul::Symbol("mixer"));
+}
+
+MixerNode::MixerNode(InternalPlugin*     plugin,
+                     BufferFactory&      bufs,
+                     const Raul::Symbol& symbol,
+                     bool                polyphonic,
+                     GraphImpl*          parent,
+                     SampleRate          srate)
+	: InternalBlock(plugin, symbol, polyphonic, parent, srate)
+{
+	const ingen::URIs& uris = bufs.uris();
+	_ports = bufs.maid().make_managed<Ports>(n_channels * 2 + 1);
+
+	const Atom zero = bufs.forge().make(0.0f);
+	const Atom one  = bufs.forge().make(1.0f);
+	const Atom max  = bufs.forge().make(4.0f);
+
+	for (uint32_t i = 0; i < n_channels; ++i) {
+		const std::string n = std::to_string(i + 1);
+
+		_in_ports[i] = new InputPort(
+			bufs, this, Raul::Symbol("in" + n), i, _polyphony,
+			PortType::AUDIO, uris.atom_Sound, zero);
+		_in_ports[i]->set_property(uris.lv2_name,
+		                           bufs.forge().alloc("In " + n));
+		_ports->at(i) = _in_ports[i];
+
+		_gain_ports[i] = new InputPort(
+			bufs, this, Raul::Symbol("gain" + n), n_channels + i, _polyphony,
+			PortType::CONTROL, uris.atom_Sequence, one);
+		_gain_ports[i]->set_property(uris.lv2_minimum, zero);
+		_gain_ports[i]->set_property(uris.lv2_maximum, max);
+		_gain_ports[i]->set_property(uris.lv2_name,
+		                             bufs.forge().alloc("Gain " + n));
+		_gain_ports[i]->set_minimum(zero);
+		_gain_ports[i]->set_maximum(max);
+		_ports->at(n_channels + i) = _gain_ports[i];
+	}
+
+	_out_port = new OutputPort(bufs, this, Raul::Symbol("out"), n_channels * 2,
+	                           _polyphony, PortType::AUDIO, uris.atom_Sound,
+	                           zero);
+	_out_port->set_property(uris.lv2_name, bufs.forge().alloc("Out"));
+	_ports->at(n_channels * 2) = _out_port;
+}
+
+void
+MixerNode::run(RunContext& context)
+{
+	const SampleCount offset  = context.offset();
+	const SampleCount nframes = context.nframes();
+	for (uint32_t v = 0; v < _polyphony; ++v) {
+		Sample* const out = _out_port->buffer(v)->samples() + offset;
+
+		dsp::scale(out,
+		           _in_ports[0]->buffer(v)->samples() + offset,
+		           _gain_ports[0]->buffer(v)->value_at(0),
+		           nframes);
+
+		for (uint32_t i = 1; i < n_channels; ++i) {
+			dsp::scale_add(out,
+			               _in_ports[i]->buffer(v)->samples() + offset,
+			               _gain_ports[i]->buffer(v)->value_at(0),
+			               nframes);
+		}
+	}
+}
+
+} // namespace internals
+} // namespace server
+} // namespace ingen
@@ -0,0 +1,63 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_INTERNALS_MIXER_HPP
+#define INGEN_INTERNALS_MIXER_HPP
+
+#include "InternalBlock.hpp"
+
+namespace ingen {
+namespace server {
+
+class InputPort;
+class OutputPort;
+class InternalPlugin;
+
+namespace internals {
+
+/** Audio mixer block.
+ *
+ * Sums several inputs, each with its own gain control, into one output.
+ *
+ * \ingroup engine
+ */
+class MixerNode : public InternalBlock
+{
+public:
+	static const uint32_t n_channels = 4;
+
+	MixerNode(InternalPlugin*     plugin,
+	          BufferFactory&      bufs,
+	          const Raul::Symbol& symbol,
+	          bool                polyphonic,
+	          GraphImpl*          parent,
+	          SampleRate          srate);
+
+	void run(RunContext& context) override;
+
+	static InternalPlugin* internal_plugin(URIs& uris);
+
+private:
+	InputPort*  _in_ports[n_channels];
+	InputPort*  _gain_ports[n_channels];
+	OutputPort* _out_port;
+};
+
+} // namespace server
+} // namespace ingen
+} // namespace internals
+
+#endif // INGEN_INTERNALS_MIXER_HPP
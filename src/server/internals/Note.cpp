@@ -14,6 +14,8 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 
 #include "ingen/URIs.hpp"
@@ -51,10 +53,17 @@ NoteNode::NoteNode(InternalPlugin*     plugin,
                    SampleRate          srate)
 	: InternalBlock(plugin, symbol, polyphonic, parent, srate)
 	, _voices(bufs.maid().make_managed<Voices>(_polyphony))
+	, _steal(Steal::OLDEST)
+	, _per_channel(false)
 	, _sustain(false)
 {
 	const ingen::URIs& uris = bufs.uris();
-	_ports = bufs.maid().make_managed<Ports>(8);
+	_ports = bufs.maid().make_managed<Ports>(10);
+
+	for (uint32_t c = 0; c < 16; ++c) {
+		_bends[c]     = 0.0f;
+		_pressures[c] = 0.0f;
+	}
 
 	const Atom zero = bufs.forge().make(0.0f);
 	const Atom one  = bufs.forge().make(1.0f);
@@ -123,8 +132,62 @@ NoteNode::NoteNode(InternalPlugin*     plugin,
 	_pressure_port->set_property(uris.lv2_minimum, zero);
 	_pressure_port->set_property(uris.lv2_maximum, one);
 	_ports->at(7) = _pressure_port;
+
+	_steal_port = new InputPort(bufs, this, Raul::Symbol("stealing"), 8, 1,
+	                            PortType::ATOM, uris.atom_Sequence, zero);
+	_steal_port->set_property(uris.atom_supports, bufs.uris().atom_Float);
+	_steal_port->set_property(uris.lv2_minimum, zero);
+	_steal_port->set_property(uris.lv2_maximum, bufs.forge().make(2.0f));
+	_steal_port->set_property(uris.lv2_portProperty, uris.lv2_integer);
+	_steal_port->set_property(uris.lv2_portProperty, uris.lv2_enumeration);
+	_steal_port->set_property(uris.lv2_name, bufs.forge().alloc("Stealing"));
+	_ports->at(8) = _steal_port;
+
+	_channels_port = new InputPort(bufs, this, Raul::Symbol("channels"), 9, 1,
+	                               PortType::ATOM, uris.atom_Sequence, zero);
+	_channels_port->set_property(uris.atom_supports, bufs.uris().atom_Float);
+	_channels_port->set_property(uris.lv2_portProperty, uris.lv2_toggled);
+	_channels_port->set_property(uris.lv2_name,
+	                             bufs.forge().alloc("Separate Channels"));
+	_ports->at(9) = _channels_port;
+
+	reset_lists();
+}
+
+template<typename Items>
+void
+NoteNode::list_push_back(List& list, Items& items, uint32_t i)
+{
+	items[i].prev = list.tail;
+	items[i].next = nil;
+	if (list.tail != nil) {
+		items[list.tail].next = i;
+	} else {
+		list.head = i;
+	}
+	list.tail = i;
 }
 
+template<typename Items>
+void
+NoteNode::list_remove(List& list, Items& items, uint32_t i)
+{
+	if (items[i].prev != nil) {
+		items[items[i].prev].next = items[i].next;
+	} else {
+		list.head = items[i].next;
+	}
+
+	if (items[i].next != nil) {
+		items[items[i].next].prev = items[i].prev;
+	} else {
+		list.tail = items[i].prev;
+	}
+
+	items[i].prev = items[i].next = nil;
+}
+
+
 bool
 NoteNode::prepare_poly(BufferFactory& bufs, uint32_t poly)
 {
@@ -151,18 +214,60 @@ NoteNode::apply_poly(RunContext& context, uint32_t poly)
 		return false;
 	}
 
+	/* Drop sounding voices past the new polyphony while they can still be
+	   indexed in the old array, so only remaining voices stay linked. */
+	Voices& old = *_voices;
+	for (uint32_t v = _sounding.head; v != nil;) {
+		const uint32_t next = old[v].next;
+		if (v >= _polyphony) {
+			if (old[v].state == Voice::State::ACTIVE) {
+				unassign_key(old[v].key);
+			}
+			old[v].state = Voice::State::FREE;
+			list_remove(_sounding, old, v);
+		}
+		v = next;
+	}
+
 	if (_prepared_voices) {
+		// Copy voices again, since they may have changed since prepare_poly()
+		const size_t n = std::min(_voices->size(), _prepared_voices->size());
+		for (size_t i = 0; i < n; ++i) {
+			(*_prepared_voices)[i] = (*_voices)[i];
+		}
 		assert(_polyphony <= _prepared_voices->size());
 		_voices = std::move(_prepared_voices);
 	}
 	assert(_polyphony <= _voices->size());
 
+	// Rebuild the free list, the sounding list only links remaining voices
+	Voices& voices = *_voices;
+	_free = List();
+	for (uint32_t v = 0; v < _polyphony; ++v) {
+		if (voices[v].state == Voice::State::FREE) {
+			list_push_back(_free, voices, v);
+		}
+	}
+
 	return true;
 }
 
 void
 NoteNode::run(RunContext& context)
 {
+	switch (lrintf(_steal_port->buffer(0)->value_at(0))) {
+	case 1:  _steal = Steal::LOWEST_VELOCITY; break;
+	case 2:  _steal = Steal::SAME_NOTE; break;
+	default: _steal = Steal::OLDEST; break;
+	}
+
+	const bool per_channel = _channels_port->buffer(0)->value_at(0) > 0.0f;
+	if (per_channel != _per_channel) {
+		// Keys are indexed differently, so start again with no notes
+		all_notes_off(context, context.start());
+		_per_channel = per_channel;
+	}
+
 	Buffer* const      midi_in = _midi_in_port->buffer(0).get();
 	LV2_Atom_Sequence* seq     = midi_in->get<LV2_Atom_Sequence>();
 	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
@@ -170,16 +275,17 @@ NoteNode::run(RunContext& context)
 		const FrameTime time = context.start() + (FrameTime)ev->time.frames;
 		if (ev->body.type == _midi_in_port->bufs().uris().midi_MidiEvent &&
 		    ev->body.size >= 3) {
+			const uint8_t chan = buf[0] & 0x0F;
 			switch (lv2_midi_message_type(buf)) {
 			case LV2_MIDI_MSG_NOTE_ON:
 				if (buf[2] == 0) {
-					note_off(context, buf[1], time);
+					note_off(context, chan, buf[1], time);
 				} else {
-					note_on(context, buf[1], buf[2], time);
+					note_on(context, chan, buf[1], buf[2], time);
 				}
 				break;
 			case LV2_MIDI_MSG_NOTE_OFF:
-				note_off(context, buf[1], time);
+				note_off(context, chan, buf[1], time);
 				break;
 			case LV2_MIDI_MSG_CONTROLLER:
 				switch (buf[1]) {
@@ -197,14 +303,14 @@ NoteNode::run(RunContext& context)
 				}
 				break;
 			case LV2_MIDI_MSG_BENDER:
-				bend(context, time, (((((uint16_t)buf[2] << 7) | buf[1]) - 8192.0f)
-				                     / 8192.0f));
+				bend(context, time, chan,
+				     (((((uint16_t)buf[2] << 7) | buf[1]) - 8192.0f) / 8192.0f));
 				break;
 			case LV2_MIDI_MSG_CHANNEL_PRESSURE:
-				channel_pressure(context, time, buf[1] / 127.0f);
+				channel_pressure(context, time, chan, buf[1] / 127.0f);
 				break;
 			case LV2_MIDI_MSG_NOTE_PRESSURE:
-				note_pressure(context, time, buf[1], buf[2] / 127.0f);
+				note_pressure(context, time, chan, buf[1], buf[2] / 127.0f);
 				break;
 			default:
 				break;
@@ -220,56 +326,120 @@ note_to_freq(uint8_t num)
 	return A4 * powf(2.0f, (float)(num - 57.0f) / 12.0f);
 }
 
+uint32_t
+NoteNode::allocate_voice(uint32_t key_num)
+{
+	Voices&  voices    = *_voices;
+	uint32_t voice_num = nil;
+
+	// Retrigger the voice that last played this key, even if it is released
+	if (_steal == Steal::SAME_NOTE) {
+		const uint32_t v = _keys[key_num].voice;
+		if (v < _polyphony && voices[v].key == key_num) {
+			voice_num = v;
+		}
+	}
+
+	// Otherwise, use the least recently freed voice
+	if (voice_num == nil) {
+		voice_num = _free.head;
+	}
+
+	// If there are no free voices, steal one
+	if (voice_num == nil) {
+		voice_num = _sounding.head;  // Oldest
+		if (_steal == Steal::LOWEST_VELOCITY) {
+			// Velocity order is not kept, so this one policy needs a scan
+			for (uint32_t v = voices[voice_num].next; v != nil; v = voices[v].next) {
+				if (voices[v].velocity < voices[voice_num].velocity) {
+					voice_num = v;
+				}
+			}
+		}
+	}
+
+	assert(voice_num < _polyphony);
+	list_remove(voices[voice_num].state == Voice::State::FREE ? _free : _sounding,
+	            voices,
+	            voice_num);
+
+	return voice_num;
+}
+
 void
-NoteNode::note_on(RunContext& context, uint8_t note_num, uint8_t velocity, FrameTime time)
+NoteNode::unassign_key(uint32_t key_num)
 {
-	assert(time >= context.start() && time <= context.end());
-	assert(note_num <= 127);
+	Key& key = _keys[key_num];
+	key.state = Key::State::ON_UNASSIGNED;
+
+	/* Insert in note-on order.  When stealing the oldest voice, a stolen key
+	   is newer than any already waiting, so this is usually at the end. */
+	uint32_t prev = _unassigned.tail;
+	while (prev != nil && _keys[prev].time > key.time) {
+		prev = _keys[prev].prev;
+	}
 
-	Key*     key       = &_keys[note_num];
-	Voice*   voice     = nullptr;
-	uint32_t voice_num = 0;
+	key.prev = prev;
+	key.next = (prev == nil) ? _unassigned.head : _keys[prev].next;
+	if (key.prev != nil) {
+		_keys[key.prev].next = key_num;
+	} else {
+		_unassigned.head = key_num;
+	}
+	if (key.next != nil) {
+		_keys[key.next].prev = key_num;
+	} else {
+		_unassigned.tail = key_num;
+	}
+}
 
-	if (key->state != Key::State::OFF) {
-		return;
+void
+NoteNode::reset_lists()
+{
+	for (uint32_t k = 0; k < n_keys; ++k) {
+		_keys[k].state = Key::State::OFF;
 	}
 
-	// Look for free voices
-	for (uint32_t i=0; i < _polyphony; ++i) {
-		if ((*_voices)[i].state == Voice::State::FREE) {
-			voice = &(*_voices)[i];
-			voice_num = i;
-			break;
-		}
+	_free       = List();
+	_sounding   = List();
+	_unassigned = List();
+	for (uint32_t v = 0; v < _polyphony; ++v) {
+		(*_voices)[v].state = Voice::State::FREE;
+		list_push_back(_free, *_voices, v);
 	}
+}
 
-	// If we didn't find a free one, steal the oldest
-	if (voice == nullptr) {
-		voice_num = 0;
-		voice = &(*_voices)[0];
-		FrameTime oldest_time = (*_voices)[0].time;
-		for (uint32_t i=1; i < _polyphony; ++i) {
-			if ((*_voices)[i].time < oldest_time) {
-				voice = &(*_voices)[i];
-				voice_num = i;
-				oldest_time = voice->time;
-			}
-		}
+void
+NoteNode::note_on(RunContext& context,
+                  uint8_t     channel,
+                  uint8_t     note_num,
+                  uint8_t     velocity,
+                  FrameTime   time)
+{
+	assert(time >= context.start() && time <= context.end());
+	assert(note_num <= 127);
+
+	const uint32_t key_num = key_index(channel, note_num);
+	Key* const     key     = &_keys[key_num];
+	if (key->state != Key::State::OFF) {
+		return;
 	}
-	assert(voice != nullptr);
-	assert(voice == &(*_voices)[voice_num]);
+
+	const uint32_t voice_num = allocate_voice(key_num);
+	Voice* const   voice     = &(*_voices)[voice_num];
 
 	// Update stolen key, if applicable
 	if (voice->state == Voice::State::ACTIVE) {
-		assert(_keys[voice->note].state == Key::State::ON_ASSIGNED);
-		assert(_keys[voice->note].voice == voice_num);
-		_keys[voice->note].state = Key::State::ON_UNASSIGNED;
+		assert(_keys[voice->key].state == Key::State::ON_ASSIGNED);
+		assert(_keys[voice->key].voice == voice_num);
+		unassign_key(voice->key);
 	}
 
 	// Store key information for later reallocation on note off
-	key->state = Key::State::ON_ASSIGNED;
-	key->voice = voice_num;
-	key->time  = time;
+	key->state    = Key::State::ON_ASSIGNED;
+	key->voice    = voice_num;
+	key->time     = time;
+	key->velocity = velocity;
 
 	// Check if we just triggered this voice at the same time
 	// (Double note-on at the same sample on the same voice)
@@ -277,12 +447,13 @@ NoteNode::note_on(RunContext& context, uint8_t note_num, uint8_t velocity, Frame
 	                             voice->time == time);
 
 	// Trigger voice
-	voice->state = Voice::State::ACTIVE;
-	voice->note  = note_num;
-	voice->time  = time;
-
-	assert(_keys[voice->note].state == Key::State::ON_ASSIGNED);
-	assert(_keys[voice->note].voice == voice_num);
+	voice->state    = Voice::State::ACTIVE;
+	voice->note     = note_num;
+	voice->channel  = channel;
+	voice->velocity = velocity;
+	voice->key      = key_num;
+	voice->time     = time;
+	list_push_back(_sounding, *_voices, voice_num);
 
 	_freq_port->set_voice_value(context, voice_num, time, note_to_freq(note_num));
 	_num_port->set_voice_value(context, voice_num, time, (float)note_num);
@@ -292,70 +463,81 @@ NoteNode::note_on(RunContext& context, uint8_t note_num, uint8_t velocity, Frame
 		_trig_port->set_voice_value(context, voice_num, time, 1.0f);
 		_trig_port->set_voice_value(context, voice_num, time + 1, 0.0f);
 	}
+	if (_per_channel) {
+		_bend_port->set_voice_value(context, voice_num, time, _bends[channel]);
+		_pressure_port->set_voice_value(context, voice_num, time, _pressures[channel]);
+	}
 
 	assert(key->state == Key::State::ON_ASSIGNED);
 	assert(voice->state == Voice::State::ACTIVE);
 	assert(key->voice == voice_num);
-	assert((*_voices)[key->voice].note == note_num);
+	assert((*_voices)[key->voice].key == key_num);
 }
 
 void
-NoteNode::note_off(RunContext& context, uint8_t note_num, FrameTime time)
+NoteNode::note_off(RunContext& context,
+                   uint8_t     channel,
+                   uint8_t     note_num,
+                   FrameTime   time)
 {
 	assert(time >= context.start() && time <= context.end());
 
-	Key* key = &_keys[note_num];
+	const uint32_t key_num = key_index(channel, note_num);
+	Key* const     key     = &_keys[key_num];
 
 	if (key->state == Key::State::ON_ASSIGNED) {
 		// Assigned key, turn off voice and key
 		if ((*_voices)[key->voice].state == Voice::State::ACTIVE) {
-			assert((*_voices)[key->voice].note == note_num);
+			assert((*_voices)[key->voice].key == key_num);
 			if ( ! _sustain) {
 				free_voice(context, key->voice, time);
 			} else {
 				(*_voices)[key->voice].state = Voice::State::HOLDING;
 			}
 		}
+	} else if (key->state == Key::State::ON_UNASSIGNED) {
+		list_remove(_unassigned, _keys, key_num);
 	}
 
 	key->state = Key::State::OFF;
 }
 
 void
-NoteNode::free_voice(RunContext& context, uint32_t voice, FrameTime time)
+NoteNode::free_voice(RunContext& context, uint32_t voice_num, FrameTime time)
 {
 	assert(time >= context.start() && time <= context.end());
 
-	// Find a key to reassign to the freed voice (the newest, if there is one)
-	Key*    replace_key     = nullptr;
-	uint8_t replace_key_num = 0;
-
-	for (uint8_t i = 0; i <= 127; ++i) {
-		if (_keys[i].state == Key::State::ON_UNASSIGNED) {
-			if (replace_key == nullptr || _keys[i].time > replace_key->time) {
-				replace_key = &_keys[i];
-				replace_key_num = i;
-			}
-		}
-	}
+	Voice& voice = (*_voices)[voice_num];
 
-	if (replace_key != nullptr) {  // Found a key to assign to freed voice
-		assert(&_keys[replace_key_num] == replace_key);
-		assert(replace_key->state == Key::State::ON_UNASSIGNED);
+	if (_unassigned.tail != nil) {
+		// Reassign the newest key that lost its voice to the freed voice
+		const uint32_t key_num  = _unassigned.tail;
+		const uint8_t  note_num = key_num % 128;
+		const uint8_t  channel  = key_num / 128;
+		Key&           key      = _keys[key_num];
+		list_remove(_unassigned, _keys, key_num);
 
 		// Change the freq but leave the gate high and don't retrigger
-		_freq_port->set_voice_value(context, voice, time, note_to_freq(replace_key_num));
-		_num_port->set_voice_value(context, voice, time, replace_key_num);
-
-		replace_key->state = Key::State::ON_ASSIGNED;
-		replace_key->voice = voice;
-		_keys[(*_voices)[voice].note].state = Key::State::ON_UNASSIGNED;
-		(*_voices)[voice].note = replace_key_num;
-		(*_voices)[voice].state = Voice::State::ACTIVE;
+		_freq_port->set_voice_value(context, voice_num, time, note_to_freq(note_num));
+		_num_port->set_voice_value(context, voice_num, time, note_num);
+		if (_per_channel) {
+			_bend_port->set_voice_value(context, voice_num, time, _bends[channel]);
+			_pressure_port->set_voice_value(context, voice_num, time, _pressures[channel]);
+		}
+
+		key.state      = Key::State::ON_ASSIGNED;
+		key.voice      = voice_num;
+		voice.note     = note_num;
+		voice.channel  = channel;
+		voice.velocity = key.velocity;
+		voice.key      = key_num;
+		voice.state    = Voice::State::ACTIVE;
 	} else {
 		// No new note for voice, deactivate (set gate low)
-		_gate_port->set_voice_value(context, voice, time, 0.0f);
-		(*_voices)[voice].state = Voice::State::FREE;
+		_gate_port->set_voice_value(context, voice_num, time, 0.0f);
+		voice.state = Voice::State::FREE;
+		list_remove(_sounding, *_voices, voice_num);
+		list_push_back(_free, *_voices, voice_num);
 	}
 }
 
@@ -364,12 +546,11 @@ NoteNode::all_notes_off(RunContext& context, FrameTime time)
 {
 	assert(time >= context.start() && time <= context.end());
 
-	// FIXME: set all keys to Key::OFF?
-
 	for (uint32_t i = 0; i < _polyphony; ++i) {
 		_gate_port->set_voice_value(context, i, time, 0.0f);
-		(*_voices)[i].state = Voice::State::FREE;
 	}
+
+	reset_lists();
 }
 
 void
@@ -385,34 +566,57 @@ NoteNode::sustain_off(RunContext& context, FrameTime time)
 
 	_sustain = false;
 
-	for (uint32_t i=0; i < _polyphony; ++i) {
-		if ((*_voices)[i].state == Voice::State::HOLDING) {
-			free_voice(context, i, time);
+	const Voices& voices = *_voices;
+	for (uint32_t v = _sounding.head; v != nil;) {
+		const uint32_t next = voices[v].next;
+		if (voices[v].state == Voice::State::HOLDING) {
+			free_voice(context, v, time);
 		}
+		v = next;
 	}
 }
 
 void
-NoteNode::bend(RunContext& context, FrameTime time, float amount)
+NoteNode::bend(RunContext& context, FrameTime time, uint8_t channel, float amount)
 {
-	_bend_port->set_control_value(context, time, amount);
+	_bends[channel] = amount;
+	if (!_per_channel) {
+		_bend_port->set_control_value(context, time, amount);
+		return;
+	}
+
+	const Voices& voices = *_voices;
+	for (uint32_t v = _sounding.head; v != nil; v = voices[v].next) {
+		if (voices[v].channel == channel) {
+			_bend_port->set_voice_value(context, v, time, amount);
+		}
+	}
 }
 
 void
-NoteNode::note_pressure(RunContext& context, FrameTime time, uint8_t note_num, float amount)
+NoteNode::note_pressure(RunContext& context, FrameTime time, uint8_t channel, uint8_t note_num, float amount)
 {
-	for (uint32_t i=0; i < _polyphony; ++i) {
-		if ((*_voices)[i].state != Voice::State::FREE && (*_voices)[i].note == note_num) {
-			_pressure_port->set_voice_value(context, i, time, amount);
-			return;
-		}
+	const Key& key = _keys[key_index(channel, note_num)];
+	if (key.state == Key::State::ON_ASSIGNED) {
+		_pressure_port->set_voice_value(context, key.voice, time, amount);
 	}
 }
 
 void
-NoteNode::channel_pressure(RunContext& context, FrameTime time, float amount)
+NoteNode::channel_pressure(RunContext& context, FrameTime time, uint8_t channel, float amount)
 {
-	_pressure_port->set_control_value(context, time, amount);
+	_pressures[channel] = amount;
+	if (!_per_channel) {
+		_pressure_port->set_control_value(context, time, amount);
+		return;
+	}
+
+	const Voices& voices = *_voices;
+	for (uint32_t v = _sounding.head; v != nil; v = voices[v].next) {
+		if (voices[v].channel == channel) {
+			_pressure_port->set_voice_value(context, v, time, amount);
+		}
+	}
 }
 
 } // namespace internals
@@ -17,6 +17,8 @@
 #ifndef INGEN_INTERNALS_NOTE_HPP
 #define INGEN_INTERNALS_NOTE_HPP
 
+#include <cstdint>
+
 #include "InternalBlock.hpp"
 #include "types.hpp"
 
@@ -33,11 +35,23 @@ namespace internals {
  *
  * For pitched instruments like keyboard, etc.
  *
+ * Free voices and sounding voices are kept in lists threaded through the
+ * voice array, so a voice can be allocated, stolen, or released in constant
+ * time regardless of polyphony.  Keys that lost their voice are kept in
+ * note-on order so the newest can take over a released voice immediately.
+ *
  * \ingroup engine
  */
 class NoteNode : public InternalBlock
 {
 public:
+	/** Policy for choosing a voice to use when no voice is free. */
+	enum class Steal {
+		OLDEST,           ///< Steal the least recently triggered voice
+		LOWEST_VELOCITY,  ///< Steal the quietest (softest played) voice
+		SAME_NOTE         ///< Retrigger the voice that last played the note
+	};
+
 	NoteNode(InternalPlugin*     plugin,
 	         BufferFactory&      bufs,
 	         const Raul::Symbol& symbol,
@@ -50,47 +64,109 @@ public:
 
 	void run(RunContext& context) override;
 
-	void note_on(RunContext& context, uint8_t note_num, uint8_t velocity, FrameTime time);
-	void note_off(RunContext& context, uint8_t note_num, FrameTime time);
+	void note_on(RunContext& context,
+	             uint8_t     channel,
+	             uint8_t     note_num,
+	             uint8_t     velocity,
+	             FrameTime   time);
+
+	void note_off(RunContext& context,
+	              uint8_t     channel,
+	              uint8_t     note_num,
+	              FrameTime   time);
+
 	void all_notes_off(RunContext& context, FrameTime time);
 
 	void sustain_on(RunContext& context, FrameTime time);
 	void sustain_off(RunContext& context, FrameTime time);
 
-	void bend(RunContext& context, FrameTime time, float amount);
-	void note_pressure(RunContext& context, FrameTime time, uint8_t note_num, float amount);
-	void channel_pressure(RunContext& context, FrameTime time, float amount);
+	void bend(RunContext& context, FrameTime time, uint8_t channel, float amount);
+	void note_pressure(RunContext& context, FrameTime time, uint8_t channel, uint8_t note_num, float amount);
+	void channel_pressure(RunContext& context, FrameTime time, uint8_t channel, float amount);
 
 	static InternalPlugin* internal_plugin(URIs& uris);
 
 private:
-	/** Key, one for each key on the keyboard */
+	/** Index that terminates a list. */
+	static const uint32_t nil = UINT32_MAX;
+
+	/** Number of keys, one for every note on every MIDI channel. */
+	static const uint32_t n_keys = 16 * 128;
+
+	/** Doubly linked list threaded through an array of keys or voices. */
+	struct List {
+		List() : head(nil), tail(nil) {}
+		uint32_t head;  ///< Index of the first (oldest) element
+		uint32_t tail;  ///< Index of the last (newest) element
+	};
+
+	/** Key, one for each key on the keyboard (on each channel) */
 	struct Key {
 		enum class State { OFF, ON_ASSIGNED, ON_UNASSIGNED };
-		Key() : state(State::OFF), voice(0), time(0) {}
-		State       state;
-		uint32_t    voice;
-		SampleCount time;
+		Key() : state(State::OFF), voice(0), time(0), velocity(0),
+		        prev(nil), next(nil) {}
+		State     state;
+		uint32_t  voice;
+		FrameTime time;
+		uint8_t   velocity;
+		uint32_t  prev;  ///< Previous in unassigned list
+		uint32_t  next;  ///< Next in unassigned list
 	};
 
 	/** Voice, one of these always exists for each voice */
 	struct Voice {
 		enum class State { FREE, ACTIVE, HOLDING };
-		Voice() : state(State::FREE), note(0), time(0) {}
-		State       state;
-		uint8_t     note;
-		SampleCount time;
+		Voice() : state(State::FREE), note(0), channel(0), velocity(0),
+		          key(nil), time(0), prev(nil), next(nil) {}
+		State     state;
+		uint8_t   note;
+		uint8_t   channel;
+		uint8_t   velocity;
+		uint32_t  key;   ///< Key this voice is (or was last) playing
+		FrameTime time;
+		uint32_t  prev;  ///< Previous in free or sounding list
+		uint32_t  next;  ///< Next in free or sounding list
 	};
 
-    typedef Raul::Array<Voice> Voices;
+	typedef Raul::Array<Voice> Voices;
+
+	/** Return the index of the key for a note on a channel. */
+	uint32_t key_index(uint8_t channel, uint8_t note_num) const {
+		return _per_channel ? channel * 128u + note_num : note_num;
+	}
+
+	/** Append element `i` of `items` to the end of `list`. */
+	template<typename Items>
+	static void list_push_back(List& list, Items& items, uint32_t i);
+
+	/** Remove element `i` of `items` from `list`. */
+	template<typename Items>
+	static void list_remove(List& list, Items& items, uint32_t i);
+
+	/** Take a voice for a key from its list, stealing one if necessary. */
+	uint32_t allocate_voice(uint32_t key_num);
+
+	/** Mark a sounding key as having lost its voice. */
+	void unassign_key(uint32_t key_num);
+
+	/** Free every voice and release every key. */
+	void reset_lists();
 
 	void free_voice(RunContext& context, uint32_t voice, FrameTime time);
 
 	MPtr<Voices> _voices;
 	MPtr<Voices> _prepared_voices;
 
-	Key  _keys[128];
-	bool _sustain;  ///< Whether or not hold pedal is depressed
+	List _free;        ///< Free voices, least recently freed first
+	List _sounding;    ///< Active and held voices, oldest first
+	List _unassigned;  ///< Keys held without a voice, oldest first
+
+	Key   _keys[n_keys];
+	float _bends[16];      ///< Bend of each channel, for per-channel mode
+	float _pressures[16];  ///< Pressure of each channel, for per-channel mode
+	Steal _steal;          ///< Voice stealing policy
+	bool  _per_channel;    ///< Whether each channel has separate keys
+	bool  _sustain;        ///< Whether or not hold pedal is depressed
 
 	InputPort*  _midi_in_port;
 	OutputPort* _freq_port;
@@ -100,6 +176,8 @@ private:
 	OutputPort* _trig_port;
 	OutputPort* _bend_port;
 	OutputPort* _pressure_port;
+	InputPort*  _steal_port;
+	InputPort*  _channels_port;
 };
 
 } // namespace server
@@ -0,0 +1,99 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "ingen/URIs.hpp"
+#include "raul/Array.hpp"
+#include "raul/Maid.hpp"
+
+#include "Buffer.hpp"
+#include "InputPort.hpp"
+#include "InternalPlugin.hpp"
+#include "OutputPort.hpp"
+#include "RunContext.hpp"
+#include "internals/Pan.hpp"
+#include "internals/dsp.hpp"
+
+namespace ingen {
+namespace server {
+namespace internals {
+
+InternalPlugin* PanNode::internal_plugin(URIs& uris) {
+	return new InternalPlugin(
+		uris, URI(NS_INTERNALS "Pan"), Raul::Symbol("pan"));
+}
+
+PanNode::PanNode(InternalPlugin*     plugin,
+                 BufferFactory&      bufs,
+                 const Raul::Symbol& symbol,
+                 bool                polyphonic,
+                 GraphImpl*          parent,
+                 SampleRate          srate)
+	: InternalBlock(plugin, symbol, polyphonic, parent, srate)
+{
+	const ingen::URIs& uris = bufs.uris();
+	_ports = bufs.maid().make_managed<Ports>(4);
+
+	const Atom zero = bufs.forge().make(0.0f);
+
+	_in_port = new InputPort(bufs, this, Raul::Symbol("in"), 0, _polyphony,
+	                         PortType::AUDIO, uris.atom_Sound, zero);
+	_in_port->set_property(uris.lv2_name, bufs.forge().alloc("In"));
+	_ports->at(0) = _in_port;
+
+	_pan_port = new InputPort(bufs, this, Raul::Symbol("pan"), 1, _polyphony,
+	                          PortType::CONTROL, uris.atom_Sequence, zero);
+	_pan_port->set_property(uris.lv2_minimum, bufs.forge().make(-1.0f));
+	_pan_port->set_property(uris.lv2_maximum, bufs.forge().make(1.0f));
+	_pan_port->set_property(uris.lv2_name, bufs.forge().alloc("Pan"));
+	_pan_port->set_minimum(bufs.forge().make(-1.0f));
+	_pan_port->set_maximum(bufs.forge().make(1.0f));
+	_ports->at(1) = _pan_port;
+
+	_left_port = new OutputPort(bufs, this, Raul::Symbol("left"), 2, _polyphony,
+	                            PortType::AUDIO, uris.atom_Sound, zero);
+	_left_port->set_property(uris.lv2_name, bufs.forge().alloc("Left"));
+	_ports->at(2) = _left_port;
+
+	_right_port = new OutputPort(bufs, this, Raul::Symbol("right"), 3, _polyphony,
+	                             PortType::AUDIO, uris.atom_Sound, zero);
+	_right_port->set_property(uris.lv2_name, bufs.forge().alloc("Right"));
+	_ports->at(3) = _right_port;
+}
+
+void
+PanNode::run(RunContext& context)
+{
+	const SampleCount offset = context.offset();
+	for (uint32_t v = 0; v < _polyphony; ++v) {
+		// Map pan from [-1, 1] to an angle in [0, pi/2] for constant power
+		const float pan   = std::min(std::max(_pan_port->buffer(v)->value_at(0),
+		                                      -1.0f), 1.0f);
+		const float angle = (pan + 1.0f) * float(M_PI) / 4.0f;
+
+		const Sample* const in = _in_port->buffer(v)->samples() + offset;
+		dsp::scale(_left_port->buffer(v)->samples() + offset,
+		           in, cosf(angle), context.nframes());
+		dsp::scale(_right_port->buffer(v)->samples() + offset,
+		           in, sinf(angle), context.nframes());
+	}
+}
+
+} // namespace internals
+} // namespace server
+} // namespace ingen
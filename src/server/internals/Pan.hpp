@@ -0,0 +1,62 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_INTERNALS_PAN_HPP
+#define INGEN_INTERNALS_PAN_HPP
+
+#include "InternalBlock.hpp"
+
+namespace ingen {
+namespace server {
+
+class InputPort;
+class OutputPort;
+class InternalPlugin;
+
+namespace internals {
+
+/** Audio panning block.
+ *
+ * Splits a mono input into left and right outputs with constant power.
+ *
+ * \ingroup engine
+ */
+class PanNode : public InternalBlock
+{
+public:
+	PanNode(InternalPlugin*     plugin,
+	        BufferFactory&      bufs,
+	        const Raul::Symbol& symbol,
+	        bool                polyphonic,
+	        GraphImpl*          parent,
+	        SampleRate          srate);
+
+	void run(RunContext& context) override;
+
+	static InternalPlugin* internal_plugin(URIs& uris);
+
+private:
+	InputPort*  _in_port;
+	InputPort*  _pan_port;
+	OutputPort* _left_port;
+	OutputPort* _right_port;
+};
+
+} // namespace server
+} // namespace ingen
+} // namespace internals
+
+#endif // INGEN_INTERNALS_PAN_HPP
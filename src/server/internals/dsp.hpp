@@ -0,0 +1,103 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGEN_INTERNALS_DSP_HPP
+#define INGEN_INTERNALS_DSP_HPP
+
+#ifdef __SSE__
+#    include <xmmintrin.h>
+#endif
+
+#include "types.hpp"
+
+namespace ingen {
+namespace server {
+namespace internals {
+
+/** Vector kernels for the audio utility blocks.
+ *
+ * Blocks run in chunks that start at arbitrary offsets when controls change
+ * mid-cycle, so these use unaligned loads and stores and handle any length.
+ */
+namespace dsp {
+
+/** Set `out` to `in` multiplied by `gain`. */
+inline void
+scale(Sample* __restrict       out,
+      const Sample* __restrict in,
+      const Sample             gain,
+      const SampleCount        n)
+{
+	SampleCount i = 0;
+#ifdef __SSE__
+	const __m128 vgain = _mm_set1_ps(gain);
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(in + i), vgain));
+	}
+#endif
+	for (; i < n; ++i) {
+		out[i] = in[i] * gain;
+	}
+}
+
+/** Add `in` multiplied by `gain` to `out`. */
+inline void
+scale_add(Sample* __restrict       out,
+          const Sample* __restrict in,
+          const Sample             gain,
+          const SampleCount        n)
+{
+	SampleCount i = 0;
+#ifdef __SSE__
+	const __m128 vgain = _mm_set1_ps(gain);
+	for (; i + 4 <= n; i += 4) {
+		const __m128 vin = _mm_mul_ps(_mm_loadu_ps(in + i), vgain);
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), vin));
+	}
+#endif
+	for (; i < n; ++i) {
+		out[i] += in[i] * gain;
+	}
+}
+
+/** Set `out` to `a` faded towards `b` by `mix` between 0 and 1. */
+inline void
+crossfade(Sample* __restrict       out,
+          const Sample* __restrict a,
+          const Sample* __restrict b,
+          const Sample             mix,
+          const SampleCount        n)
+{
+	SampleCount i = 0;
+#ifdef __SSE__
+	const __m128 vmix = _mm_set1_ps(mix);
+	for (; i + 4 <= n; i += 4) {
+		const __m128 va = _mm_loadu_ps(a + i);
+		const __m128 vd = _mm_sub_ps(_mm_loadu_ps(b + i), va);
+		_mm_storeu_ps(out + i, _mm_add_ps(va, _mm_mul_ps(vd, vmix)));
+	}
+#endif
+	for (; i < n; ++i) {
+		out[i] = a[i] + (b[i] - a[i]) * mix;
+	}
+}
+
+} // namespace dsp
+} // namespace internals
+} // namespace server
+} // namespace ingen
+
+#endif // INGEN_INTERNALS_DSP_HPP
@@ -0,0 +1,200 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "raul/Path.hpp"
+#include "raul/Symbol.hpp"
+
+#include "ingen/Clock.hpp"
+#include "ingen/Configuration.hpp"
+#include "ingen/EngineBase.hpp"
+#include "ingen/Forge.hpp"
+#include "ingen/Interface.hpp"
+#include "ingen/Parser.hpp"
+#include "ingen/QueuedInterface.hpp"
+#include "ingen/World.hpp"
+#include "ingen/runtime_paths.hpp"
+#include "ingen/types.hpp"
+
+#include "TestClient.hpp"
+#include "ingen_config.h"
+
+using namespace std;
+using namespace ingen;
+
+/* Count heap allocations by interposing the C allocator, which operator new
+   also uses.  This only works with glibc, elsewhere the counts are zero. */
+
+static std::atomic<uint64_t> n_allocs(0);
+static std::atomic<uint64_t> n_bytes(0);
+
+#ifdef __GLIBC__
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void*
+malloc(size_t size)
+{
+	++n_allocs;
+	n_bytes += size;
+	return __libc_malloc(size);
+}
+
+void*
+calloc(size_t n, size_t size)
+{
+	++n_allocs;
+	n_bytes += n * size;
+	return __libc_calloc(n, size);
+}
+
+void*
+realloc(void* ptr, size_t size)
+{
+	++n_allocs;
+	n_bytes += size;
+	return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+#endif
+
+World* world = nullptr;
+
+static void
+ingen_try(bool cond, const char* msg)
+{
+	if (!cond) {
+		cerr << "ingen: Error: " << msg << endl;
+		delete world;
+		exit(EXIT_FAILURE);
+	}
+}
+
+static std::string
+real_path(const char* path)
+{
+	char* const c_real_path = realpath(path, nullptr);
+	const std::string result(c_real_path ? c_real_path : "");
+	free(c_real_path);
+	return result;
+}
+
+int
+main(int argc, char** argv)
+{
+	set_bundle_path_from_code((void*)&ingen_try);
+
+	// Create world
+	try {
+		world = new World(nullptr, nullptr, nullptr);
+		world->conf().add(
+			"output", "output", 'O', "File to write benchmark output",
+			ingen::Configuration::SESSION, world->forge().String, Atom());
+		world->conf().add(
+			"copies", "copies", 0, "Number of copies of the graph to load",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(16));
+		world->load_configuration(argc, argv);
+	} catch (std::exception& e) {
+		cout << "ingen: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+
+	// Get mandatory command line arguments
+	const Atom& load = world->conf().option("load");
+	const Atom& out  = world->conf().option("output");
+	if (!load.is_valid() || !out.is_valid()) {
+		cerr << "Usage: ingen_alloc_bench [--copies N] "
+		     << "--load GRAPH --output OUT_FILE" << endl;
+		return EXIT_FAILURE;
+	}
+
+	// Get graph and output file options
+	const std::string graph    = real_path((const char*)load.get_body());
+	const std::string out_file = (const char*)out.get_body();
+	const int32_t     n_copies = world->conf().option("copies").get<int32_t>();
+	if (graph.empty()) {
+		cerr << "error: graph '" << ((const char*)load.get_body())
+		     << "' does not exist" << endl;
+		return EXIT_FAILURE;
+	}
+
+	// Load modules
+	ingen_try(world->load_module("server"),
+	          "Unable to load server module");
+
+	// Initialise engine
+	ingen_try(bool(world->engine()),
+	          "Unable to create engine");
+	world->engine()->init(48000.0, 4096, 4096);
+	world->engine()->activate();
+
+	// Register a queued client, like the GUI, so updates are copied around
+	SPtr<TestClient>      client(new TestClient(world->log()));
+	SPtr<QueuedInterface> queue(new QueuedInterface(client));
+	world->interface()->set_respondee(queue);
+	world->engine()->register_client(queue);
+
+	// Load the graph several times to make a large graph
+	ingen::Clock   clock;
+	const uint64_t allocs_start = n_allocs;
+	const uint64_t bytes_start  = n_bytes;
+	const uint64_t t_start      = clock.now_microseconds();
+	for (int32_t i = 0; i < n_copies; ++i) {
+		const Raul::Symbol symbol("copy" + std::to_string(i));
+		if (!world->parser()->parse_file(world,
+		                                 world->interface().get(),
+		                                 graph,
+		                                 Raul::Path("/"),
+		                                 symbol)) {
+			cerr << "error: failed to load graph " << graph << endl;
+			return EXIT_FAILURE;
+		}
+		world->engine()->flush_events(std::chrono::milliseconds(1));
+		queue->emit();
+	}
+	const uint64_t t_end  = clock.now_microseconds();
+	const uint64_t allocs = n_allocs - allocs_start;
+	const uint64_t bytes  = n_bytes - bytes_start;
+
+	// Write log output
+	FILE* log = fopen(out_file.c_str(), "a");
+	if (ftell(log) == 0) {
+		fprintf(log, "# n_copies\tload_time\tn_allocs\tn_bytes\n");
+	}
+	fprintf(log, "%d\t%f\t%llu\t%llu\n",
+	        n_copies,
+	        (t_end - t_start) / 1000000.0,
+	        (unsigned long long)allocs,
+	        (unsigned long long)bytes);
+	fclose(log);
+
+	// Shut down
+	world->engine()->unregister_client(queue);
+	world->engine()->deactivate();
+
+	delete world;
+	return EXIT_SUCCESS;
+}
@@ -1,6 +1,6 @@
 /*
   This file is part of Ingen.
-  Copyright 2007-2017 David Robillard <http://drobilla.net/>
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
 
   Ingen is free software: you can redistribute it and/or modify it under the
   terms of the GNU Affero General Public License as published by the Free
@@ -14,27 +14,42 @@
   along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include "ingen_config.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <sstream>
 #include <string>
-#include <thread>
+#include <vector>
+
+#include "raul/Path.hpp"
+#include "raul/Symbol.hpp"
 
-#include "ingen/Clock.hpp"
 #include "ingen/Configuration.hpp"
 #include "ingen/EngineBase.hpp"
 #include "ingen/Forge.hpp"
 #include "ingen/Interface.hpp"
 #include "ingen/Parser.hpp"
+#include "ingen/Properties.hpp"
+#include "ingen/URIs.hpp"
 #include "ingen/World.hpp"
+#include "ingen/paths.hpp"
 #include "ingen/runtime_paths.hpp"
 #include "ingen/types.hpp"
 
-#include "TestClient.hpp"
-#include "ingen_config.h"
-
 using namespace std;
 using namespace ingen;
 
+#define NS_INTERNALS "http://drobilla.net/ns/ingen-internals#"
+
 World* world = nullptr;
 
 static void
@@ -56,85 +71,532 @@ real_path(const char* path)
 	return result;
 }
 
+/** Split a comma-separated list. */
+static std::vector<std::string>
+split(const std::string& str)
+{
+	std::vector<std::string> result;
+	std::istringstream       ss(str);
+	for (std::string item; std::getline(ss, item, ',');) {
+		if (!item.empty()) {
+			result.push_back(item);
+		}
+	}
+	return result;
+}
+
+/** Split a comma-separated list of positive integers. */
+static std::vector<int32_t>
+split_ints(const std::string& str)
+{
+	std::vector<int32_t> result;
+	for (const auto& item : split(str)) {
+		const int32_t i = atoi(item.c_str());
+		ingen_try(i > 0, "Invalid number in list");
+		result.push_back(i);
+	}
+	return result;
+}
+
+/** Create a world with the benchmark options, from the command line. */
+static World*
+new_world(int argc, char** argv)
+{
+	World* const w     = new World(nullptr, nullptr, nullptr);
+	Forge&       forge = w->forge();
+
+	w->conf().add(
+		"output", "output", 'O', "File to write benchmark JSON to",
+		ingen::Configuration::SESSION, forge.String, Atom());
+	w->conf().add(
+		"graphs", "graphs", 0,
+		"Graphs to run (chain, fanout, tree, diamond, nested, poly)",
+		ingen::Configuration::SESSION, forge.String,
+		forge.alloc("chain,fanout,tree,diamond,nested,poly"));
+	w->conf().add(
+		"size", "size", 0, "Number of blocks in generated graphs",
+		ingen::Configuration::SESSION, forge.Int, forge.make(64));
+	w->conf().add(
+		"voices", "voices", 0, "Polyphony of the poly graph",
+		ingen::Configuration::SESSION, forge.Int, forge.make(16));
+	w->conf().add(
+		"thread-counts", "thread-counts", 0, "Numbers of threads to run with",
+		ingen::Configuration::SESSION, forge.String, forge.alloc("1,2,4"));
+	w->conf().add(
+		"block-lengths", "block-lengths", 0, "Block lengths to run with",
+		ingen::Configuration::SESSION, forge.String,
+		forge.alloc("32,64,128,256,512,1024,2048,4096"));
+	w->conf().add(
+		"frames", "frames", 0, "Number of frames to run each graph for",
+		ingen::Configuration::SESSION, forge.Int, forge.make(1 << 18));
+	w->conf().add(
+		"baseline", "baseline", 0, "Results to compare against",
+		ingen::Configuration::SESSION, forge.String, Atom());
+	w->conf().add(
+		"tolerance", "tolerance", 0,
+		"Percentage slower than the baseline that is a regression",
+		ingen::Configuration::SESSION, forge.Int, forge.make(10));
+	w->load_configuration(argc, argv);
+	return w;
+}
+
+/** Builder of synthetic graphs from internal blocks. */
+class GraphBuilder
+{
+public:
+	GraphBuilder(Interface& iface, const URIs& uris, Forge& forge)
+		: _iface(iface), _uris(uris), _forge(forge)
+	{}
+
+	/** Create an audio delay block, and return its path. */
+	Raul::Path block(const Raul::Path& parent,
+	                 const std::string& symbol,
+	                 bool               polyphonic = false) {
+		const Raul::Path path(parent.child(Raul::Symbol(symbol)));
+		_iface.put(path_to_uri(path),
+		           {{_uris.rdf_type, _uris.ingen_Block},
+		            {_uris.lv2_prototype,
+		             _forge.make_urid(URI(NS_INTERNALS "BlockDelay"))},
+		            {_uris.ingen_polyphonic, _forge.make(polyphonic)}});
+		return path;
+	}
+
+	/** Create a graph with an audio input and output. */
+	Raul::Path graph(const Raul::Path& parent,
+	                 const std::string& symbol,
+	                 int32_t            polyphony = 1) {
+		const Raul::Path path(parent.child(Raul::Symbol(symbol)));
+		_iface.put(path_to_uri(path),
+		           {{_uris.rdf_type, _uris.ingen_Graph},
+		            {_uris.ingen_polyphony, _forge.make(polyphony)}});
+		port(path.child(Raul::Symbol("in")), false, 0);
+		port(path.child(Raul::Symbol("out")), true, 1);
+		return path;
+	}
+
+	/** Connect the output of `tail` to the input of `head`. */
+	void connect(const Raul::Path& tail, const Raul::Path& head) {
+		_iface.connect(tail.child(Raul::Symbol("out")),
+		               head.child(Raul::Symbol("in")));
+	}
+
+	/** Connect the input of `graph` to the input of `head` inside it. */
+	void connect_from_input(const Raul::Path& graph, const Raul::Path& head) {
+		_iface.connect(graph.child(Raul::Symbol("in")),
+		               head.child(Raul::Symbol("in")));
+	}
+
+	/** Connect the output of `tail` to the output of `graph` it is inside. */
+	void connect_to_output(const Raul::Path& tail, const Raul::Path& graph) {
+		_iface.connect(tail.child(Raul::Symbol("out")),
+		               graph.child(Raul::Symbol("out")));
+	}
+
+private:
+	void port(const Raul::Path& path, bool output, int32_t index) {
+		_iface.put(path_to_uri(path),
+		           {{_uris.rdf_type,
+		             output ? _uris.lv2_OutputPort : _uris.lv2_InputPort},
+		            {_uris.rdf_type, _uris.lv2_AudioPort},
+		            {_uris.lv2_index, _forge.make(index)}});
+	}
+
+	Interface&  _iface;
+	const URIs& _uris;
+	Forge&      _forge;
+};
+
+/** A chain of blocks that must run one after another. */
+static void
+build_chain(GraphBuilder& b, const Raul::Path& g, int32_t size, int32_t)
+{
+	Raul::Path prev = b.block(g, "b0");
+	for (int32_t i = 1; i < size; ++i) {
+		const Raul::Path block = b.block(g, "b" + std::to_string(i));
+		b.connect(prev, block);
+		prev = block;
+	}
+}
+
+/** A source feeding many blocks that all feed a single sink. */
+static void
+build_fanout(GraphBuilder& b, const Raul::Path& g, int32_t size, int32_t)
+{
+	const Raul::Path source = b.block(g, "source");
+	const Raul::Path sink   = b.block(g, "sink");
+	for (int32_t i = 0; i < std::max(size - 2, 1); ++i) {
+		const Raul::Path block = b.block(g, "b" + std::to_string(i));
+		b.connect(source, block);
+		b.connect(block, sink);
+	}
+}
+
+/** A binary tree of blocks that reduces many leaves to a single root. */
+static void
+build_tree(GraphBuilder& b, const Raul::Path& g, int32_t size, int32_t)
+{
+	std::vector<Raul::Path> level;
+	int32_t                 n = 0;
+	for (int32_t i = 0; i < std::max((size + 1) / 2, 1); ++i) {
+		level.push_back(b.block(g, "b" + std::to_string(n++)));
+	}
+
+	while (level.size() > 1) {
+		std::vector<Raul::Path> parents;
+		for (size_t i = 0; i < level.size(); i += 2) {
+			const Raul::Path parent = b.block(g, "b" + std::to_string(n++));
+			b.connect(level[i], parent);
+			if (i + 1 < level.size()) {
+				b.connect(level[i + 1], parent);
+			}
+			parents.push_back(parent);
+		}
+		level = parents;
+	}
+}
+
+/** A sequence of diamonds, each splitting into two blocks then joining. */
+static void
+build_diamond(GraphBuilder& b, const Raul::Path& g, int32_t size, int32_t)
+{
+	Raul::Path top = b.block(g, "top");
+	for (int32_t i = 0; i < std::max((size - 1) / 3, 1); ++i) {
+		const std::string n      = std::to_string(i);
+		const Raul::Path  left   = b.block(g, "l" + n);
+		const Raul::Path  right  = b.block(g, "r" + n);
+		const Raul::Path  bottom = b.block(g, "j" + n);
+		b.connect(top, left);
+		b.connect(top, right);
+		b.connect(left, bottom);
+		b.connect(right, bottom);
+		top = bottom;
+	}
+}
+
+/** Subgraphs nested `size` deep, each with a block before the next. */
+static void
+build_nested(GraphBuilder& b, const Raul::Path& g, int32_t size, int32_t)
+{
+	const Raul::Path first = b.block(g, "b");
+	Raul::Path       outer = b.graph(g, "g");
+	b.connect(first, outer);
+	for (int32_t i = 1; i < size; ++i) {
+		const Raul::Path block = b.block(outer, "b");
+		const Raul::Path inner = b.graph(outer, "g");
+		b.connect_from_input(outer, block);
+		b.connect(block, inner);
+		b.connect_to_output(inner, outer);
+		outer = inner;
+	}
+}
+
+/** A chain of polyphonic blocks in a graph with many voices. */
+static void
+build_poly(GraphBuilder& b, const Raul::Path& g, int32_t size, int32_t voices)
+{
+	const Raul::Path poly = b.graph(g, "voices", voices);
+	Raul::Path       prev = b.block(poly, "b0", true);
+	b.connect_from_input(poly, prev);
+	for (int32_t i = 1; i < size; ++i) {
+		const Raul::Path block = b.block(poly, "b" + std::to_string(i), true);
+		b.connect(prev, block);
+		prev = block;
+	}
+	b.connect_to_output(prev, poly);
+}
+
+typedef std::function<void(GraphBuilder&, const Raul::Path&, int32_t, int32_t)>
+	Generator;
+
+/** The result of running one graph in one configuration. */
+struct Result {
+	std::string graph;
+	int32_t     threads;
+	int32_t     block_length;
+	size_t      cycles;
+	double      mean;  ///< Mean cycle time in microseconds
+	double      p50;   ///< Median cycle time in microseconds
+	double      p90;
+	double      p99;
+	double      max;
+};
+
+/** Return the `percent` percentile of sorted `times`. */
+static double
+percentile(const std::vector<double>& times, unsigned percent)
+{
+	const size_t rank = (times.size() * percent + 99) / 100;
+	return times[std::min(std::max(rank, size_t(1)), times.size()) - 1];
+}
+
+/** Run the engine for `n_cycles`, and return the sorted cycle times. */
+static std::vector<double>
+run_cycles(EngineBase& engine, uint32_t block_length, size_t n_cycles)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	std::vector<double> times;
+	times.reserve(n_cycles);
+	for (size_t i = 0; i < n_cycles; ++i) {
+		const Clock::time_point start = Clock::now();
+		engine.advance(block_length);
+		engine.run(block_length);
+		const Clock::time_point end = Clock::now();
+		times.push_back(
+			std::chrono::duration<double, std::micro>(end - start).count());
+	}
+
+	std::sort(times.begin(), times.end());
+	return times;
+}
+
+static void
+pin_main_thread()
+{
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(0, &cpus);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) {
+		cerr << "warning: Failed to pin main thread" << endl;
+	}
+#else
+	cerr << "warning: Pinning threads is not supported" << endl;
+#endif
+}
+
+/** Read results written by a previous run, keyed by configuration. */
+static std::map<std::string, Result>
+read_baseline(const std::string& path)
+{
+	std::map<std::string, Result> results;
+
+	FILE* in = fopen(path.c_str(), "r");
+	ingen_try(in, "Failed to open baseline");
+
+	char line[1024];
+	while (fgets(line, sizeof(line), in)) {
+		char   graph[256];
+		Result r;
+		if (sscanf(line,
+		           " {\"graph\": \"%255[^\"]\", \"threads\": %d,"
+		           " \"block_length\": %d, \"cycles\": %zu,"
+		           " \"mean\": %lf, \"p50\": %lf, \"p90\": %lf,"
+		           " \"p99\": %lf, \"max\": %lf",
+		           graph, &r.threads, &r.block_length, &r.cycles,
+		           &r.mean, &r.p50, &r.p90, &r.p99, &r.max) == 9) {
+			r.graph = graph;
+			results[r.graph + "/" + std::to_string(r.threads) + "/" +
+			        std::to_string(r.block_length)] = r;
+		}
+	}
+
+	fclose(in);
+	return results;
+}
+
 int
 main(int argc, char** argv)
 {
 	set_bundle_path_from_code((void*)&ingen_try);
 
-	// Create world
+	// Create world to read options
 	try {
-		world = new World(nullptr, nullptr, nullptr);
-		world->conf().add(
-			"output", "output", 'O', "File to write benchmark output",
-			ingen::Configuration::SESSION, world->forge().String, Atom());
-		world->load_configuration(argc, argv);
+		world = new_world(argc, argv);
 	} catch (std::exception& e) {
 		cout << "ingen: " << e.what() << endl;
 		return EXIT_FAILURE;
 	}
 
 	// Get mandatory command line arguments
-	const Atom& load = world->conf().option("load");
-	const Atom& out  = world->conf().option("output");
-	if (!load.is_valid() || !out.is_valid()) {
-		cerr << "Usage: ingen_bench --load START_GRAPH --output OUT_FILE" << endl;
+	const Configuration& conf = world->conf();
+	const Atom&          load = conf.option("load");
+	const Atom&          out  = conf.option("output");
+	if (!out.is_valid()) {
+		cerr << "Usage: ingen_bench [--load GRAPH] [--graphs NAMES]"
+		     << " [--size N] [--voices N] [--thread-counts N,...]"
+		     << " [--block-lengths N,...] [--frames N] [--pin-threads]"
+		     << " [--baseline OLD_FILE] [--tolerance PERCENT]"
+		     << " --output OUT_FILE" << endl;
 		return EXIT_FAILURE;
 	}
 
-	// Get start graph and output file options
-	const std::string start_graph = real_path((const char*)load.get_body());
+	// Get graph and output file options
+	const std::string start_graph = (load.is_valid()
+	                                 ? real_path((const char*)load.get_body())
+	                                 : std::string());
 	const std::string out_file    = (const char*)out.get_body();
-	if (start_graph.empty()) {
+	if (load.is_valid() && start_graph.empty()) {
 		cerr << "error: initial graph '"
 		     << ((const char*)load.get_body())
 		     << "' does not exist" << endl;
 		return EXIT_FAILURE;
 	}
 
-	// Load modules
-	ingen_try(world->load_module("server"),
-	          "Unable to load server module");
+	const std::map<std::string, Generator> generators = {
+		{"chain",   build_chain},
+		{"fanout",  build_fanout},
+		{"tree",    build_tree},
+		{"diamond", build_diamond},
+		{"nested",  build_nested},
+		{"poly",    build_poly}};
 
-	// Initialise engine
-	ingen_try(bool(world->engine()),
-	          "Unable to create engine");
-	world->engine()->init(48000.0, 4096, 4096);
-	world->engine()->activate();
+	const std::vector<std::string> graphs =
+		load.is_valid() ? std::vector<std::string>{"load"}
+		                : split(conf.option("graphs").ptr<char>());
+	for (const auto& g : graphs) {
+		ingen_try(g == "load" || generators.count(g), "Unknown graph");
+	}
 
-	// Load graph
-	if (!world->parser()->parse_file(world, world->interface().get(), start_graph)) {
-		cerr << "error: failed to load initial graph " << start_graph << endl;
-		return EXIT_FAILURE;
+	const std::vector<int32_t> thread_counts =
+		split_ints(conf.option("thread-counts").ptr<char>());
+	const std::vector<int32_t> block_lengths =
+		split_ints(conf.option("block-lengths").ptr<char>());
+
+	const int32_t size     = conf.option("size").get<int32_t>();
+	const int32_t voices   = conf.option("voices").get<int32_t>();
+	const int32_t n_frames = conf.option("frames").get<int32_t>();
+	const bool    pin      = conf.option("pin-threads").get<int32_t>();
+	ingen_try(size > 0 && voices > 0 && n_frames > 0, "Invalid graph size");
+
+	// Copy remaining options, the world is replaced for every configuration
+	const Atom&       baseline_opt  = conf.option("baseline");
+	const std::string baseline_file = (baseline_opt.is_valid()
+	                                   ? baseline_opt.ptr<char>()
+	                                   : std::string());
+	const int32_t     tolerance     = conf.option("tolerance").get<int32_t>();
+
+	if (pin) {
+		pin_main_thread();
 	}
-	world->engine()->flush_events(std::chrono::milliseconds(20));
-
-	// Run benchmark
-	// TODO: Set up real-time scheduling for this and worker threads
-	ingen::Clock   clock;
-	const uint32_t n_test_frames = 1 << 20;
-	const uint32_t block_length  = 4096;
-	const uint64_t t_start       = clock.now_microseconds();
-	for (uint32_t i = 0; i < n_test_frames; i += block_length) {
-		world->engine()->advance(block_length);
-		world->engine()->run(block_length);
-		//world->engine()->main_iteration();
-	}
-	const uint64_t t_end = clock.now_microseconds();
-
-	// Write log output
-	FILE* log = fopen(out_file.c_str(), "a");
-	if (ftell(log) == 0) {
-		fprintf(log, "# n_threads\trun_time\treal_time\n");
-	}
-	fprintf(log, "%u\t%f\t%f\n",
-	        world->conf().option("threads").get<int32_t>(),
-	        (t_end - t_start) / 1000000.0,
-	        (n_test_frames / 48000.0));
+
+	// Run every graph in a fresh engine for each configuration
+	std::vector<Result> results;
+	for (const int32_t n_threads : thread_counts) {
+		for (const int32_t block_length : block_lengths) {
+			delete world;
+			world = new_world(argc, argv);
+			world->conf().set("threads", world->forge().make(n_threads));
+
+			// Load modules
+			ingen_try(world->load_module("server"),
+			          "Unable to load server module");
+
+			// Initialise engine
+			ingen_try(bool(world->engine()),
+			          "Unable to create engine");
+			world->engine()->init(48000.0, block_length, 4096);
+			world->engine()->activate();
+
+			SPtr<Interface>  iface = world->interface();
+			GraphBuilder     builder(*iface, world->uris(), world->forge());
+			const Raul::Path bench("/bench");
+			const size_t     n_cycles =
+				std::max(size_t(n_frames / block_length), size_t(16));
+
+			for (const auto& name : graphs) {
+				// Create graph
+				if (name == "load") {
+					if (!world->parser()->parse_file(
+						    world, iface.get(), start_graph,
+						    Raul::Path("/"), Raul::Symbol("bench"))) {
+						cerr << "error: failed to load graph "
+						     << start_graph << endl;
+						return EXIT_FAILURE;
+					}
+				} else {
+					iface->put(path_to_uri(bench),
+					           {{world->uris().rdf_type,
+					             world->uris().ingen_Graph}});
+					generators.at(name)(builder, bench, size, voices);
+				}
+				world->engine()->flush_events(std::chrono::milliseconds(20));
+
+				// Warm up, then run the graph
+				run_cycles(*world->engine(), block_length, 16);
+				const std::vector<double> times =
+					run_cycles(*world->engine(), block_length, n_cycles);
+
+				double total = 0.0;
+				for (const double t : times) {
+					total += t;
+				}
+
+				results.push_back({name,
+				                   n_threads,
+				                   block_length,
+				                   times.size(),
+				                   total / times.size(),
+				                   percentile(times, 50),
+				                   percentile(times, 90),
+				                   percentile(times, 99),
+				                   times.back()});
+
+				// Delete graph
+				iface->del(path_to_uri(bench));
+				world->engine()->flush_events(std::chrono::milliseconds(20));
+			}
+
+			// Shut down
+			world->engine()->deactivate();
+		}
+	}
+
+	// Compare with results from the same graph on one thread if possible
+	auto speedup = [&results](const Result& r) {
+		for (const auto& s : results) {
+			if (s.graph == r.graph && s.block_length == r.block_length &&
+			    s.threads == 1) {
+				return s.mean / r.mean;
+			}
+		}
+		return 0.0;
+	};
+
+	// Write results, one per line so they are easy to read back as a baseline
+	FILE* log = fopen(out_file.c_str(), "w");
+	ingen_try(log, "Failed to open output file");
+	fprintf(log, "{\"sample_rate\": 48000, \"size\": %d, \"voices\": %d,"
+	        " \"pin_threads\": %s, \"results\": [\n",
+	        size, voices, pin ? "true" : "false");
+	for (size_t i = 0; i < results.size(); ++i) {
+		const Result& r = results[i];
+		const double  s = speedup(r);
+		fprintf(log,
+		        "  {\"graph\": \"%s\", \"threads\": %d, \"block_length\": %d,"
+		        " \"cycles\": %zu, \"mean\": %f, \"p50\": %f, \"p90\": %f,"
+		        " \"p99\": %f, \"max\": %f, \"speedup\": ",
+		        r.graph.c_str(), r.threads, r.block_length, r.cycles,
+		        r.mean, r.p50, r.p90, r.p99, r.max);
+		if (s > 0.0) {
+			fprintf(log, "%f}", s);
+		} else {
+			fprintf(log, "null}");
+		}
+		fprintf(log, "%s\n", (i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(log, "]}\n");
 	fclose(log);
 
-	// Shut down
-	world->engine()->deactivate();
+	// Compare median cycle times with baseline
+	int status = EXIT_SUCCESS;
+	if (!baseline_file.empty()) {
+		const auto baseline = read_baseline(baseline_file);
+		for (const auto& r : results) {
+			const auto b = baseline.find(
+				r.graph + "/" + std::to_string(r.threads) + "/" +
+				std::to_string(r.block_length));
+			if (b != baseline.end() &&
+			    r.p50 > b->second.p50 * (100 + tolerance) / 100.0) {
+				fprintf(stderr, "regression: %s with %d threads and %d frames"
+				        " takes %f us, was %f us\n",
+				        r.graph.c_str(), r.threads, r.block_length,
+				        r.p50, b->second.p50);
+				status = EXIT_FAILURE;
+			}
+		}
+	}
 
 	delete world;
-	return EXIT_SUCCESS;
+	return status;
 }
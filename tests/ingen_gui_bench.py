@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+# Ingen GUI Benchmark Graph Generator
+# Copyright 2018 David Robillard <http://drobilla.net>
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted, provided that the above
+# copyright notice and this permission notice appear in all copies.
+#
+# THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+# ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+# WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+# ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+# OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+import argparse
+import os
+import sys
+
+PREFIXES = '''@prefix ingen: <http://drobilla.net/ns/ingen#> .
+@prefix lv2: <http://lv2plug.in/ns/lv2core#> .
+@prefix rdfs: <http://www.w3.org/2000/01/rdf-schema#> .
+'''
+
+def write_manifest(bundle):
+    with open(os.path.join(bundle, 'manifest.ttl'), 'w') as manifest:
+        manifest.write(PREFIXES + '''
+<main.ttl>
+	lv2:prototype ingen:GraphPrototype ;
+	a ingen:Graph ,
+		lv2:Plugin ;
+	rdfs:seeAlso <main.ttl> .
+''')
+
+def write_main(bundle, plugin, size, columns, spacing, embedded):
+    symbols = ['b%d' % i for i in range(size)]
+    with open(os.path.join(bundle, 'main.ttl'), 'w') as main:
+        main.write(PREFIXES + '\n')
+        for i, symbol in enumerate(symbols):
+            x = (i % columns) * spacing
+            y = (i // columns) * spacing
+            main.write('''<%s>
+	ingen:canvasX %.1f ;
+	ingen:canvasY %.1f ;
+	ingen:polyphonic false ;
+	ingen:uiEmbedded %s ;
+	lv2:prototype <%s> ;
+	a ingen:Block .
+
+''' % (symbol, x, y, 'true' if embedded else 'false', plugin))
+
+        main.write('''<>
+	ingen:polyphony 1 ;
+	ingen:block %s ;
+	a ingen:Graph ,
+		lv2:Plugin .
+''' % ' ,\n\t\t'.join('<%s>' % s for s in symbols))
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Write a large graph to time the GUI with.',
+        epilog='Load the result with `ingen -eg --gui-timing BUNDLE` to '
+        'print the time taken to build the canvas, draw the first frame, '
+        'and embed the GUIs of every block that was scrolled into view.')
+    parser.add_argument('bundle', help='graph bundle to write')
+    parser.add_argument('--size', type=int, default=1000,
+                        help='number of blocks (default: 1000)')
+    parser.add_argument('--columns', type=int, default=40,
+                        help='blocks per row of the grid (default: 40)')
+    parser.add_argument('--spacing', type=float, default=400.0,
+                        help='distance between blocks (default: 400)')
+    parser.add_argument('--plugin',
+                        default='http://drobilla.net/ns/ingen-internals#Controller',
+                        help='URI of the plugin to instantiate, which should '
+                        'have an embeddable GUI to time embedding')
+    parser.add_argument('--no-embed', action='store_true',
+                        help='do not embed block GUIs')
+    args = parser.parse_args()
+
+    if args.size < 1 or args.columns < 1:
+        sys.stderr.write('error: size and columns must be positive\n')
+        return 1
+
+    if not os.path.exists(args.bundle):
+        os.makedirs(args.bundle)
+
+    write_manifest(args.bundle)
+    write_main(args.bundle, args.plugin, args.size, args.columns,
+               args.spacing, not args.no_embed)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
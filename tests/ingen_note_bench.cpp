@@ -0,0 +1,213 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "raul/Path.hpp"
+#include "raul/Symbol.hpp"
+
+#include "ingen/Clock.hpp"
+#include "ingen/Configuration.hpp"
+#include "ingen/EngineBase.hpp"
+#include "ingen/Forge.hpp"
+#include "ingen/Interface.hpp"
+#include "ingen/URIs.hpp"
+#include "ingen/World.hpp"
+#include "ingen/paths.hpp"
+#include "ingen/runtime_paths.hpp"
+#include "ingen/types.hpp"
+#include "lv2/midi/midi.h"
+
+#include "ingen_config.h"
+
+using namespace std;
+using namespace ingen;
+
+#define NS_INTERNALS "http://drobilla.net/ns/ingen-internals#"
+
+World* world = nullptr;
+
+static void
+ingen_try(bool cond, const char* msg)
+{
+	if (!cond) {
+		cerr << "ingen: Error: " << msg << endl;
+		delete world;
+		exit(EXIT_FAILURE);
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	set_bundle_path_from_code((void*)&ingen_try);
+
+	// Create world
+	try {
+		world = new World(nullptr, nullptr, nullptr);
+		world->conf().add(
+			"output", "output", 'O', "File to write benchmark output",
+			ingen::Configuration::SESSION, world->forge().String, Atom());
+		world->conf().add(
+			"voices", "voices", 0, "Polyphony of the note block",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(64));
+		world->conf().add(
+			"events", "events", 0, "Number of note events in each cycle",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(64));
+		world->conf().add(
+			"stealing", "stealing", 0,
+			"Voice stealing policy (0 = oldest, 1 = lowest velocity, 2 = same note)",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(0));
+		world->conf().add(
+			"channels", "channels", 0, "Allocate voices for each channel separately",
+			ingen::Configuration::SESSION, world->forge().Bool,
+			world->forge().make(false));
+		world->conf().add(
+			"cycles", "cycles", 0, "Number of cycles to run",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(1000));
+		world->load_configuration(argc, argv);
+	} catch (std::exception& e) {
+		cout << "ingen: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+
+	const Atom& out = world->conf().option("output");
+	if (!out.is_valid()) {
+		cerr << "Usage: ingen_note_bench [--voices N] [--events N] "
+		     << "[--stealing N] [--channels] [--cycles N] --output OUT_FILE"
+		     << endl;
+		return EXIT_FAILURE;
+	}
+
+	const Configuration& conf       = world->conf();
+	const std::string    out_file   = (const char*)out.get_body();
+	const int32_t        n_voices   = conf.option("voices").get<int32_t>();
+	const int32_t        n_events   = conf.option("events").get<int32_t>();
+	const int32_t        stealing   = conf.option("stealing").get<int32_t>();
+	const bool           channels   = conf.option("channels").get<int32_t>();
+	const int32_t        n_cycles   = conf.option("cycles").get<int32_t>();
+	const URIs&          uris       = world->uris();
+	Forge&               forge      = world->forge();
+	ingen_try(n_voices > 0 && n_events > 0 && n_cycles > 0,
+	          "Invalid voice, event, or cycle count");
+
+	// Load modules
+	ingen_try(world->load_module("server"),
+	          "Unable to load server module");
+
+	// Initialise engine
+	ingen_try(bool(world->engine()),
+	          "Unable to create engine");
+	world->engine()->init(48000.0, 512, 4096);
+	world->engine()->activate();
+
+	// Create a polyphonic note block
+	SPtr<Interface>  iface = world->interface();
+	const Raul::Path graph("/voices");
+	const Raul::Path note(graph.child(Raul::Symbol("note")));
+	iface->put(path_to_uri(graph),
+	           {{uris.rdf_type,        uris.ingen_Graph},
+	            {uris.ingen_polyphony, forge.make(n_voices)}});
+	iface->put(path_to_uri(note),
+	           {{uris.rdf_type,         uris.ingen_Block},
+	            {uris.lv2_prototype,    forge.make_urid(URI(NS_INTERNALS "Note"))},
+	            {uris.ingen_polyphonic, forge.make(true)}});
+	iface->set_property(path_to_uri(note.child(Raul::Symbol("stealing"))),
+	                    uris.ingen_value,
+	                    forge.make(float(stealing)));
+	iface->set_property(path_to_uri(note.child(Raul::Symbol("channels"))),
+	                    uris.ingen_value,
+	                    forge.make(channels ? 1.0f : 0.0f));
+	world->engine()->flush_events(std::chrono::milliseconds(0));
+
+	/* Send a dense random stream of note on and off events, keeping about
+	   twice as many keys held as there are voices, so voices are constantly
+	   stolen and reassigned. */
+	typedef std::pair<uint8_t, uint8_t> Key;  // Channel, note
+
+	const URI        input(path_to_uri(note.child(Raul::Symbol("input"))));
+	const size_t     n_held = size_t(n_voices) * 2;
+	std::mt19937     rng(1);
+	std::vector<Key> held;
+	ingen::Clock     clock;
+	uint64_t         run_time = 0;
+	for (int32_t c = 0; c < n_cycles; ++c) {
+		for (int32_t e = 0; e < n_events; ++e) {
+			const bool on = held.empty() ||
+				(held.size() < n_held ? rng() % 3 != 0 : rng() % 3 == 0);
+
+			uint8_t msg[3];
+			if (on) {
+				const Key key(channels ? rng() % 16 : 0, rng() % 128);
+				msg[0] = LV2_MIDI_MSG_NOTE_ON | key.first;
+				msg[1] = key.second;
+				msg[2] = 1 + rng() % 127;
+				held.push_back(key);
+			} else {
+				const size_t i = rng() % held.size();
+				msg[0] = LV2_MIDI_MSG_NOTE_OFF | held[i].first;
+				msg[1] = held[i].second;
+				msg[2] = 0;
+				held[i] = held.back();
+				held.pop_back();
+			}
+			iface->set_property(input,
+			                    uris.ingen_value,
+			                    forge.alloc(sizeof(msg), uris.midi_MidiEvent, msg));
+		}
+
+		const uint64_t t_start = clock.now_microseconds();
+		world->engine()->run(512);
+		run_time += clock.now_microseconds() - t_start;
+
+		world->engine()->advance(512);
+		world->engine()->main_iteration();
+	}
+	world->engine()->flush_events(std::chrono::milliseconds(0));
+
+	// Write log output
+	const uint64_t n_total = uint64_t(n_cycles) * n_events;
+	FILE*          log     = fopen(out_file.c_str(), "a");
+	if (ftell(log) == 0) {
+		fprintf(log, "# n_voices\tstealing\tchannels\tn_events"
+		        "\trun_time\tns_per_event\n");
+	}
+	fprintf(log, "%d\t%d\t%d\t%llu\t%f\t%f\n",
+	        n_voices,
+	        stealing,
+	        int(channels),
+	        (unsigned long long)n_total,
+	        run_time / 1000000.0,
+	        run_time * 1000.0 / n_total);
+	fclose(log);
+
+	// Shut down
+	world->engine()->deactivate();
+
+	delete world;
+	return EXIT_SUCCESS;
+}
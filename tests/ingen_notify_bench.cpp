@@ -0,0 +1,228 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/variant/get.hpp>
+
+#include "raul/Path.hpp"
+#include "raul/Symbol.hpp"
+
+#include "ingen/Clock.hpp"
+#include "ingen/Configuration.hpp"
+#include "ingen/EngineBase.hpp"
+#include "ingen/Forge.hpp"
+#include "ingen/Interface.hpp"
+#include "ingen/Properties.hpp"
+#include "ingen/URIs.hpp"
+#include "ingen/World.hpp"
+#include "ingen/paths.hpp"
+#include "ingen/runtime_paths.hpp"
+#include "ingen/types.hpp"
+
+#include "ingen_config.h"
+
+using namespace std;
+using namespace ingen;
+
+World* world = nullptr;
+
+static void
+ingen_try(bool cond, const char* msg)
+{
+	if (!cond) {
+		cerr << "ingen: Error: " << msg << endl;
+		delete world;
+		exit(EXIT_FAILURE);
+	}
+}
+
+/** A client that counts monitor updates and keeps notification statistics. */
+class NotifyClient : public Interface
+{
+public:
+	URI uri() const override { return URI("ingen:notifyClient"); }
+
+	void message(const Message& msg) override {
+		if (const SetProperty* const set = boost::get<SetProperty>(&msg)) {
+			n_updates += set->predicate == world->uris().ingen_value;
+		} else if (const Put* const put = boost::get<Put>(&msg)) {
+			if (put->uri.string().find("ingen:/engine/notifications/") == 0) {
+				max_length = std::max(
+					max_length, get(put->properties, world->uris().ingen_maxQueueLength));
+				n_dropped += get(put->properties,
+				                 world->uris().ingen_droppedMessages);
+			}
+		}
+	}
+
+	uint64_t n_updates  = 0;
+	int32_t  max_length = 0;
+	int32_t  n_dropped  = 0;
+
+private:
+	static int32_t get(const Properties& props, const URI& key) {
+		const auto p = props.find(key);
+		return (p != props.end() && p->second.type() == world->forge().Int)
+			? p->second.get<int32_t>()
+			: 0;
+	}
+};
+
+/** Return the properties of a control port on a graph. */
+static Properties
+port_properties(const URIs& uris, Forge& forge, bool output, int32_t index)
+{
+	return Properties{
+		{uris.rdf_type,    output ? uris.lv2_OutputPort : uris.lv2_InputPort},
+		{uris.rdf_type,    uris.lv2_ControlPort},
+		{uris.lv2_index,   forge.make(index)},
+		{uris.ingen_value, forge.make(0.0f)}};
+}
+
+int
+main(int argc, char** argv)
+{
+	set_bundle_path_from_code((void*)&ingen_try);
+
+	// Create world
+	try {
+		world = new World(nullptr, nullptr, nullptr);
+		world->conf().add(
+			"output", "output", 'O', "File to write benchmark output",
+			ingen::Configuration::SESSION, world->forge().String, Atom());
+		world->conf().add(
+			"graphs", "graphs", 0, "Number of subgraphs",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(16));
+		world->conf().add(
+			"ports", "ports", 0, "Number of monitored ports on each subgraph",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(16));
+		world->conf().add(
+			"cycles", "cycles", 0, "Number of cycles to run",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(1000));
+		world->load_configuration(argc, argv);
+	} catch (std::exception& e) {
+		cout << "ingen: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+
+	const Atom& out = world->conf().option("output");
+	if (!out.is_valid()) {
+		cerr << "Usage: ingen_notify_bench [--threads N] [--graphs N] "
+		     << "[--ports N] [--cycles N] --output OUT_FILE" << endl;
+		return EXIT_FAILURE;
+	}
+
+	const Configuration& conf      = world->conf();
+	const std::string    out_file  = (const char*)out.get_body();
+	const int32_t        n_threads = conf.option("threads").get<int32_t>();
+	const int32_t        n_graphs  = conf.option("graphs").get<int32_t>();
+	const int32_t        n_ports   = conf.option("ports").get<int32_t>();
+	const int32_t        n_cycles  = conf.option("cycles").get<int32_t>();
+	const URIs&          uris      = world->uris();
+	Forge&               forge     = world->forge();
+	ingen_try(n_graphs > 0 && n_ports > 0 && n_cycles > 0,
+	          "Invalid graph, port, or cycle count");
+
+	// Load modules
+	ingen_try(world->load_module("server"),
+	          "Unable to load server module");
+
+	// Initialise engine
+	ingen_try(bool(world->engine()),
+	          "Unable to create engine");
+	world->engine()->init(48000.0, 512, 4096);
+	world->engine()->activate();
+
+	// Register a client that receives all monitor updates
+	SPtr<Interface>    iface = world->interface();
+	SPtr<NotifyClient> client(new NotifyClient());
+	iface->set_respondee(client);
+	world->engine()->register_client(client);
+	iface->set_property(URI("ingen:/clients/this"),
+	                    uris.ingen_broadcast,
+	                    forge.make(true));
+
+	/* Create independent subgraphs, which are run in parallel, that pass
+	   every input through to an output so both are monitored. */
+	std::vector<URI> inputs;
+	for (int32_t g = 0; g < n_graphs; ++g) {
+		const Raul::Path graph("/g" + std::to_string(g));
+		iface->put(path_to_uri(graph), {{uris.rdf_type, uris.ingen_Graph}});
+		for (int32_t p = 0; p < n_ports; ++p) {
+			const Raul::Path in(graph.child(Raul::Symbol("in" + std::to_string(p))));
+			const Raul::Path out(graph.child(Raul::Symbol("out" + std::to_string(p))));
+			iface->put(path_to_uri(in),
+			           port_properties(uris, forge, false, p * 2));
+			iface->put(path_to_uri(out),
+			           port_properties(uris, forge, true, p * 2 + 1));
+			iface->connect(in, out);
+			inputs.emplace_back(path_to_uri(in));
+		}
+	}
+	world->engine()->flush_events(std::chrono::milliseconds(0));
+
+	// Change every input in every cycle, so every port notifies every cycle
+	ingen::Clock   clock;
+	const uint64_t t_start = clock.now_microseconds();
+	for (int32_t c = 0; c < n_cycles; ++c) {
+		for (const auto& input : inputs) {
+			iface->set_property(input, uris.ingen_value, forge.make(float(c)));
+		}
+		world->engine()->advance(512);
+		world->engine()->run(512);
+		world->engine()->main_iteration();
+	}
+	world->engine()->flush_events(std::chrono::milliseconds(0));
+	const uint64_t elapsed = clock.now_microseconds() - t_start;
+
+	// Get notification ring statistics from the engine
+	iface->get(URI("ingen:/engine"));
+	world->engine()->flush_events(std::chrono::milliseconds(0));
+	world->engine()->unregister_client(client);
+	iface->set_respondee(SPtr<Interface>());
+
+	// Write log output
+	FILE* log = fopen(out_file.c_str(), "a");
+	if (ftell(log) == 0) {
+		fprintf(log, "# n_threads\tn_ports\tn_cycles\tn_updates"
+		        "\tupdates_per_second\tmax_ring_length\tn_dropped\n");
+	}
+	fprintf(log, "%d\t%zu\t%d\t%llu\t%f\t%d\t%d\n",
+	        n_threads,
+	        inputs.size() * 2,
+	        n_cycles,
+	        (unsigned long long)client->n_updates,
+	        client->n_updates / (elapsed / 1000000.0),
+	        client->max_length,
+	        client->n_dropped);
+	fclose(log);
+
+	// Shut down
+	world->engine()->deactivate();
+
+	delete world;
+	return EXIT_SUCCESS;
+}
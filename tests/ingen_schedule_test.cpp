@@ -0,0 +1,193 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <boost/variant/get.hpp>
+
+#include "raul/Path.hpp"
+#include "raul/Symbol.hpp"
+
+#include "ingen/EngineBase.hpp"
+#include "ingen/Forge.hpp"
+#include "ingen/Interface.hpp"
+#include "ingen/Log.hpp"
+#include "ingen/URIs.hpp"
+#include "ingen/World.hpp"
+#include "ingen/paths.hpp"
+#include "ingen/runtime_paths.hpp"
+#include "ingen/types.hpp"
+
+using namespace std;
+using namespace ingen;
+
+World* world = nullptr;
+
+static void
+ingen_try(bool cond, const char* msg)
+{
+	if (!cond) {
+		cerr << "ingen: Error: " << msg << endl;
+		delete world;
+		exit(EXIT_FAILURE);
+	}
+}
+
+/** Records the cycle in which the response to each request arrives. */
+class Recorder : public ingen::Interface
+{
+public:
+	explicit Recorder(Log& log) : cycle(0), _log(log) {}
+
+	URI uri() const override { return URI("ingen:testClient"); }
+
+	void message(const Message& msg) override {
+		if (const Response* const response = boost::get<Response>(&msg)) {
+			if (response->status != Status::SUCCESS) {
+				_log.error(fmt("error on message %1%: %2% (%3%)\n")
+				           % response->id
+				           % ingen_status_string(response->status)
+				           % response->subject);
+				exit(EXIT_FAILURE);
+			}
+
+			// Creating an object responds twice, only record the first
+			if (cycles.emplace(response->id, cycle).second) {
+				order.push_back(response->id);
+			}
+		}
+	}
+
+	uint32_t                    cycle;   ///< Index of the current cycle
+	std::vector<int32_t>        order;   ///< Request IDs in response order
+	std::map<int32_t, uint32_t> cycles;  ///< Cycle of response by request ID
+
+private:
+	Log& _log;
+};
+
+static void
+check_cycle(const Recorder& recorder, int32_t id, uint32_t min, uint32_t max)
+{
+	const auto c = recorder.cycles.find(id);
+	if (c == recorder.cycles.end()) {
+		cerr << "error: no response to message " << id << endl;
+		exit(EXIT_FAILURE);
+	} else if (c->second < min || c->second > max) {
+		cerr << "error: message " << id << " executed in cycle " << c->second
+		     << ", expected " << min << " to " << max << endl;
+		exit(EXIT_FAILURE);
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	set_bundle_path_from_code((void*)&ingen_try);
+
+	// Create world
+	try {
+		world = new World(nullptr, nullptr, nullptr);
+		world->load_configuration(argc, argv);
+	} catch (std::exception& e) {
+		cout << "ingen: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+
+	// Load modules
+	ingen_try(world->load_module("server"),
+	          "Unable to load server module");
+
+	// Initialise engine with short cycles so times are checked precisely
+	const uint32_t block_length = 64;
+	ingen_try(bool(world->engine()),
+	          "Unable to create engine");
+	world->engine()->init(48000.0, block_length, 4096);
+	world->engine()->activate();
+
+	SPtr<Recorder> recorder(new Recorder(world->log()));
+	world->interface()->set_respondee(recorder);
+
+	// Create a graph with a control input
+	SPtr<Interface>  iface = world->interface();
+	const URIs&      uris  = world->uris();
+	Forge&           forge = world->forge();
+	const Raul::Path graph("/test");
+	const URI        in(path_to_uri(graph.child(Raul::Symbol("in"))));
+	const URI        out(path_to_uri(graph.child(Raul::Symbol("out"))));
+	iface->put(path_to_uri(graph), {{uris.rdf_type, uris.ingen_Graph}});
+	iface->put(in, {{uris.rdf_type, uris.lv2_InputPort},
+	                {uris.rdf_type, uris.lv2_ControlPort}});
+	world->engine()->flush_events(std::chrono::milliseconds(20));
+
+	// Start at a known time, well after the cycles run to create the graph
+	const uint32_t start = 1 << 16;
+	world->engine()->locate(start, block_length);
+
+	/* Set a value for a later time, then an earlier one, then send requests
+	   that are unrelated to the port, or do not change it, which must not
+	   wait for the scheduled change, and finally one that must. */
+	iface->message(SetProperty{1, in, uris.ingen_value, forge.make(0.5f),
+	                           Resource::Graph::DEFAULT, start + 10000});
+	iface->message(SetProperty{2, in, uris.ingen_value, forge.make(0.25f),
+	                           Resource::Graph::DEFAULT, start + 1});
+	iface->message(Get{3, in, false});
+	iface->message(Put{4, out, {{uris.rdf_type, uris.lv2_InputPort},
+	                            {uris.rdf_type, uris.lv2_ControlPort}},
+	                   Resource::Graph::DEFAULT, 0});
+	iface->message(SetProperty{5, in, uris.ingen_canvasX, forge.make(1.0f),
+	                           Resource::Graph::DEFAULT, 0});
+
+	// Give the pre-processor time to prepare every request
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	// Run enough cycles to pass the scheduled time
+	const uint32_t value_cycle = 10000 / block_length;
+	for (uint32_t c = 0; c <= value_cycle + 2; ++c) {
+		recorder->cycle = c;
+		world->engine()->run(block_length);
+		world->engine()->main_iteration();
+		world->engine()->advance(block_length);
+	}
+
+	// The earlier value is applied in the first cycle, the later one on time
+	check_cycle(*recorder, 2, 0, 0);
+	check_cycle(*recorder, 1, value_cycle, value_cycle);
+
+	// Requests that do not touch the scheduled port are not held back
+	check_cycle(*recorder, 3, 0, 1);
+	check_cycle(*recorder, 4, 0, 1);
+
+	// A later change to the same port waits for the scheduled value
+	check_cycle(*recorder, 5, value_cycle, value_cycle);
+	const std::vector<int32_t> expected_order{2, 3, 4, 1, 5};
+	if (recorder->order != expected_order) {
+		cerr << "error: responses received out of order" << endl;
+		return EXIT_FAILURE;
+	}
+
+	// Shut down
+	world->engine()->deactivate();
+
+	delete world;
+	return EXIT_SUCCESS;
+}
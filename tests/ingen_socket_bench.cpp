@@ -0,0 +1,303 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/variant/get.hpp>
+
+#include "ingen/Clock.hpp"
+#include "ingen/Configuration.hpp"
+#include "ingen/EngineBase.hpp"
+#include "ingen/Forge.hpp"
+#include "ingen/Interface.hpp"
+#include "ingen/Properties.hpp"
+#include "ingen/SocketReader.hpp"
+#include "ingen/SocketWriter.hpp"
+#include "ingen/URIs.hpp"
+#include "ingen/World.hpp"
+#include "ingen/paths.hpp"
+#include "ingen/runtime_paths.hpp"
+#include "ingen/types.hpp"
+#include "raul/Socket.hpp"
+
+#include "ingen_config.h"
+
+using namespace std;
+using namespace ingen;
+
+World* world = nullptr;
+
+static void
+ingen_try(bool cond, const char* msg)
+{
+	if (!cond) {
+		cerr << "ingen: Error: " << msg << endl;
+		delete world;
+		exit(EXIT_FAILURE);
+	}
+}
+
+/** A client that sends requests and records the round trip time of each. */
+class BenchClient : public Interface
+{
+public:
+	BenchClient() : _n_received(0), _n_failed(0) {}
+
+	URI uri() const override { return URI("ingen:benchClient"); }
+
+	void message(const Message& msg) override {
+		if (const Response* const response = boost::get<Response>(&msg)) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (response->status != Status::SUCCESS) {
+				++_n_failed;
+			}
+			++_n_received;
+			_cond.notify_one();
+		}
+	}
+
+	/** Wait until `n` responses have been received, or a timeout. */
+	bool wait_for(uint32_t n) {
+		std::unique_lock<std::mutex> lock(_mutex);
+		return _cond.wait_for(lock, std::chrono::seconds(10), [this, n] {
+			return _n_received >= n;
+		});
+	}
+
+	uint32_t n_failed() const { return _n_failed; }
+
+private:
+	std::mutex              _mutex;
+	std::condition_variable _cond;
+	uint32_t                _n_received;
+	uint32_t                _n_failed;
+};
+
+/** A client that keeps the event latency statistics sent by the engine. */
+class LatencyClient : public Interface
+{
+public:
+	URI uri() const override { return URI("ingen:latencyClient"); }
+
+	void message(const Message& msg) override {
+		if (const Put* const put = boost::get<Put>(&msg)) {
+			if (uri_is_engine(put->uri)) {
+				latencies[put->uri.string()] = put->properties;
+			}
+		}
+	}
+
+	/** Return a latency in microseconds, or -1 if it was not received. */
+	int32_t latency(const std::string& stage, const URI& key) const {
+		const auto l = latencies.find(
+			engine_uri().string() + "/latency/" + stage);
+		if (l != latencies.end()) {
+			const auto p = l->second.find(key);
+			if (p != l->second.end() && p->second.type() == world->forge().Int) {
+				return p->second.get<int32_t>();
+			}
+		}
+		return -1;
+	}
+
+	std::map<std::string, Properties> latencies;
+};
+
+struct ClientResult
+{
+	ClientResult() : n_sent(0), n_failed(0), max_latency(0), total_latency(0) {}
+
+	uint32_t n_sent;
+	uint32_t n_failed;
+	uint64_t max_latency;    ///< Maximum round trip time in microseconds
+	uint64_t total_latency;  ///< Sum of round trip times in microseconds
+};
+
+static void
+run_client(const URI& uri, uint32_t n_messages, ClientResult* result)
+{
+	SPtr<Raul::Socket> sock(new Raul::Socket(Raul::Socket::Type::UNIX));
+	if (!sock->connect(uri)) {
+		cerr << "error: failed to connect to " << uri << endl;
+		return;
+	}
+
+	SPtr<BenchClient> client(new BenchClient());
+	SocketWriter      writer(world->uri_map(), world->uris(), uri, sock);
+	SocketReader      reader(*world, *client, sock);
+
+	// Send requests one at a time, so each round trip is measured separately
+	ingen::Clock clock;
+	writer.set_response_id(1);
+	for (uint32_t i = 1; i <= n_messages; ++i) {
+		const uint64_t t_send = clock.now_microseconds();
+		writer.get(URI("ingen:/engine"));
+		if (!client->wait_for(i)) {
+			cerr << "error: timeout waiting for response " << i << endl;
+			break;
+		}
+
+		const uint64_t latency = clock.now_microseconds() - t_send;
+		result->max_latency    = std::max(result->max_latency, latency);
+		result->total_latency += latency;
+		++result->n_sent;
+	}
+
+	result->n_failed = client->n_failed();
+}
+
+int
+main(int argc, char** argv)
+{
+	set_bundle_path_from_code((void*)&ingen_try);
+
+	// Create world
+	try {
+		world = new World(nullptr, nullptr, nullptr);
+		world->conf().add(
+			"output", "output", 'O', "File to write benchmark output",
+			ingen::Configuration::SESSION, world->forge().String, Atom());
+		world->conf().add(
+			"clients", "clients", 0, "Number of concurrent clients",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(32));
+		world->conf().add(
+			"messages", "messages", 0, "Number of requests per client",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(1000));
+		world->load_configuration(argc, argv);
+	} catch (std::exception& e) {
+		cout << "ingen: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+
+	// Get mandatory command line arguments
+	const Atom& out = world->conf().option("output");
+	if (!out.is_valid()) {
+		cerr << "Usage: ingen_socket_bench [--clients N] [--messages N] "
+		     << "--output OUT_FILE" << endl;
+		return EXIT_FAILURE;
+	}
+
+	const std::string out_file   = (const char*)out.get_body();
+	const uint32_t    n_clients  = world->conf().option("clients").get<int32_t>();
+	const uint32_t    n_messages = world->conf().option("messages").get<int32_t>();
+	const URI         uri(std::string("unix://") +
+	                      world->conf().option("socket").ptr<char>());
+
+	// Load modules
+	ingen_try(world->load_module("server"),
+	          "Unable to load server module");
+
+	// Initialise engine and listen for connections
+	ingen_try(bool(world->engine()),
+	          "Unable to create engine");
+	world->engine()->init(48000.0, 512, 4096);
+	world->engine()->activate();
+	world->engine()->listen();
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	// Start clients
+	ingen::Clock              clock;
+	std::vector<ClientResult> results(n_clients);
+	std::vector<std::thread>  threads;
+	std::atomic<uint32_t>     n_finished(0);
+	const uint64_t            t_start = clock.now_microseconds();
+	for (uint32_t i = 0; i < n_clients; ++i) {
+		threads.emplace_back([&, i] {
+			run_client(uri, n_messages, &results[i]);
+			++n_finished;
+		});
+	}
+
+	// Run engine until all clients are finished
+	while (n_finished < n_clients) {
+		world->engine()->advance(512);
+		world->engine()->run(512);
+		world->engine()->main_iteration();
+		std::this_thread::sleep_for(std::chrono::microseconds(500));
+	}
+	const uint64_t t_end = clock.now_microseconds();
+
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	// Collect results
+	uint32_t n_sent        = 0;
+	uint32_t n_failed      = 0;
+	uint64_t max_latency   = 0;
+	uint64_t total_latency = 0;
+	for (const auto& r : results) {
+		n_sent        += r.n_sent;
+		n_failed      += r.n_failed;
+		max_latency    = std::max(max_latency, r.max_latency);
+		total_latency += r.total_latency;
+	}
+
+	// Get event latency statistics from the engine
+	const URIs&         uris  = world->uris();
+	SPtr<Interface>     iface = world->interface();
+	SPtr<LatencyClient> latency_client(new LatencyClient());
+	iface->set_respondee(latency_client);
+	world->engine()->register_client(latency_client);
+	iface->get(engine_uri());
+	world->engine()->flush_events(std::chrono::milliseconds(20));
+	world->engine()->unregister_client(latency_client);
+	iface->set_respondee(SPtr<Interface>());
+
+	const double elapsed = (t_end - t_start) / 1000000.0;
+	const double rate    = n_sent / elapsed;
+	const double mean    = n_sent ? total_latency / double(n_sent) : 0.0;
+
+	// Write log output
+	FILE* log = fopen(out_file.c_str(), "a");
+	if (ftell(log) == 0) {
+		fprintf(log, "# n_clients\tn_messages\tthroughput\tmean_latency"
+		        "\tmax_latency\tmedian_exec_us\ttail_exec_us\tmax_exec_us"
+		        "\tmax_reply_us\n");
+	}
+	fprintf(log, "%u\t%u\t%f\t%f\t%f\t%d\t%d\t%d\t%d\n",
+	        n_clients, n_sent, rate, mean / 1000.0, max_latency / 1000.0,
+	        latency_client->latency("executed", uris.ingen_medianLatency),
+	        latency_client->latency("executed", uris.ingen_tailLatency),
+	        latency_client->latency("executed", uris.ingen_maxLatency),
+	        latency_client->latency("post_processed", uris.ingen_maxLatency));
+	fclose(log);
+
+	// Shut down
+	world->engine()->deactivate();
+
+	delete world;
+
+	if (n_sent != n_clients * n_messages || n_failed) {
+		cerr << "error: " << n_sent << " of " << n_clients * n_messages
+		     << " requests completed, " << n_failed << " failed" << endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,226 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "raul/Path.hpp"
+#include "raul/Symbol.hpp"
+
+#include "ingen/Clock.hpp"
+#include "ingen/Configuration.hpp"
+#include "ingen/Forge.hpp"
+#include "ingen/Node.hpp"
+#include "ingen/Store.hpp"
+#include "ingen/World.hpp"
+#include "ingen/runtime_paths.hpp"
+#include "ingen/types.hpp"
+
+#include "ingen_config.h"
+
+using namespace std;
+using namespace ingen;
+
+World* world = nullptr;
+
+static void
+ingen_try(bool cond, const char* msg)
+{
+	if (!cond) {
+		cerr << "ingen: Error: " << msg << endl;
+		delete world;
+		exit(EXIT_FAILURE);
+	}
+}
+
+/** A minimal node that only has a path. */
+class BenchNode : public Node
+{
+public:
+	BenchNode(const URIs& uris, const Raul::Path& path, GraphType type)
+		: Node(uris, path)
+		, _path(path)
+		, _symbol(Raul::Symbol(path.symbol()))
+		, _type(type)
+	{}
+
+	GraphType           graph_type()   const override { return _type; }
+	const Raul::Path&   path()         const override { return _path; }
+	const Raul::Symbol& symbol()       const override { return _symbol; }
+	Node*               graph_parent() const override { return nullptr; }
+
+protected:
+	void set_path(const Raul::Path& p) override {
+		_path   = p;
+		_symbol = Raul::Symbol(p.symbol());
+	}
+
+private:
+	Raul::Path   _path;
+	Raul::Symbol _symbol;
+	GraphType    _type;
+};
+
+static double
+seconds_since(const ingen::Clock& clock, uint64_t start)
+{
+	return (clock.now_microseconds() - start) / 1000000.0;
+}
+
+int
+main(int argc, char** argv)
+{
+	set_bundle_path_from_code((void*)&ingen_try);
+
+	// Create world
+	try {
+		world = new World(nullptr, nullptr, nullptr);
+		world->conf().add(
+			"output", "output", 'O', "File to write benchmark output",
+			ingen::Configuration::SESSION, world->forge().String, Atom());
+		world->conf().add(
+			"graphs", "graphs", 0, "Number of subgraphs",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(100));
+		world->conf().add(
+			"blocks", "blocks", 0, "Number of blocks in each subgraph",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(40));
+		world->conf().add(
+			"ports", "ports", 0, "Number of ports on each block",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(4));
+		world->load_configuration(argc, argv);
+	} catch (std::exception& e) {
+		cout << "ingen: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+
+	const Atom& out = world->conf().option("output");
+	if (!out.is_valid()) {
+		cerr << "Usage: ingen_store_bench [--graphs N] [--blocks N] "
+		     << "[--ports N] --output OUT_FILE" << endl;
+		return EXIT_FAILURE;
+	}
+
+	const Configuration& conf     = world->conf();
+	const std::string    out_file = (const char*)out.get_body();
+	const int32_t        n_graphs = conf.option("graphs").get<int32_t>();
+	const int32_t        n_blocks = conf.option("blocks").get<int32_t>();
+	const int32_t        n_ports  = conf.option("ports").get<int32_t>();
+	const URIs&          uris     = world->uris();
+	ingen_try(n_graphs > 0 && n_blocks >= 0 && n_ports >= 0,
+	          "Invalid object counts");
+
+	// Make the objects of a graph like a large session
+	std::vector<SPtr<Node>> nodes;
+	for (int32_t g = 0; g < n_graphs; ++g) {
+		const Raul::Path graph("/g" + std::to_string(g));
+		nodes.emplace_back(
+			new BenchNode(uris, graph, Node::GraphType::GRAPH));
+		for (int32_t b = 0; b < n_blocks; ++b) {
+			const Raul::Path block(
+				graph.child(Raul::Symbol("b" + std::to_string(b))));
+			nodes.emplace_back(
+				new BenchNode(uris, block, Node::GraphType::BLOCK));
+			for (int32_t p = 0; p < n_ports; ++p) {
+				nodes.emplace_back(new BenchNode(
+					uris,
+					block.child(Raul::Symbol("p" + std::to_string(p))),
+					Node::GraphType::PORT));
+			}
+		}
+	}
+
+	ingen::Clock clock;
+	uint64_t     t_start = 0;
+
+	// Insert into a plain map and the store
+	t_start = clock.now_microseconds();
+	Store::Objects map;
+	for (const auto& n : nodes) {
+		map.emplace(n->path(), n);
+	}
+	const double map_insert = seconds_since(clock, t_start);
+
+	t_start = clock.now_microseconds();
+	Store store;
+	for (const auto& n : nodes) {
+		store.add_node(n);
+	}
+	const double store_insert = seconds_since(clock, t_start);
+
+	// Look up every object
+	size_t n_found = 0;
+	t_start = clock.now_microseconds();
+	for (const auto& n : nodes) {
+		n_found += map.find(n->path()) != map.end();
+	}
+	const double map_find = seconds_since(clock, t_start);
+
+	t_start = clock.now_microseconds();
+	for (const auto& n : nodes) {
+		n_found += store.find(n->path()) != store.end();
+	}
+	const double store_find = seconds_since(clock, t_start);
+	ingen_try(n_found == nodes.size() * 2, "Objects missing from store");
+
+	// Iterate over the descendants of every graph
+	size_t n_children = 0;
+	t_start = clock.now_microseconds();
+	for (int32_t g = 0; g < n_graphs; ++g) {
+		const auto i = store.find(Raul::Path("/g" + std::to_string(g)));
+		n_children += std::distance(i, store.find_descendants_end(i));
+	}
+	const double store_children = seconds_since(clock, t_start);
+	ingen_try(n_children == nodes.size(), "Descendants missing from store");
+
+	// Rename every graph, which moves all its descendants
+	t_start = clock.now_microseconds();
+	for (int32_t g = 0; g < n_graphs; ++g) {
+		store.rename(store.find(Raul::Path("/g" + std::to_string(g))),
+		             Raul::Path("/h" + std::to_string(g)));
+	}
+	const double store_rename = seconds_since(clock, t_start);
+	ingen_try(store.size() == nodes.size(), "Objects lost in rename");
+	for (const auto& n : nodes) {
+		ingen_try(store.find(n->path()) != store.end(),
+		          "Renamed object missing from store");
+	}
+
+	// Write log output
+	FILE* log = fopen(out_file.c_str(), "a");
+	if (ftell(log) == 0) {
+		fprintf(log, "# n_objects\tmap_insert\tstore_insert\tmap_find"
+		        "\tstore_find\tstore_children\tstore_rename\n");
+	}
+	fprintf(log, "%zu\t%f\t%f\t%f\t%f\t%f\t%f\n",
+	        nodes.size(),
+	        map_insert,
+	        store_insert,
+	        map_find,
+	        store_find,
+	        store_children,
+	        store_rename);
+	fclose(log);
+
+	store.clear();
+	delete world;
+	return EXIT_SUCCESS;
+}
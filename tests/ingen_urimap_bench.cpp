@@ -0,0 +1,171 @@
+/*
+  This file is part of Ingen.
+  Copyright 2007-2018 David Robillard <http://drobilla.net/>
+
+  Ingen is free software: you can redistribute it and/or modify it under the
+  terms of the GNU Affero General Public License as published by the Free
+  Software Foundation, either version 3 of the License, or any later version.
+
+  Ingen is distributed in the hope that it will be useful, but WITHOUT ANY
+  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+  A PARTICULAR PURPOSE.  See the GNU Affero General Public License for details.
+
+  You should have received a copy of the GNU Affero General Public License
+  along with Ingen.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ingen/Clock.hpp"
+#include "ingen/Configuration.hpp"
+#include "ingen/Forge.hpp"
+#include "ingen/URIMap.hpp"
+#include "ingen/World.hpp"
+#include "ingen/runtime_paths.hpp"
+
+#include "ingen_config.h"
+
+using namespace std;
+using namespace ingen;
+
+World* world = nullptr;
+
+static void
+ingen_try(bool cond, const char* msg)
+{
+	if (!cond) {
+		cerr << "ingen: Error: " << msg << endl;
+		delete world;
+		exit(EXIT_FAILURE);
+	}
+}
+
+/** Map and unmap a mix of known and new URIs, and count mismatches. */
+static void
+run_thread(URIMap&                         map,
+           const std::vector<std::string>& known,
+           unsigned                        thread,
+           int32_t                         n_ops,
+           int32_t                         new_percent,
+           std::atomic<unsigned>&          n_errors)
+{
+	LV2_URID_Map*   lmap   = &map.urid_map_feature()->urid_map;
+	LV2_URID_Unmap* lunmap = &map.urid_unmap_feature()->urid_unmap;
+
+	unsigned errors = 0;
+	uint32_t seed   = thread + 1;
+	for (int32_t i = 0; i < n_ops; ++i) {
+		seed = seed * 1103515245u + 12345u;
+
+		std::string uri;
+		if ((int32_t)((seed >> 8) % 100) < new_percent) {
+			uri = "http://example.org/bench/" + std::to_string(thread) + "/" +
+			      std::to_string(i);
+		} else {
+			uri = known[(seed >> 8) % known.size()];
+		}
+
+		const LV2_URID urid   = lmap->map(lmap->handle, uri.c_str());
+		const char*    mapped = lunmap->unmap(lunmap->handle, urid);
+		if (!urid || !mapped || strcmp(mapped, uri.c_str())) {
+			++errors;
+		}
+	}
+
+	n_errors += errors;
+}
+
+int
+main(int argc, char** argv)
+{
+	set_bundle_path_from_code((void*)&ingen_try);
+
+	// Create world
+	try {
+		world = new World(nullptr, nullptr, nullptr);
+		world->conf().add(
+			"output", "output", 'O', "File to write benchmark output",
+			ingen::Configuration::SESSION, world->forge().String, Atom());
+		world->conf().add(
+			"threads", "threads", 0, "Number of mapping threads",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(8));
+		world->conf().add(
+			"operations", "operations", 0, "Number of mappings per thread",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(1000000));
+		world->conf().add(
+			"new-percent", "new-percent", 0, "Percentage of new URIs",
+			ingen::Configuration::SESSION, world->forge().Int,
+			world->forge().make(1));
+		world->load_configuration(argc, argv);
+	} catch (std::exception& e) {
+		cout << "ingen: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+
+	const Atom& out = world->conf().option("output");
+	if (!out.is_valid()) {
+		cerr << "Usage: ingen_urimap_bench [--threads N] [--operations N] "
+		     << "[--new-percent N] --output OUT_FILE" << endl;
+		return EXIT_FAILURE;
+	}
+
+	const Configuration& conf        = world->conf();
+	const std::string    out_file    = (const char*)out.get_body();
+	const int32_t        n_threads   = conf.option("threads").get<int32_t>();
+	const int32_t        n_ops       = conf.option("operations").get<int32_t>();
+	const int32_t        new_percent = conf.option("new-percent").get<int32_t>();
+	ingen_try(n_threads > 0 && n_ops > 0, "Invalid thread or operation count");
+
+	// Map a set of known URIs, like those the engine and plugins share
+	URIMap&                  map = world->uri_map();
+	std::vector<std::string> known;
+	for (unsigned i = 0; i < 1024; ++i) {
+		known.push_back("http://example.org/known/" + std::to_string(i));
+		map.map_uri(known.back());
+	}
+
+	// Run all threads at once
+	std::atomic<unsigned>    n_errors(0);
+	std::vector<std::thread> threads;
+	ingen::Clock             clock;
+	const uint64_t           t_start = clock.now_microseconds();
+	for (int32_t t = 0; t < n_threads; ++t) {
+		threads.emplace_back(run_thread,
+		                     std::ref(map),
+		                     std::cref(known),
+		                     (unsigned)t,
+		                     n_ops,
+		                     new_percent,
+		                     std::ref(n_errors));
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	const uint64_t t_end = clock.now_microseconds();
+	ingen_try(n_errors == 0, "Mapped URI does not round-trip");
+
+	// Write log output
+	const double seconds = (t_end - t_start) / 1000000.0;
+	FILE*        log     = fopen(out_file.c_str(), "a");
+	if (ftell(log) == 0) {
+		fprintf(log, "# n_threads\tnew_percent\ttime\tops_per_second\n");
+	}
+	fprintf(log, "%d\t%d\t%f\t%f\n",
+	        n_threads,
+	        new_percent,
+	        seconds,
+	        (double)n_threads * n_ops / seconds);
+	fclose(log);
+
+	delete world;
+	return EXIT_SUCCESS;
+}